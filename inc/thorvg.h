@@ -2,6 +2,7 @@
 #define _THORVG_H_
 
 #include <memory>
+#include <string>
 
 #ifdef TVG_BUILD
     #define TVG_EXPORT __attribute__ ((visibility ("default")))
@@ -35,7 +36,8 @@ protected: \
 #define _TVG_DECLARE_ACCESSOR() \
     friend Canvas; \
     friend Scene; \
-    friend Picture
+    friend Picture; \
+    friend Saver
 
 #define _TVG_DECALRE_IDENTIFIER() \
     auto id() const { return _id; } \
@@ -49,6 +51,7 @@ class RenderMethod;
 class Scene;
 class Picture;
 class Canvas;
+class Saver;
 
 
 enum class TVG_EXPORT Result { Success = 0, InvalidArguments, InsufficientCondition, FailedAllocation, MemoryCorruption, NonSupport, Unknown };
@@ -57,7 +60,8 @@ enum class TVG_EXPORT StrokeCap { Square = 0, Round, Butt };
 enum class TVG_EXPORT StrokeJoin { Bevel = 0, Round, Miter };
 enum class TVG_EXPORT FillSpread { Pad = 0, Reflect, Repeat };
 enum class TVG_EXPORT FillRule { Winding = 0, EvenOdd };
-enum class TVG_EXPORT CompositeMethod { None = 0, ClipPath };
+enum class TVG_EXPORT CompositeMethod { None = 0, ClipPath, AlphaMask, InvAlphaMask };
+enum class TVG_EXPORT FilterMethod { Nearest = 0, Bilinear, Mipmap };
 enum class TVG_EXPORT CanvasEngine { Sw = (1 << 1), Gl = (1 << 2)};
 
 
@@ -96,11 +100,31 @@ public:
     Result opacity(uint8_t o) noexcept;
     Paint* duplicate() const noexcept;
 
+    /**
+     * @brief Composites the paint with the @p target.
+     *
+     * ClipPath clips the paint to the fill of the @p target.
+     * AlphaMask and InvAlphaMask draw the paint offscreen and blend it with the alpha, or the inverse alpha, of the @p target.
+     */
     Result composite(std::unique_ptr<Paint> target, CompositeMethod method) const noexcept;
 
+    /**
+     * @brief Hints that the paint rarely changes, so the engine keeps its drawing as a bitmap and blends it again until anything in it changes.
+     *
+     * Changing the opacity or moving the paint by a translation reuses the bitmap, the moves are snapped to the whole pixels.
+     * The bitmaps share the memory budget of the engine and the least recently drawn ones are dropped first.
+     *
+     * @param[in] hint @c true to keep the drawing, @c false to draw the paint directly.
+     *
+     * @see SwCanvas::cacheBudget()
+     */
+    Result cache(bool hint) noexcept;
+
     uint8_t opacity() const noexcept;
+    bool cache() const noexcept;
 
     _TVG_DECLARE_ACCESSOR();
+    _TVG_DECALRE_IDENTIFIER();
     _TVG_DECLARE_PRIVATE(Paint);
 };
 
@@ -154,9 +178,38 @@ public:
     virtual Result push(std::unique_ptr<Paint> paint) noexcept;
     virtual Result clear(bool free = true) noexcept;
     virtual Result update(Paint* paint) noexcept;
+
+    /**
+     * @brief Requests the drawing of the paints on the target.
+     *
+     * The drawing might run on the worker threads, the function returns without waiting for it.
+     * The paints and the target must not be changed until sync() is called.
+     */
     virtual Result draw() noexcept;
+
+    /**
+     * @brief Waits for the drawing requested by draw() to be completed.
+     *
+     * @return Result::InsufficientCondition if the drawing has failed.
+     */
     virtual Result sync() noexcept;
 
+    /**
+     * @brief Sets the area of the scene drawn on the target.
+     *
+     * The target shows the scene from the point (@p x, @p y), nothing out of the @p w x @p h area is prepared or drawn.
+     * This way the same scene is drawn per tile, or only a part of the target is drawn again when the target buffer is given from that part.
+     * The paints are prepared again for the new area on the next update() or draw().
+     *
+     * @param[in] x The horizontal origin of the area in the scene.
+     * @param[in] y The vertical origin of the area in the scene.
+     * @param[in] w The width of the area. Zero takes the width of the target.
+     * @param[in] h The height of the area. Zero takes the height of the target.
+     *
+     * @return Result::NonSupport if the canvas engine doesn't support it.
+     */
+    Result viewport(int32_t x, int32_t y, uint32_t w, uint32_t h) noexcept;
+
     _TVG_DECLARE_PRIVATE(Canvas);
 };
 
@@ -199,6 +252,18 @@ public:
     Result radial(float cx, float cy, float radius) noexcept;
     Result radial(float* cx, float* cy, float* radius) const noexcept;
 
+    /**
+     * @brief Sets the focal point of the gradient.
+     *
+     * The gradient spreads from the focal point (offset 0) to the circle (offset 1).
+     * A focal point out of the circle is moved onto the circle. By default, it's the center of the circle.
+     *
+     * @param[in] fx The horizontal coordinate of the focal point.
+     * @param[in] fy The vertical coordinate of the focal point.
+     */
+    Result focal(float fx, float fy) noexcept;
+    Result focal(float* fx, float* fy) const noexcept;
+
     static std::unique_ptr<RadialGradient> gen() noexcept;
 
     _TVG_DECLARE_PRIVATE(RadialGradient);
@@ -237,6 +302,7 @@ public:
     Result stroke(float width) noexcept;
     Result stroke(uint8_t r, uint8_t g, uint8_t b, uint8_t a) noexcept;
     Result stroke(const float* dashPattern, uint32_t cnt) noexcept;
+    Result stroke(const float* dashPattern, uint32_t cnt, float offset) noexcept;
     Result stroke(StrokeCap cap) noexcept;
     Result stroke(StrokeJoin join) noexcept;
 
@@ -255,6 +321,7 @@ public:
     float strokeWidth() const noexcept;
     Result strokeColor(uint8_t* r, uint8_t* g, uint8_t* b, uint8_t* a) const noexcept;
     uint32_t strokeDash(const float** dashPattern) const noexcept;
+    float strokeDashOffset() const noexcept;
     StrokeCap strokeCap() const noexcept;
     StrokeJoin strokeJoin() const noexcept;
 
@@ -280,10 +347,42 @@ public:
     Result load(const std::string& path) noexcept;
     Result load(const char* data, uint32_t size) noexcept;
     Result load(uint32_t* data, uint32_t w, uint32_t h, bool copy) noexcept;
+
+    /**
+     * @brief Loads a raw image whose rows are @p stride pixels apart.
+     *
+     * Without @p copy, the buffer is sampled in place. So a sub-rectangle of a larger buffer
+     * can be given by its first pixel address with the stride of the larger buffer.
+     *
+     * @param[in] stride The number of pixels from one row to the next, it can't be less than @p w.
+     * @param[in] copy If true, the pixels are copied into a tightly packed buffer.
+     */
+    Result load(uint32_t* data, uint32_t w, uint32_t h, uint32_t stride, bool copy) noexcept;
+
+    /**
+     * @brief Notifies that the pixels of the raw image buffer were modified in place.
+     *
+     * Only the image content is refreshed on the next update, nothing else is recomputed.
+     *
+     * @note Call Canvas::update() with this picture afterwards to draw the new content.
+     */
+    Result invalidate() noexcept;
     Result viewbox(float* x, float* y, float* w, float* h) const noexcept;
 
+    /**
+     * @brief Sets how the raw image pixels are sampled when the picture is scaled or rotated.
+     *
+     * Nearest picks the closest pixel, Bilinear interpolates the four neighbours and
+     * Mipmap additionally samples a box filtered half-size level for strong downscales.
+     *
+     * @note The default is FilterMethod::Nearest. Vector resources are not affected.
+     */
+    Result filter(FilterMethod method) noexcept;
+    FilterMethod filter() const noexcept;
+
     static std::unique_ptr<Picture> gen() noexcept;
 
+    friend Saver;
     _TVG_DECLARE_PRIVATE(Picture);
 };
 
@@ -307,6 +406,7 @@ public:
 
     static std::unique_ptr<Scene> gen() noexcept;
 
+    friend Saver;
     _TVG_DECLARE_PRIVATE(Scene);
 };
 
@@ -324,10 +424,72 @@ class TVG_EXPORT SwCanvas final : public Canvas
 public:
     ~SwCanvas();
 
-    enum Colorspace { ABGR8888 = 0, ARGB8888 };
+    /**
+     * @brief Enumeration specifying the pixel layouts of the target buffer.
+     *
+     * The 32 bits layouts are given as the values of the pixels, the colors are premultiplied by the alpha unless stated otherwise.
+     * The buffer of the 16 and 8 bits layouts is addressed in their pixels as well, so is the stride.
+     */
+    enum Colorspace {
+        ABGR8888 = 0,   ///< 0xAABBGGRR
+        ARGB8888,       ///< 0xAARRGGBB
+        BGRA8888,       ///< 0xBBGGRRAA
+        ABGR8888S,      ///< 0xAABBGGRR with the straight alpha, the bytes are in the RGBA order on the little endian machines.
+        RGB565,         ///< 16 bits RRRRRGGGGGGBBBBB, the target is opaque.
+        A8              ///< 8 bits alpha of the drawings, the colors are ignored.
+    };
+
+    /**
+     * @brief Enumeration specifying how the drawings are combined in the A8 target.
+     *
+     * Max and Add write the coverage of the shapes and the strokes scaled by their opacity, the colors and the gradients aren't looked up.
+     * The pictures of the images and the offscreen drawings, such as masks and translucent scenes, are blended over.
+     */
+    enum Coverage {
+        Over = 0,       ///< The alpha of the drawings is blended over the target.
+        Max,            ///< The greater one of the coverage and the target is kept.
+        Add             ///< The coverage is added to the target, saturated at 255.
+    };
 
     Result target(uint32_t* buffer, uint32_t stride, uint32_t w, uint32_t h, Colorspace cs) noexcept;
 
+    /**
+     * @brief Sets the buffers the frames are drawn to in turn, the k-th draw() goes to the buffer k modulo @p cnt.
+     *
+     * The canvas takes a snapshot of each frame and rasterizes it in the background, so the paints can be updated for the next frame
+     * meanwhile. Up to @p cnt - 1 frames are in the rasterization, a further draw() waits for the oldest one. sync() finishes all of them.
+     * The frames which need offscreen drawings, such as masks, translucent scenes and cached paints, are drawn directly.
+     *
+     * @param[in] buffers The target buffers of the same size and layout.
+     * @param[in] cnt The number of the buffers, one draws as the single buffer target does.
+     * @param[in] stride The stride of the buffers in pixels.
+     * @param[in] w The width of the buffers in pixels.
+     * @param[in] h The height of the buffers in pixels.
+     * @param[in] cs The colorspace of the buffers.
+     *
+     * @note The image pixels of the pictures must be kept until sync() is done, don't load() a drawn picture again before that.
+     */
+    Result target(uint32_t** buffers, uint32_t cnt, uint32_t stride, uint32_t w, uint32_t h, Colorspace cs) noexcept;
+
+    /**
+     * @brief Sets how the drawings are combined in the A8 target, the other colorspaces blend them over regardless.
+     *
+     * Masks and glyph atlases only need the coverage, the methods other than Over skip the color lookups and the blending.
+     *
+     * @param[in] method The combination of the coverage, Over by default.
+     */
+    Result coverage(Coverage method) noexcept;
+
+    /**
+     * @brief Sets the memory budget of the bitmaps kept for Paint::cache(), shared by all the software canvases.
+     *
+     * Over the budget, the least recently drawn bitmaps of any canvas are dropped first, the ones which can't be kept are drawn every time.
+     * The bitmaps drawn in the last frame of a canvas are kept until it draws the next one.
+     *
+     * @param[in] bytes The budget in bytes. Zero keeps no bitmap.
+     */
+    static Result cacheBudget(uint32_t bytes) noexcept;
+
     static std::unique_ptr<SwCanvas> gen() noexcept;
 
     _TVG_DECLARE_PRIVATE(SwCanvas);
@@ -356,6 +518,30 @@ public:
 };
 
 
+/**
+ * @class Saver
+ *
+ * @ingroup ThorVG
+ *
+ * @brief Exports a paint tree into the ThorVG binary format(.tvg).
+ *
+ * The saved file keeps the resolved scene (paths, styles, gradients, transforms),
+ * so Picture::load() can restore it without any parsing & building stages.
+ *
+ */
+class TVG_EXPORT Saver final
+{
+public:
+    ~Saver();
+
+    Result save(std::unique_ptr<Paint> paint, const std::string& path) noexcept;
+
+    static std::unique_ptr<Saver> gen() noexcept;
+
+    _TVG_DECLARE_PRIVATE(Saver);
+};
+
+
 /**
  * @class Engine
  *
@@ -382,6 +568,28 @@ public:
     static Result init(CanvasEngine engine, uint32_t threads) noexcept;
     static Result term(CanvasEngine engine) noexcept;
 
+    /**
+     * @brief Sets the memory budget of the process-wide picture cache.
+     *
+     * Pictures loading the same file path get a copy of the scene parsed at the first time,
+     * as long as the file is not modified. The least recently used files are dropped first
+     * once the decoded data of the cached files exceeds the budget.
+     *
+     * @param[in] size The budget in bytes. Zero disables the cache and drops every cached file.
+     *
+     * @note The cache is off by default and it's emptied on term(). The statistics are reset by this call.
+     */
+    static Result cacheSize(uint32_t size) noexcept;
+
+    /**
+     * @brief Gets the statistics of the picture cache.
+     *
+     * @param[out] hits The number of loads served from the cache.
+     * @param[out] misses The number of loads parsed from the file.
+     * @param[out] cnt The number of files currently cached.
+     */
+    static Result cacheStats(uint32_t* hits, uint32_t* misses, uint32_t* cnt) noexcept;
+
     _TVG_DISABLE_CTOR(Initializer);
 };
 
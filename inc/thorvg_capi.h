@@ -21,12 +21,21 @@ extern "C" {
 typedef struct _Tvg_Canvas Tvg_Canvas;
 typedef struct _Tvg_Paint Tvg_Paint;
 typedef struct _Tvg_Gradient Tvg_Gradient;
+typedef struct _Tvg_Saver Tvg_Saver;
 
 #define TVG_ENGINE_SW (1 << 1)
 #define TVG_ENGINE_GL (1 << 2)
 
 #define TVG_COLORSPACE_ABGR8888 0
 #define TVG_COLORSPACE_ARGB8888 1
+#define TVG_COLORSPACE_BGRA8888 2
+#define TVG_COLORSPACE_ABGR8888S 3
+#define TVG_COLORSPACE_RGB565 4
+#define TVG_COLORSPACE_A8 5
+
+#define TVG_COVERAGE_OVER 0
+#define TVG_COVERAGE_MAX 1
+#define TVG_COVERAGE_ADD 2
 
 typedef enum {
     TVG_RESULT_SUCCESS = 0,
@@ -73,12 +82,46 @@ typedef enum {
     TVG_FILL_RULE_EVEN_ODD
 } Tvg_Fill_Rule;
 
+
+typedef enum {
+    TVG_FILTER_METHOD_NEAREST = 0,
+    TVG_FILTER_METHOD_BILINEAR,
+    TVG_FILTER_METHOD_MIPMAP
+} Tvg_Filter_Method;
+
 typedef struct
 {
     float x, y;
 } Tvg_Point;
 
 
+//Mutations of the paints applied in a batch, the arguments are taken from the float array in the given order.
+typedef enum {
+    TVG_COMMAND_SHAPE_RESET = 0,        //none
+    TVG_COMMAND_SHAPE_MOVE_TO,          //x, y
+    TVG_COMMAND_SHAPE_LINE_TO,          //x, y
+    TVG_COMMAND_SHAPE_CUBIC_TO,         //cx1, cy1, cx2, cy2, x, y
+    TVG_COMMAND_SHAPE_CLOSE,            //none
+    TVG_COMMAND_SHAPE_APPEND_RECT,      //x, y, w, h, rx, ry
+    TVG_COMMAND_SHAPE_APPEND_CIRCLE,    //cx, cy, rx, ry
+    TVG_COMMAND_SHAPE_SET_FILL_COLOR,   //r, g, b, a
+    TVG_COMMAND_SHAPE_SET_STROKE_WIDTH, //width
+    TVG_COMMAND_SHAPE_SET_STROKE_COLOR, //r, g, b, a
+    TVG_COMMAND_PAINT_TRANSLATE,        //x, y
+    TVG_COMMAND_PAINT_SCALE,            //factor
+    TVG_COMMAND_PAINT_ROTATE,           //degree
+    TVG_COMMAND_PAINT_TRANSFORM,        //e11, e12, e13, e21, e22, e23, e31, e32, e33
+    TVG_COMMAND_PAINT_SET_OPACITY       //opacity
+} Tvg_Command_Type;
+
+
+typedef struct
+{
+    Tvg_Command_Type type;
+    uint32_t paint;                     //index of the target in the paints, the shape commands need a shape
+} Tvg_Command;
+
+
 typedef struct
 {
     float e11, e12, e13;
@@ -97,6 +140,8 @@ typedef struct
 /************************************************************************/
 TVG_EXPORT Tvg_Result tvg_engine_init(unsigned engine_method, unsigned threads);
 TVG_EXPORT Tvg_Result tvg_engine_term(unsigned engine_method);
+TVG_EXPORT Tvg_Result tvg_engine_set_cache_size(uint32_t bytes);
+TVG_EXPORT Tvg_Result tvg_engine_get_cache_stats(uint32_t* hits, uint32_t* misses, uint32_t* cnt);
 
 
 /************************************************************************/
@@ -104,6 +149,9 @@ TVG_EXPORT Tvg_Result tvg_engine_term(unsigned engine_method);
 /************************************************************************/
 TVG_EXPORT Tvg_Canvas* tvg_swcanvas_create();
 TVG_EXPORT Tvg_Result tvg_swcanvas_set_target(Tvg_Canvas* canvas, uint32_t* buffer, uint32_t stride, uint32_t w, uint32_t h, uint32_t cs);
+TVG_EXPORT Tvg_Result tvg_swcanvas_set_targets(Tvg_Canvas* canvas, uint32_t** buffers, uint32_t cnt, uint32_t stride, uint32_t w, uint32_t h, uint32_t cs);
+TVG_EXPORT Tvg_Result tvg_swcanvas_set_coverage(Tvg_Canvas* canvas, uint32_t method);
+TVG_EXPORT Tvg_Result tvg_swcanvas_set_cache_budget(uint32_t bytes);
 
 
 /************************************************************************/
@@ -117,6 +165,7 @@ TVG_EXPORT Tvg_Result tvg_canvas_update(Tvg_Canvas* canvas);
 TVG_EXPORT Tvg_Result tvg_canvas_update_paint(Tvg_Canvas* canvas, Tvg_Paint* paint);
 TVG_EXPORT Tvg_Result tvg_canvas_draw(Tvg_Canvas* canvas);
 TVG_EXPORT Tvg_Result tvg_canvas_sync(Tvg_Canvas* canvas);
+TVG_EXPORT Tvg_Result tvg_canvas_set_viewport(Tvg_Canvas* canvas, int32_t x, int32_t y, uint32_t w, uint32_t h);
 
 
 /************************************************************************/
@@ -128,8 +177,12 @@ TVG_EXPORT Tvg_Result tvg_paint_rotate(Tvg_Paint* paint, float degree);
 TVG_EXPORT Tvg_Result tvg_paint_translate(Tvg_Paint* paint, float x, float y);
 TVG_EXPORT Tvg_Result tvg_paint_transform(Tvg_Paint* paint, const Tvg_Matrix* m);
 TVG_EXPORT Tvg_Result tvg_paint_set_opacity(Tvg_Paint* paint, uint8_t opacity);
+TVG_EXPORT Tvg_Result tvg_paint_set_cache(Tvg_Paint* paint, bool hint);
 TVG_EXPORT Tvg_Result tvg_paint_get_opacity(Tvg_Paint* paint, uint8_t* opacity);
 TVG_EXPORT Tvg_Paint* tvg_paint_duplicate(Tvg_Paint* paint);
+TVG_EXPORT Tvg_Result tvg_paint_apply(Tvg_Paint** paints, uint32_t paintCnt, const Tvg_Command* cmds, uint32_t cmdCnt, const float* args, uint32_t argCnt);
+TVG_EXPORT Tvg_Result tvg_paints_transform(Tvg_Paint** paints, const Tvg_Matrix* m, uint32_t cnt);
+TVG_EXPORT Tvg_Result tvg_paints_set_opacity(Tvg_Paint** paints, const uint8_t* opacity, uint32_t cnt);
 
 /************************************************************************/
 /* Shape API                                                            */
@@ -173,6 +226,8 @@ TVG_EXPORT Tvg_Result tvg_linear_gradient_set(Tvg_Gradient* grad, float x1, floa
 TVG_EXPORT Tvg_Result tvg_linear_gradient_get(Tvg_Gradient* grad, float* x1, float* y1, float* x2, float* y2);
 TVG_EXPORT Tvg_Result tvg_radial_gradient_set(Tvg_Gradient* grad, float cx, float cy, float radius);
 TVG_EXPORT Tvg_Result tvg_radial_gradient_get(Tvg_Gradient* grad, float* cx, float* cy, float* radius);
+TVG_EXPORT Tvg_Result tvg_radial_gradient_set_focal(Tvg_Gradient* grad, float fx, float fy);
+TVG_EXPORT Tvg_Result tvg_radial_gradient_get_focal(Tvg_Gradient* grad, float* fx, float* fy);
 TVG_EXPORT Tvg_Result tvg_gradient_set_color_stops(Tvg_Gradient* grad, const Tvg_Color_Stop* color_stop, uint32_t cnt);
 TVG_EXPORT Tvg_Result tvg_gradient_get_color_stops(Tvg_Gradient* grad, const Tvg_Color_Stop** color_stop, uint32_t* cnt);
 TVG_EXPORT Tvg_Result tvg_gradient_set_spread(Tvg_Gradient* grad, const Tvg_Stroke_Fill spread);
@@ -185,7 +240,11 @@ TVG_EXPORT Tvg_Result tvg_gradient_del(Tvg_Gradient* grad);
 TVG_EXPORT Tvg_Paint* tvg_picture_new();
 TVG_EXPORT Tvg_Result tvg_picture_load(Tvg_Paint* paint, const char* path);
 TVG_EXPORT Tvg_Result tvg_picture_load_raw(Tvg_Paint* paint, uint32_t *data, uint32_t w, uint32_t h, bool copy);
+TVG_EXPORT Tvg_Result tvg_picture_load_raw_with_stride(Tvg_Paint* paint, uint32_t *data, uint32_t w, uint32_t h, uint32_t stride, bool copy);
+TVG_EXPORT Tvg_Result tvg_picture_invalidate(Tvg_Paint* paint);
 TVG_EXPORT Tvg_Result tvg_picture_get_viewbox(const Tvg_Paint* paint, float* x, float* y, float* w, float* h);
+TVG_EXPORT Tvg_Result tvg_picture_set_filter(Tvg_Paint* paint, Tvg_Filter_Method method);
+TVG_EXPORT Tvg_Result tvg_picture_get_filter(const Tvg_Paint* paint, Tvg_Filter_Method* method);
 
 /************************************************************************/
 /* Scene API                                                            */
@@ -195,6 +254,13 @@ TVG_EXPORT Tvg_Result tvg_scene_reserve(Tvg_Paint* scene, uint32_t size);
 TVG_EXPORT Tvg_Result tvg_scene_push(Tvg_Paint* scene, Tvg_Paint* paint);
 TVG_EXPORT Tvg_Result tvg_scene_clear(Tvg_Paint* scene);
 
+/************************************************************************/
+/* Saver API                                                            */
+/************************************************************************/
+TVG_EXPORT Tvg_Saver* tvg_saver_new();
+TVG_EXPORT Tvg_Result tvg_saver_save(Tvg_Saver* saver, Tvg_Paint* paint, const char* path);
+TVG_EXPORT Tvg_Result tvg_saver_del(Tvg_Saver* saver);
+
 
 #ifdef __cplusplus
 }
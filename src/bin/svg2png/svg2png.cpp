@@ -20,34 +20,49 @@
  * SOFTWARE.
  */
 
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
 #include <iostream>
+#include <mutex>
+#include <set>
 #include <thread>
 #include <thorvg.h>
 #include <vector>
+#include <sys/stat.h>
+#ifndef _WIN32
+    #include <dirent.h>
+    #include <glob.h>
+#endif
 #include "lodepng.h"
 
 using namespace std;
 
 
 struct PngBuilder {
+    vector<unsigned char> image;
 
-    void build(const std::string &fileName , const uint32_t width, const uint32_t height, uint32_t *buffer)
-    {
-        std::vector<unsigned char> image;
-        image.resize(width * height * 4);
-        for(unsigned y = 0; y < height; y++)  {
-            for(unsigned x = 0; x < width; x++) {
-                uint32_t n = buffer[ y * width + x ];
-                image[4 * width * y + 4 * x + 0] = ( n >> 16 ) & 0xff;
-                image[4 * width * y + 4 * x + 1] = ( n >> 8 ) & 0xff;
-                image[4 * width * y + 4 * x + 2] = n & 0xff;
-                image[4 * width * y + 4 * x + 3] = ( n >> 24 ) & 0xff;
-            }
+    //The canvas draws the 0xAABBGGRR pixels with the straight alpha, they are encoded in the RGBA bytes.
+    bool build(const std::string &fileName , const uint32_t width, const uint32_t height, uint32_t *buffer)
+    {
+        image.resize(static_cast<size_t>(width) * height * 4);
+        auto dst = image.data();
+        for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i, dst += 4) {
+            auto pixel = buffer[i];
+            dst[0] = pixel & 0xff;
+            dst[1] = (pixel >> 8) & 0xff;
+            dst[2] = (pixel >> 16) & 0xff;
+            dst[3] = pixel >> 24;
         }
+
         unsigned error = lodepng::encode(fileName, image, width, height);
 
         //if there's an error, display it
         if(error) std::cout << "encoder error " << error << ": "<< lodepng_error_text(error) << std::endl;
+
+        return !error;
     }
 };
 
@@ -116,7 +131,7 @@ struct App {
             }
 
             auto buffer = (uint32_t*)malloc(sizeof(uint32_t) * w * h);
-            swCanvas->target(buffer, w, w, h, tvg::SwCanvas::ARGB8888);
+            swCanvas->target(buffer, w, w, h, tvg::SwCanvas::ABGR8888S);
             /* Push the shape into the Canvas drawing list
                When this shape is into the canvas list, the shape could update & prepare
                internal data asynchronously for coming rendering.
@@ -126,7 +141,7 @@ struct App {
             if (useSvgSize) {
                 //Resize target buffer
                 buffer = (uint32_t*)realloc(buffer, sizeof(uint32_t) * width * height);
-                swCanvas->target(buffer, width, width, height, tvg::SwCanvas::ARGB8888);
+                swCanvas->target(buffer, width, width, height, tvg::SwCanvas::ABGR8888S);
             }
 
 
@@ -208,7 +223,7 @@ private:
     }
 
     int help() {
-        std::cout<<"Usage: \n   svg2png [svgFileName] [Resolution] [bgColor]\n\nExamples: \n    $ svg2png input.svg\n    $ svg2png input.svg 200x200\n    $ svg2png input.svg 200x200 ff00ff\n\n";
+        std::cout<<"Usage: \n   svg2png [svgFileName] [Resolution] [bgColor]\n\nExamples: \n    $ svg2png input.svg\n    $ svg2png input.svg 200x200\n    $ svg2png input.svg 200x200 ff00ff\n\nFor converting many files at once, see the batch mode: svg2png -h\n\n";
         return 1;
     }
 
@@ -220,9 +235,337 @@ private:
     std::string pngName;
 };
 
+
+/* Converts a set of files at one or more sizes with an engine initialized only once.
+   Every job owns a canvas, a target buffer and a png builder which are reused for
+   all its files, so the files are rendered concurrently without any reallocation. */
+struct Batch {
+
+    struct Size {
+        uint32_t w, h;        //0 x 0: use the svg size
+    };
+
+    struct File {
+        std::string path;
+        std::string name;     //output name without the extension, relative to the output directory
+    };
+
+    struct Job {
+        std::unique_ptr<tvg::SwCanvas> canvas;
+        uint32_t* buffer = nullptr;
+        uint32_t reserved = 0;
+        PngBuilder builder;
+
+        ~Job()
+        {
+            canvas = nullptr;
+            free(buffer);
+        }
+    };
+
+    int run()
+    {
+        if (files.empty()) {
+            std::cout<<"No svg files to convert"<<std::endl;
+            return 1;
+        }
+
+        tvg::CanvasEngine tvgEngine = tvg::CanvasEngine::Sw;
+
+        //Threads Count, tasks must run on the engine threads since the canvases work concurrently.
+        auto threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+        if (jobCnt == 0) jobCnt = threads;
+        if (jobCnt > files.size()) jobCnt = files.size();
+        if (sizes.empty()) sizes.push_back({0, 0});
+        if (!outputs()) return 1;
+
+        //Initialize ThorVG Engine
+        if (tvg::Initializer::init(tvgEngine, threads) != tvg::Result::Success) {
+            cout << "engine is not supported" << endl;
+            return 1;
+        }
+
+        //Canvas Pool
+        std::vector<Job> jobs(jobCnt);
+        for (auto& job : jobs) job.canvas = tvg::SwCanvas::gen();
+
+        auto begin = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> workers;
+        for (auto& job : jobs) {
+            workers.emplace_back([&] { work(job); });
+        }
+        for (auto& worker : workers) worker.join();
+
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        jobs.clear();
+
+        //Terminate ThorVG Engine
+        tvg::Initializer::term(tvgEngine);
+
+        std::cout<<"Converted "<<files.size() - failures<<"/"<<files.size()<<" files into "<<images<<" PNG files in "<<elapsed<<" s";
+        if (elapsed > 0) std::cout<<" ("<<(files.size() - failures) / elapsed<<" files/s, "<<images / elapsed<<" images/s)";
+        std::cout<<" with "<<jobCnt<<" jobs"<<std::endl;
+
+        return failures > 0 ? 1 : 0;
+    }
+
+    int setup(int argc, char **argv)
+    {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "-r" || arg == "-b" || arg == "-j" || arg == "-o") {
+                if (i + 1 >= argc) return help();
+                std::string val = argv[++i];
+                if (arg == "-r") {
+                    if (!parseSizes(val)) return help();
+                } else if (arg == "-b") {
+                    bgColor = strtol(val.c_str(), NULL, 16);
+                } else if (arg == "-j") {
+                    if (!parseJobs(val)) return help();
+                } else {
+                    outDir = val;
+                    if (!outDir.empty() && outDir.back() != '/' && outDir.back() != '\\') outDir += '/';
+                }
+            } else if (arg[0] == '-') {
+                return help();
+            } else {
+                add(arg);
+            }
+        }
+        return 0;
+    }
+
+    static bool requested(int argc, char **argv)
+    {
+        if (argc < 2) return false;
+        for (int i = 1; i < argc; ++i) {
+            if (argv[i][0] == '-') return true;
+        }
+        if (isDir(argv[1]) || isGlob(argv[1])) return true;
+        //Multiple files are given
+        if (argc > 2 && isSvg(argv[2])) return true;
+        return false;
+    }
+
+private:
+    void work(Job& job)
+    {
+        while (true) {
+            auto idx = next++;
+            if (idx >= files.size()) break;
+            auto cnt = convert(job, files[idx]);
+            if (cnt == 0) {
+                ++failures;
+                std::lock_guard<std::mutex> lock(mtx);
+                std::cout<<"Failed to convert : "<<files[idx].path<<std::endl;
+            }
+            images += cnt;
+        }
+    }
+
+    //Returns the number of generated images
+    uint32_t convert(Job& job, const File& file)
+    {
+        auto picture = tvg::Picture::gen();
+        if (picture->load(file.path) != tvg::Result::Success) return 0;
+
+        float fw, fh;
+        picture->viewbox(nullptr, nullptr, &fw, &fh);
+        if (fw <= 0 || fh <= 0) return 0;
+
+        auto name = outDir + file.name;
+
+        uint32_t cnt = 0;
+
+        for (uint32_t i = 0; i < sizes.size(); ++i) {
+            //The parsed scene is copied for all the sizes but the last one.
+            std::unique_ptr<tvg::Paint> paint;
+            if (i + 1 < sizes.size()) paint = std::unique_ptr<tvg::Paint>(picture->duplicate());
+            else paint = std::move(picture);
+            if (!paint) break;
+
+            auto w = sizes[i].w;
+            auto h = sizes[i].h;
+            if (w == 0 || h == 0) {
+                w = static_cast<uint32_t>(fw);
+                h = static_cast<uint32_t>(fh);
+                if (w == 0 || h == 0) continue;
+            } else {
+                tvg::Matrix m = {w / fw, 0, 0, 0, h / fh, 0, 0, 0, 1};
+                paint->transform(m);
+            }
+
+            if (w * h > job.reserved) {
+                free(job.buffer);
+                job.buffer = (uint32_t*)malloc(sizeof(uint32_t) * w * h);
+                job.reserved = job.buffer ? w * h : 0;
+                if (!job.buffer) break;
+            }
+            if (job.canvas->target(job.buffer, w, w, h, tvg::SwCanvas::ABGR8888S) != tvg::Result::Success) break;
+
+            if (bgColor != 0xffffffff) {
+                auto shape = tvg::Shape::gen();
+                shape->appendRect(0, 0, w, h, 0, 0);
+                shape->fill((bgColor & 0xff0000) >> 16, (bgColor & 0x00ff00) >> 8, (bgColor & 0x0000ff), 255);
+                job.canvas->push(move(shape));
+            }
+
+            job.canvas->push(move(paint));
+            if (job.canvas->draw() == tvg::Result::Success) job.canvas->sync();
+            job.canvas->clear();
+
+            auto pngName = name;
+            if (sizes.size() > 1) pngName += "_" + std::to_string(w) + "x" + std::to_string(h);
+            pngName += ".png";
+
+            if (job.builder.build(pngName, w, h, job.buffer)) ++cnt;
+        }
+
+        return cnt;
+    }
+
+    //Files found in a directory keep their path inside it, so the same names in sub directories don't collide.
+    bool outputs()
+    {
+        std::set<std::string> names;
+        for (auto& file : files) {
+            if (names.insert(file.name).second) continue;
+            std::cout<<"Output name collision : "<<file.path<<" would overwrite another "<<file.name<<".png"<<std::endl;
+            return false;
+        }
+#ifndef _WIN32
+        for (auto& name : names) {
+            for (auto pos = name.find('/'); pos != std::string::npos; pos = name.find('/', pos + 1)) {
+                auto dir = outDir + name.substr(0, pos);
+                if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+                    std::cout<<"Failed to create : "<<dir<<std::endl;
+                    return false;
+                }
+            }
+        }
+#endif
+        return true;
+    }
+
+    bool parseJobs(const std::string& val)
+    {
+        if (val.empty() || !isdigit(static_cast<unsigned char>(val[0]))) return false;
+        char* end;
+        errno = 0;
+        auto cnt = strtoul(val.c_str(), &end, 10);
+        if (*end != '\0' || errno == ERANGE || cnt < 1 || cnt > MAX_JOBS) return false;
+        jobCnt = static_cast<uint32_t>(cnt);
+        return true;
+    }
+
+    bool parseSizes(const std::string& list)
+    {
+        size_t pos = 0;
+        while (pos < list.size()) {
+            auto end = list.find(',', pos);
+            if (end == std::string::npos) end = list.size();
+            auto size = list.substr(pos, end - pos);
+            auto x = size.find('x');
+            if (x == std::string::npos) return false;
+            sizes.push_back({static_cast<uint32_t>(atoi(size.substr(0, x).c_str())), static_cast<uint32_t>(atoi(size.substr(x + 1).c_str()))});
+            pos = end + 1;
+        }
+        return !sizes.empty();
+    }
+
+    void add(const std::string& path)
+    {
+        if (isDir(path)) {
+            addDir(path);
+            return;
+        }
+#ifndef _WIN32
+        if (isGlob(path)) {
+            glob_t result;
+            if (glob(path.c_str(), 0, NULL, &result) == 0) {
+                for (size_t i = 0; i < result.gl_pathc; ++i) add(result.gl_pathv[i]);
+            }
+            globfree(&result);
+            return;
+        }
+#endif
+        if (isSvg(path)) files.push_back({path, stem(basename(path))});
+    }
+
+    void addDir(const std::string& path, const std::string& relative = "")
+    {
+#ifndef _WIN32
+        auto dir = opendir(path.c_str());
+        if (!dir) return;
+        while (auto entry = readdir(dir)) {
+            if (entry->d_name[0] == '.') continue;
+            auto child = path + "/" + entry->d_name;
+            if (isDir(child)) addDir(child, relative + entry->d_name + "/");
+            else if (isSvg(child)) files.push_back({child, relative + stem(entry->d_name)});
+        }
+        closedir(dir);
+#endif
+    }
+
+    static bool isDir(const std::string& path)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) return false;
+        return (info.st_mode & S_IFMT) == S_IFDIR;
+    }
+
+    static bool isGlob(const std::string& path)
+    {
+        return path.find_first_of("*?[") != std::string::npos;
+    }
+
+    static bool isSvg(const std::string& path)
+    {
+        std::string extn = ".svg";
+        return path.size() > extn.size() && path.substr(path.size() - extn.size()) == extn;
+    }
+
+    static std::string basename(const std::string &str)
+    {
+        return str.substr(str.find_last_of("/\\") + 1);
+    }
+
+    static std::string stem(const std::string &str)
+    {
+        return str.substr(0, str.size() - 4);
+    }
+
+    int help() {
+        std::cout<<"Usage: \n   svg2png [-r WxH[,WxH...]] [-b bgColor] [-j jobs] [-o outDir] [svgFileName|directory|pattern]...\n\nExamples: \n    $ svg2png icons/\n    $ svg2png -r 24x24,48x48 -j 8 -o out \"icons/*.svg\"\n    $ svg2png -b ff00ff a.svg b.svg\n\n";
+        return 1;
+    }
+
+private:
+    static constexpr unsigned long MAX_JOBS = 1024;
+
+    std::vector<File> files;
+    std::vector<Size> sizes;
+    std::string outDir;
+    uint32_t bgColor = 0xffffffff;
+    uint32_t jobCnt = 0;
+    std::atomic<size_t> next{0};
+    std::atomic<uint32_t> images{0};
+    std::atomic<uint32_t> failures{0};
+    std::mutex mtx;
+};
+
 int
 main(int argc, char **argv)
 {
+    if (Batch::requested(argc, argv)) {
+        Batch batch;
+        if (batch.setup(argc, argv)) return 1;
+        return batch.run();
+    }
+
     App app;
     size_t w, h;
 
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <array>
+#include <iostream>
+#include <thread>
+#include <thorvg.h>
+
+using namespace std;
+
+
+struct App {
+
+    int convert()
+    {
+        tvg::CanvasEngine tvgEngine = tvg::CanvasEngine::Sw;
+
+        //Threads Count
+        auto threads = std::thread::hardware_concurrency();
+
+        //Initialize ThorVG Engine
+        if (tvg::Initializer::init(tvgEngine, threads) != tvg::Result::Success) {
+            cout << "engine is not supported" << endl;
+            return 1;
+        }
+
+        auto ret = 1;
+
+        auto picture = tvg::Picture::gen();
+        if (picture->load(fileName) == tvg::Result::Success) {
+            auto saver = tvg::Saver::gen();
+            if (saver->save(move(picture), tvgName) == tvg::Result::Success) ret = 0;
+        }
+
+        //Terminate ThorVG Engine
+        tvg::Initializer::term(tvgEngine);
+
+        return result(ret);
+    }
+
+    int setup(int argc, char **argv)
+    {
+        char *path{nullptr};
+
+        if (argc > 1) path = argv[1];
+        if (!path) return help();
+
+        std::array<char, 5000> memory;
+
+#ifdef _WIN32
+        path = _fullpath(memory.data(), path, memory.size());
+#else
+        path = realpath(path, memory.data());
+#endif
+        if (!path) return help();
+
+        fileName = std::string(path);
+
+        if (!svgFile()) return help();
+
+        if (argc > 2) {
+            tvgName = argv[2];
+        } else {
+            tvgName = basename(fileName);
+            tvgName.replace(tvgName.size() - 4, 4, ".tvg");
+        }
+        return 0;
+    }
+
+private:
+    std::string basename(const std::string &str)
+    {
+        return str.substr(str.find_last_of("/\\") + 1);
+    }
+
+    bool svgFile() {
+        std::string extn = ".svg";
+        if (fileName.size() <= extn.size() || fileName.substr(fileName.size() - extn.size()) != extn)
+            return false;
+
+        return true;
+    }
+
+    int result(int ret) {
+        if (ret == 0) std::cout<<"Generated TVG file : "<<tvgName<<std::endl;
+        else std::cout<<"Failed to convert : "<<fileName<<std::endl;
+        return ret;
+    }
+
+    int help() {
+        std::cout<<"Usage: \n   svg2tvg [svgFileName] [tvgFileName]\n\nExamples: \n    $ svg2tvg input.svg\n    $ svg2tvg input.svg output.tvg\n\n";
+        return 1;
+    }
+
+private:
+    std::string fileName;
+    std::string tvgName;
+};
+
+int
+main(int argc, char **argv)
+{
+    App app;
+
+    if (app.setup(argc, argv)) return 1;
+
+    return app.convert();
+}
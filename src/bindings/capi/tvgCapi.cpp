@@ -22,6 +22,7 @@
 
 #include <string>
 #include <thorvg.h>
+#include "tvgCommon.h"
 #include "thorvg_capi.h"
 
 using namespace std;
@@ -29,6 +30,40 @@ using namespace tvg;
 
 #define CCP(A) const_cast<Tvg_Paint*>(A)  //Const-Cast-Paint
 
+//Number of the arguments of the Tvg_Command_Type
+static const uint32_t _argCnt[] = {0, 2, 2, 6, 0, 6, 4, 4, 1, 4, 2, 1, 1, 9, 1};
+
+
+static uint8_t _byte(float v)
+{
+    return static_cast<uint8_t>(v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v));
+}
+
+
+static Result _apply(Paint* paint, Tvg_Command_Type type, const float* v)
+{
+    auto shape = static_cast<Shape*>(paint);
+
+    switch (type) {
+        case TVG_COMMAND_SHAPE_RESET: return shape->reset();
+        case TVG_COMMAND_SHAPE_MOVE_TO: return shape->moveTo(v[0], v[1]);
+        case TVG_COMMAND_SHAPE_LINE_TO: return shape->lineTo(v[0], v[1]);
+        case TVG_COMMAND_SHAPE_CUBIC_TO: return shape->cubicTo(v[0], v[1], v[2], v[3], v[4], v[5]);
+        case TVG_COMMAND_SHAPE_CLOSE: return shape->close();
+        case TVG_COMMAND_SHAPE_APPEND_RECT: return shape->appendRect(v[0], v[1], v[2], v[3], v[4], v[5]);
+        case TVG_COMMAND_SHAPE_APPEND_CIRCLE: return shape->appendCircle(v[0], v[1], v[2], v[3]);
+        case TVG_COMMAND_SHAPE_SET_FILL_COLOR: return shape->fill(_byte(v[0]), _byte(v[1]), _byte(v[2]), _byte(v[3]));
+        case TVG_COMMAND_SHAPE_SET_STROKE_WIDTH: return shape->stroke(v[0]);
+        case TVG_COMMAND_SHAPE_SET_STROKE_COLOR: return shape->stroke(_byte(v[0]), _byte(v[1]), _byte(v[2]), _byte(v[3]));
+        case TVG_COMMAND_PAINT_TRANSLATE: return paint->translate(v[0], v[1]);
+        case TVG_COMMAND_PAINT_SCALE: return paint->scale(v[0]);
+        case TVG_COMMAND_PAINT_ROTATE: return paint->rotate(v[0]);
+        case TVG_COMMAND_PAINT_TRANSFORM: return paint->transform({v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8]});
+        case TVG_COMMAND_PAINT_SET_OPACITY: return paint->opacity(_byte(v[0]));
+    }
+    return Result::InvalidArguments;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -49,6 +84,18 @@ TVG_EXPORT Tvg_Result tvg_engine_term(unsigned engine_method)
     return (Tvg_Result) Initializer::term(CanvasEngine(engine_method));
 }
 
+
+TVG_EXPORT Tvg_Result tvg_engine_set_cache_size(uint32_t bytes)
+{
+    return (Tvg_Result) Initializer::cacheSize(bytes);
+}
+
+
+TVG_EXPORT Tvg_Result tvg_engine_get_cache_stats(uint32_t* hits, uint32_t* misses, uint32_t* cnt)
+{
+    return (Tvg_Result) Initializer::cacheStats(hits, misses, cnt);
+}
+
 /************************************************************************/
 /* Canvas API                                                           */
 /************************************************************************/
@@ -74,6 +121,26 @@ TVG_EXPORT Tvg_Result tvg_swcanvas_set_target(Tvg_Canvas* canvas, uint32_t* buff
 }
 
 
+TVG_EXPORT Tvg_Result tvg_swcanvas_set_targets(Tvg_Canvas* canvas, uint32_t** buffers, uint32_t cnt, uint32_t stride, uint32_t w, uint32_t h, uint32_t cs)
+{
+    if (!canvas) return TVG_RESULT_INVALID_ARGUMENT;
+    return (Tvg_Result) reinterpret_cast<SwCanvas*>(canvas)->target(buffers, cnt, stride, w, h, static_cast<SwCanvas::Colorspace>(cs));
+}
+
+
+TVG_EXPORT Tvg_Result tvg_swcanvas_set_coverage(Tvg_Canvas* canvas, uint32_t method)
+{
+    if (!canvas) return TVG_RESULT_INVALID_ARGUMENT;
+    return (Tvg_Result) reinterpret_cast<SwCanvas*>(canvas)->coverage(static_cast<SwCanvas::Coverage>(method));
+}
+
+
+TVG_EXPORT Tvg_Result tvg_swcanvas_set_cache_budget(uint32_t bytes)
+{
+    return (Tvg_Result) SwCanvas::cacheBudget(bytes);
+}
+
+
 TVG_EXPORT Tvg_Result tvg_canvas_push(Tvg_Canvas* canvas, Tvg_Paint* paint)
 {
     if (!canvas || !paint) return TVG_RESULT_INVALID_ARGUMENT;
@@ -123,6 +190,13 @@ TVG_EXPORT Tvg_Result tvg_canvas_sync(Tvg_Canvas* canvas)
 }
 
 
+TVG_EXPORT Tvg_Result tvg_canvas_set_viewport(Tvg_Canvas* canvas, int32_t x, int32_t y, uint32_t w, uint32_t h)
+{
+    if (!canvas) return TVG_RESULT_INVALID_ARGUMENT;
+    return (Tvg_Result) reinterpret_cast<Canvas*>(canvas)->viewport(x, y, w, h);
+}
+
+
 /************************************************************************/
 /* Paint API                                                            */
 /************************************************************************/
@@ -184,6 +258,66 @@ TVG_EXPORT Tvg_Result tvg_paint_get_opacity(Tvg_Paint* paint, uint8_t* opacity)
     return TVG_RESULT_SUCCESS;
 }
 
+
+TVG_EXPORT Tvg_Result tvg_paint_set_cache(Tvg_Paint* paint, bool hint)
+{
+    if (!paint) return TVG_RESULT_INVALID_ARGUMENT;
+    return (Tvg_Result) reinterpret_cast<Paint*>(paint)->cache(hint);
+}
+
+
+//The whole batch is checked first, an invalid command leaves all the paints as they are.
+//Then the commands are applied in order up to the first failure, the preceding ones are kept.
+TVG_EXPORT Tvg_Result tvg_paint_apply(Tvg_Paint** paints, uint32_t paintCnt, const Tvg_Command* cmds, uint32_t cmdCnt, const float* args, uint32_t argCnt)
+{
+    if (!paints || (!cmds && cmdCnt > 0) || (!args && argCnt > 0)) return TVG_RESULT_INVALID_ARGUMENT;
+
+    uint32_t arg = 0;
+    for (uint32_t i = 0; i < cmdCnt; ++i) {
+        auto& cmd = cmds[i];
+        if (static_cast<uint32_t>(cmd.type) >= sizeof(_argCnt) / sizeof(_argCnt[0])) return TVG_RESULT_INVALID_ARGUMENT;
+        if (cmd.paint >= paintCnt || !paints[cmd.paint]) return TVG_RESULT_INVALID_ARGUMENT;
+        if (cmd.type <= TVG_COMMAND_SHAPE_SET_STROKE_COLOR && reinterpret_cast<Paint*>(paints[cmd.paint])->id() != PAINT_ID_SHAPE) return TVG_RESULT_INVALID_ARGUMENT;
+        if (_argCnt[cmd.type] > argCnt - arg) return TVG_RESULT_INVALID_ARGUMENT;
+        arg += _argCnt[cmd.type];
+    }
+
+    arg = 0;
+    for (uint32_t i = 0; i < cmdCnt; ++i) {
+        auto& cmd = cmds[i];
+        auto ret = _apply(reinterpret_cast<Paint*>(paints[cmd.paint]), cmd.type, args + arg);
+        if (ret != Result::Success) return (Tvg_Result) ret;
+        arg += _argCnt[cmd.type];
+    }
+    return TVG_RESULT_SUCCESS;
+}
+
+
+TVG_EXPORT Tvg_Result tvg_paints_transform(Tvg_Paint** paints, const Tvg_Matrix* m, uint32_t cnt)
+{
+    if (!paints || !m) return TVG_RESULT_INVALID_ARGUMENT;
+
+    for (uint32_t i = 0; i < cnt; ++i) {
+        if (!paints[i]) return TVG_RESULT_INVALID_ARGUMENT;
+        auto ret = reinterpret_cast<Paint*>(paints[i])->transform(*(reinterpret_cast<const Matrix*>(m + i)));
+        if (ret != Result::Success) return (Tvg_Result) ret;
+    }
+    return TVG_RESULT_SUCCESS;
+}
+
+
+TVG_EXPORT Tvg_Result tvg_paints_set_opacity(Tvg_Paint** paints, const uint8_t* opacity, uint32_t cnt)
+{
+    if (!paints || !opacity) return TVG_RESULT_INVALID_ARGUMENT;
+
+    for (uint32_t i = 0; i < cnt; ++i) {
+        if (!paints[i]) return TVG_RESULT_INVALID_ARGUMENT;
+        auto ret = reinterpret_cast<Paint*>(paints[i])->opacity(opacity[i]);
+        if (ret != Result::Success) return (Tvg_Result) ret;
+    }
+    return TVG_RESULT_SUCCESS;
+}
+
 /************************************************************************/
 /* Shape API                                                            */
 /************************************************************************/
@@ -419,6 +553,20 @@ TVG_EXPORT Tvg_Result tvg_picture_load_raw(Tvg_Paint* paint, uint32_t *data, uin
 }
 
 
+TVG_EXPORT Tvg_Result tvg_picture_load_raw_with_stride(Tvg_Paint* paint, uint32_t *data, uint32_t w, uint32_t h, uint32_t stride, bool copy)
+{
+    if (!paint) return TVG_RESULT_INVALID_ARGUMENT;
+    return (Tvg_Result) reinterpret_cast<Picture*>(paint)->load(data, w, h, stride, copy);
+}
+
+
+TVG_EXPORT Tvg_Result tvg_picture_invalidate(Tvg_Paint* paint)
+{
+    if (!paint) return TVG_RESULT_INVALID_ARGUMENT;
+    return (Tvg_Result) reinterpret_cast<Picture*>(paint)->invalidate();
+}
+
+
 TVG_EXPORT Tvg_Result tvg_picture_get_viewbox(const Tvg_Paint* paint, float* x, float* y, float* w, float* h)
 {
     if (!paint) return TVG_RESULT_INVALID_ARGUMENT;
@@ -426,6 +574,21 @@ TVG_EXPORT Tvg_Result tvg_picture_get_viewbox(const Tvg_Paint* paint, float* x,
 }
 
 
+TVG_EXPORT Tvg_Result tvg_picture_set_filter(Tvg_Paint* paint, Tvg_Filter_Method method)
+{
+    if (!paint) return TVG_RESULT_INVALID_ARGUMENT;
+    return (Tvg_Result) reinterpret_cast<Picture*>(paint)->filter((FilterMethod)method);
+}
+
+
+TVG_EXPORT Tvg_Result tvg_picture_get_filter(const Tvg_Paint* paint, Tvg_Filter_Method* method)
+{
+    if (!paint || !method) return TVG_RESULT_INVALID_ARGUMENT;
+    *method = (Tvg_Filter_Method) reinterpret_cast<Picture*>(CCP(paint))->filter();
+    return TVG_RESULT_SUCCESS;
+}
+
+
 /************************************************************************/
 /* Gradient API                                                         */
 /************************************************************************/
@@ -471,6 +634,18 @@ TVG_EXPORT Tvg_Result tvg_radial_gradient_get(Tvg_Gradient* grad, float* cx, flo
     return (Tvg_Result) reinterpret_cast<RadialGradient*>(grad)->radial(cx, cy, radius);
 }
 
+TVG_EXPORT Tvg_Result tvg_radial_gradient_set_focal(Tvg_Gradient* grad, float fx, float fy)
+{
+    if (!grad) return TVG_RESULT_INVALID_ARGUMENT;
+    return (Tvg_Result) reinterpret_cast<RadialGradient*>(grad)->focal(fx, fy);
+}
+
+TVG_EXPORT Tvg_Result tvg_radial_gradient_get_focal(Tvg_Gradient* grad, float* fx, float* fy)
+{
+    if (!grad) return TVG_RESULT_INVALID_ARGUMENT;
+    return (Tvg_Result) reinterpret_cast<RadialGradient*>(grad)->focal(fx, fy);
+}
+
 TVG_EXPORT Tvg_Result tvg_gradient_set_color_stops(Tvg_Gradient* grad, const Tvg_Color_Stop* color_stop, uint32_t cnt)
 {
     if (!grad) return TVG_RESULT_INVALID_ARGUMENT;
@@ -521,6 +696,29 @@ TVG_EXPORT Tvg_Result tvg_scene_clear(Tvg_Paint* scene)
 }
 
 
+/************************************************************************/
+/* Saver API                                                            */
+/************************************************************************/
+
+TVG_EXPORT Tvg_Saver* tvg_saver_new()
+{
+    return (Tvg_Saver*) Saver::gen().release();
+}
+
+TVG_EXPORT Tvg_Result tvg_saver_save(Tvg_Saver* saver, Tvg_Paint* paint, const char* path)
+{
+    if (!saver || !paint || !path) return TVG_RESULT_INVALID_ARGUMENT;
+    return (Tvg_Result) reinterpret_cast<Saver*>(saver)->save(unique_ptr<Paint>((Paint*)paint), path);
+}
+
+TVG_EXPORT Tvg_Result tvg_saver_del(Tvg_Saver* saver)
+{
+    if (!saver) return TVG_RESULT_INVALID_ARGUMENT;
+    delete(reinterpret_cast<Saver*>(saver));
+    return TVG_RESULT_SUCCESS;
+}
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -166,6 +166,25 @@ void testCapi()
     tvg_paint_set_opacity(scene, 100);
 
     tvg_canvas_push(canvas, scene);
+
+    //Batch test - paints built and moved with one call each
+    Tvg_Paint* marks[3] = {tvg_shape_new(), tvg_shape_new(), tvg_shape_new()};
+    Tvg_Command cmds[6];
+    float args[24];
+    for (uint32_t i = 0; i < 3; ++i) {
+        cmds[i * 2] = (Tvg_Command) {.type=TVG_COMMAND_SHAPE_APPEND_CIRCLE, .paint=i};
+        cmds[i * 2 + 1] = (Tvg_Command) {.type=TVG_COMMAND_SHAPE_SET_FILL_COLOR, .paint=i};
+        float v[8] = {0, 0, 20, 20, 255, 80.0f * i, 0, 255};    //cx, cy, rx, ry, r, g, b, a
+        for (uint32_t j = 0; j < 8; ++j) args[i * 8 + j] = v[j];
+    }
+    tvg_paint_apply(marks, 3, cmds, 6, args, 24);
+
+    Tvg_Matrix placements[3] = {{1, 0, 450, 0, 1, 650, 0, 0, 1}, {1, 0, 500, 0, 1, 650, 0, 0, 1}, {1, 0, 550, 0, 1, 650, 0, 0, 1}};
+    uint8_t opacities[3] = {255, 180, 100};
+    tvg_paints_transform(marks, placements, 3);
+    tvg_paints_set_opacity(marks, opacities, 3);
+    for (uint32_t i = 0; i < 3; ++i) tvg_canvas_push(canvas, marks[i]);
+
     tvg_canvas_draw(canvas);
     tvg_canvas_sync(canvas);
 
@@ -108,18 +108,23 @@ struct SwOutline
     bool          opened;           //opened path?
 };
 
+//x is absolute rather than a delta on the previous span, the raster and clip functions take any span on its own.
 struct SwSpan
 {
-    int16_t x, y;
+    int32_t x;
     uint16_t len;
     uint8_t coverage;
 };
 
+//The spans are sorted by rows, the row y starts at the span rows[y - top].
 struct SwRleData
 {
     SwSpan *spans;
+    uint32_t *rows;         //the rows from top to bottom, the last entry ends the spans
+    SwCoord top, bottom;
     uint32_t alloc;
-    uint32_t size;
+    uint32_t size;          //number of the spans in the rows
+    uint32_t rowsAlloc;
 };
 
 struct SwBBox
@@ -138,6 +143,20 @@ struct SwStrokeBorder
     bool valid;
 };
 
+struct SwDashStroke
+{
+    float* lengths;             //arc lengths of the path segments, kept until the path is changed
+    uint32_t lengthsCnt;
+    uint32_t reservedLengthsCnt;
+    float curLen;
+    int32_t curIdx;
+    const float* pattern;
+    uint32_t cnt;
+    bool curOpGap;
+    bool drawing;               //a dash is being stroked
+    bool measured;              //lengths are valid
+};
+
 struct SwStroke
 {
     SwFixed angleIn;
@@ -157,22 +176,17 @@ struct SwStroke
 
     float sx, sy;
 
+    SwOutline cache;            //border outline stroked in the path space, scaled only
+    float scale;                //scale of the cache, zero if there is none
+
+    SwDashStroke dash;
+
     bool firstPt;
     bool openSubPath;
     bool handleWideStrokes;
 };
 
-struct SwDashStroke
-{
-    SwOutline* outline;
-    float curLen;
-    int32_t curIdx;
-    Point ptStart;
-    Point ptCur;
-    float* pattern;
-    uint32_t cnt;
-    bool curOpGap;
-};
+struct SwColorTable;
 
 struct SwFill
 {
@@ -183,9 +197,12 @@ struct SwFill
     };
 
     struct SwRadial {
-        float cx, cy;
-        float a;
-        float inv2a;
+        float a11, a12, a13;    //inverse transform, pixel to gradient space
+        float a21, a22, a23;
+        float fx, fy;           //focal point
+        float dx, dy;           //focal point to center
+        float a;                //radius^2 - |focal to center|^2
+        float inva;
     };
 
     union {
@@ -193,9 +210,10 @@ struct SwFill
         SwRadial radial;
     };
 
+    SwColorTable* table;        //shared among the fills of the same color stops
     uint32_t* ctable;
+    uint32_t size;              //color table entries
     FillSpread spread;
-    float sx, sy;
 
     bool translucent;
 };
@@ -209,7 +227,18 @@ struct SwShape
     SwRleData*   strokeRle = nullptr;
     SwBBox       bbox;
 
-    bool         rect;   //Fast Track: Othogonal rectangle?
+    bool         rect = false;   //Fast Track: Othogonal rectangle?
+};
+
+#define SW_MIPMAP_MAX 16
+
+//Box filtered levels of an image, each one is the half size of the previous one.
+struct SwMipmap
+{
+    uint32_t*       levels[SW_MIPMAP_MAX] = {nullptr, };    //levels[0] is the first half size level
+    uint32_t        cnt = 0;
+    uint32_t        level = 0;                              //level sampled by the drawing, 0 is the image itself
+    const uint32_t* src = nullptr;                          //image data the levels were made of
 };
 
 struct SwImage
@@ -220,17 +249,45 @@ struct SwImage
     SwBBox       bbox;
     uint32_t     width;
     uint32_t     height;
+    uint32_t     stride;
+    bool         opaque = false;      //no translucent pixels
+    FilterMethod filter = FilterMethod::Nearest;
+    SwMipmap     mipmap;
 };
 
 struct SwCompositor
 {
     uint32_t (*join)(uint8_t r, uint8_t g, uint8_t b, uint8_t a);
     uint32_t (*alpha)(uint32_t rgba);
+    uint32_t cs;                    //premultiplied 32 bits colorspace the drawings are blended in
 };
 
 struct SwSurface : Surface
 {
     SwCompositor comp;
+    uint32_t coverage;              //SwCanvas::Coverage of the A8 target
+};
+
+namespace tvg
+{
+    class SwRenderer;
+}
+
+//Offscreen render target of a composition.
+struct SwLayer
+{
+    SwSurface  surface;             //buffer is addressed in the canvas coordinates, valid in the region only
+    SwSurface* recover = nullptr;   //render target before this layer
+    void*      mem = nullptr;       //pooled memory of the pixels
+    uint32_t   size = 0;            //capacity of the memory in pixels
+    SwBBox     region;              //drawn area
+    uint32_t   generation = 0;      //render target the drawing was made for
+    size_t     charge = 0;          //bytes counted in the cache budget
+    tvg::SwRenderer* owner = nullptr;   //renderer keeping the drawing
+    bool       busy = false;        //used in the current frame of the owner, it's not dropped
+    bool       retain = false;      //keeps the drawing for the next frames
+    bool       valid = false;       //drawing is complete
+    bool       whole = false;       //nothing is cut by the edges of the render target
 };
 
 static inline SwCoord TO_SWCOORD(float val)
@@ -256,6 +313,12 @@ static inline uint8_t ALPHA_MULTIPLY(uint32_t c, uint32_t a)
     return (c * a) >> 8;
 }
 
+//First span of the row y, the row ends at the one of y + 1.
+static inline SwSpan* RLE_ROW(const SwRleData* rle, SwCoord y)
+{
+    return rle->spans + rle->rows[y - rle->top];
+}
+
 static inline SwCoord HALF_STROKE(float width)
 {
     return TO_SWCOORD(width * 0.5);
@@ -279,28 +342,36 @@ void shapeReset(SwShape* shape);
 bool shapeGenOutline(SwShape* shape, const Shape* sdata, unsigned tid, const Matrix* transform);
 bool shapePrepare(SwShape* shape, const Shape* sdata, unsigned tid, const SwSize& clip, const Matrix* transform);
 bool shapePrepared(SwShape* shape);
-bool shapeGenRle(SwShape* shape, const Shape* sdata, const SwSize& clip, bool antiAlias, bool hasComposite);
+bool shapeGenRle(SwShape* shape, const Shape* sdata, const SwSize& clip, bool antiAlias);
 void shapeDelOutline(SwShape* shape, uint32_t tid);
 void shapeResetStroke(SwShape* shape, const Shape* sdata, const Matrix* transform);
 bool shapeGenStrokeRle(SwShape* shape, const Shape* sdata, unsigned tid, const Matrix* transform, const SwSize& clip);
+bool shapeMoveStroke(SwShape* shape, unsigned tid, const Matrix* transform, const SwSize& clip);
 void shapeFree(SwShape* shape);
 void shapeDelStroke(SwShape* shape);
+void shapeResetDash(SwShape* shape);
 bool shapeGenFillColors(SwShape* shape, const Fill* fill, const Matrix* transform, SwSurface* surface, bool ctable);
 void shapeResetFill(SwShape* shape);
 void shapeDelFill(SwShape* shape);
 
 void strokeReset(SwStroke* stroke, const Shape* shape, const Matrix* transform);
 bool strokeParseOutline(SwStroke* stroke, const SwOutline& outline);
+bool strokeParseDash(SwStroke* stroke, const Shape* sdata, const Matrix* transform);
+void strokeResetDash(SwStroke* stroke);
 SwOutline* strokeExportOutline(SwStroke* stroke, unsigned tid);
+void strokeCacheOutline(SwStroke* stroke, const SwOutline* outline, float scale);
+SwOutline* strokeMoveOutline(SwStroke* stroke, const Matrix* transform, float scale, unsigned tid);
 void strokeFree(SwStroke* stroke);
 
 bool imagePrepare(SwImage* image, const Picture* pdata, unsigned tid, const SwSize& clip, const Matrix* transform);
 bool imagePrepared(SwImage* image);
-bool imageGenRle(SwImage* image, TVG_UNUSED const Picture* pdata, const SwSize& clip, bool antiAlias, bool hasComposite);
 void imageDelOutline(SwImage* image, uint32_t tid);
 void imageReset(SwImage* image);
 bool imageGenOutline(SwImage* image, const Picture* pdata, unsigned tid, const Matrix* transform);
 void imageFree(SwImage* image);
+bool imageGenMipmap(SwImage* image, const Matrix* transform);
+const uint32_t* imageMipmap(const SwImage* image, uint32_t* w, uint32_t* h);
+void imageResetMipmap(SwImage* image);
 
 bool fillGenColorTable(SwFill* fill, const Fill* fdata, const Matrix* transform, SwSurface* surface, bool ctable);
 void fillReset(SwFill* fill);
@@ -309,10 +380,11 @@ void fillFetchLinear(const SwFill* fill, uint32_t* dst, uint32_t y, uint32_t x,
 void fillFetchRadial(const SwFill* fill, uint32_t* dst, uint32_t y, uint32_t x, uint32_t len);
 
 SwRleData* rleRender(SwRleData* rle, const SwOutline* outline, const SwBBox& bbox, const SwSize& clip, bool antiAlias);
+SwRleData* rleHairline(SwRleData* rle, const SwOutline* outline, float width, const Matrix* transform, bool round, const SwSize& clip);
 void rleFree(SwRleData* rle);
 void rleReset(SwRleData* rle);
-void rleClipPath(SwRleData *rle, const SwRleData *clip);
-void rleClipRect(SwRleData *rle, const SwBBox* clip);
+SwRleData* rleClipRect(const SwRleData* rle, const SwBBox& clip, SwRleData* out, SwRleData* buffer);
+SwRleData* rleClipPath(const SwRleData* rle, const SwRleData* clip, SwRleData* out, SwRleData* buffer);
 
 bool mpoolInit(uint32_t threads);
 bool mpoolTerm();
@@ -328,6 +400,7 @@ bool rasterSolidShape(SwSurface* surface, SwShape* shape, uint8_t r, uint8_t g,
 bool rasterImage(SwSurface* surface, SwImage* image, uint8_t opacity, const Matrix* transform);
 bool rasterStroke(SwSurface* surface, SwShape* shape, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
 bool rasterClear(SwSurface* surface);
+bool rasterLayer(SwSurface* surface, const SwLayer* layer, const SwLayer* mask, bool inverse, uint32_t opacity);
 
 static inline void rasterRGBA32(uint32_t *dst, uint32_t val, uint32_t offset, int32_t len)
 {
@@ -21,6 +21,9 @@
  */
 #include <float.h>
 #include <math.h>
+#include <string.h>
+#include <mutex>
+#include <vector>
 #include "tvgSwCommon.h"
 
 
@@ -29,38 +32,80 @@
 /************************************************************************/
 
 #define GRADIENT_STOP_SIZE 1024
+#define GRADIENT_STOP_MIN_SIZE 64
 #define FIXPT_BITS 8
 #define FIXPT_SIZE (1<<FIXPT_BITS)
 
+/* Fills of the same color stops share a color table. The tables are kept
+   as long as any fill refers to them. */
+struct SwColorTable
+{
+    uint32_t* data;
+    Fill::ColorStop* stops;
+    uint32_t cnt;
+    uint32_t size;
+    uint32_t cs;
+    uint32_t hash;
+    uint32_t refCnt;
+    bool translucent;
+};
+
+static mutex tableMtx;
+static vector<SwColorTable*> tables;
 
-static bool _updateColorTable(SwFill* fill, const Fill* fdata, SwSurface* surface)
+
+static uint32_t _hash(const Fill::ColorStop* colors, uint32_t cnt, uint32_t size, uint32_t cs)
 {
-    if (!fill->ctable) {
-        fill->ctable = static_cast<uint32_t*>(malloc(GRADIENT_STOP_SIZE * sizeof(uint32_t)));
-        if (!fill->ctable) return false;
+    //FNV-1a
+    uint32_t hash = 2166136261u;
+    auto bytes = reinterpret_cast<const uint8_t*>(colors);
+    for (uint32_t i = 0; i < cnt * sizeof(Fill::ColorStop); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
     }
+    return (hash ^ size ^ (cs << 16)) * 16777619u;
+}
+
+
+static SwColorTable* _findTable(const Fill::ColorStop* colors, uint32_t cnt, uint32_t size, uint32_t cs, uint32_t hash)
+{
+    for (auto table : tables) {
+        if (table->hash != hash || table->cnt != cnt || table->size != size || table->cs != cs) continue;
+        if (memcmp(table->stops, colors, cnt * sizeof(Fill::ColorStop))) continue;
+        return table;
+    }
+    return nullptr;
+}
+
+
+static void _freeTable(SwColorTable* table)
+{
+    free(table->data);
+    free(table->stops);
+    free(table);
+}
 
-    const Fill::ColorStop* colors;
-    auto cnt = fdata->colorStops(&colors);
-    if (cnt == 0 || !colors) return false;
 
+static void _updateColorTable(SwColorTable* table, const Fill::ColorStop* colors, uint32_t cnt, SwSurface* surface)
+{
+    auto ctable = table->data;
+    auto size = table->size;
     auto pColors = colors;
 
-    if (pColors->a < 255) fill->translucent = true;
+    if (pColors->a < 255) table->translucent = true;
 
     auto r = ALPHA_MULTIPLY(pColors->r, pColors->a);
     auto g = ALPHA_MULTIPLY(pColors->g, pColors->a);
     auto b = ALPHA_MULTIPLY(pColors->b, pColors->a);
 
     auto rgba = surface->comp.join(r, g, b, pColors->a);
-    auto inc = 1.0f / static_cast<float>(GRADIENT_STOP_SIZE);
+    auto inc = 1.0f / static_cast<float>(size);
     auto pos = 1.5f * inc;
     uint32_t i = 0;
 
-    fill->ctable[i++] = rgba;
+    ctable[i++] = rgba;
 
     while (pos <= pColors->offset) {
-        fill->ctable[i] = fill->ctable[i - 1];
+        ctable[i] = ctable[i - 1];
         ++i;
         pos += inc;
     }
@@ -69,7 +114,7 @@ static bool _updateColorTable(SwFill* fill, const Fill* fdata, SwSurface* surfac
         auto curr = colors + j;
         auto next = curr + 1;
         auto delta = 1.0f / (next->offset - curr->offset);
-        if (next->a < 255) fill->translucent = true;
+        if (next->a < 255) table->translucent = true;
 
         auto r = ALPHA_MULTIPLY(next->r, next->a);
         auto g = ALPHA_MULTIPLY(next->g, next->a);
@@ -77,28 +122,103 @@ static bool _updateColorTable(SwFill* fill, const Fill* fdata, SwSurface* surfac
 
         auto rgba2 = surface->comp.join(r, g, b, next->a);
 
-        while (pos < next->offset && i < GRADIENT_STOP_SIZE) {
+        while (pos < next->offset && i < size) {
             auto t = (pos - curr->offset) * delta;
             auto dist = static_cast<int32_t>(256 * t);
             auto dist2 = 256 - dist;
-            fill->ctable[i] = COLOR_INTERPOLATE(rgba, dist2, rgba2, dist);
+            ctable[i] = COLOR_INTERPOLATE(rgba, dist2, rgba2, dist);
             ++i;
             pos += inc;
         }
         rgba = rgba2;
     }
 
-    for (; i < GRADIENT_STOP_SIZE; ++i)
-        fill->ctable[i] = rgba;
+    for (; i < size; ++i)
+        ctable[i] = rgba;
 
     //Make sure the lat color stop is represented at the end of the table
-    fill->ctable[GRADIENT_STOP_SIZE - 1] = rgba;
+    ctable[size - 1] = rgba;
+}
 
-    return true;
+
+static SwColorTable* _acquireTable(const Fill* fdata, uint32_t size, SwSurface* surface)
+{
+    const Fill::ColorStop* colors;
+    auto cnt = fdata->colorStops(&colors);
+    if (cnt == 0 || !colors) return nullptr;
+
+    auto hash = _hash(colors, cnt, size, surface->comp.cs);
+
+    {
+        lock_guard<mutex> lock(tableMtx);
+        auto table = _findTable(colors, cnt, size, surface->comp.cs, hash);
+        if (table) {
+            ++table->refCnt;
+            return table;
+        }
+    }
+
+    //Build a new one out of the lock, the other fills aren't held up.
+    auto table = static_cast<SwColorTable*>(calloc(1, sizeof(SwColorTable)));
+    if (!table) return nullptr;
+    table->data = static_cast<uint32_t*>(malloc(size * sizeof(uint32_t)));
+    table->stops = static_cast<Fill::ColorStop*>(malloc(cnt * sizeof(Fill::ColorStop)));
+    if (!table->data || !table->stops) {
+        _freeTable(table);
+        return nullptr;
+    }
+    memcpy(table->stops, colors, cnt * sizeof(Fill::ColorStop));
+    table->cnt = cnt;
+    table->size = size;
+    table->cs = surface->comp.cs;
+    table->hash = hash;
+    table->refCnt = 1;
+    _updateColorTable(table, colors, cnt, surface);
+
+    lock_guard<mutex> lock(tableMtx);
+
+    //Another fill might have built the same in the meantime.
+    auto other = _findTable(colors, cnt, size, surface->comp.cs, hash);
+    if (other) {
+        ++other->refCnt;
+        _freeTable(table);
+        return other;
+    }
+    tables.push_back(table);
+
+    return table;
 }
 
 
-bool _prepareLinear(SwFill* fill, const LinearGradient* linear, const Matrix* transform)
+static void _releaseTable(SwColorTable* table)
+{
+    if (!table) return;
+
+    lock_guard<mutex> lock(tableMtx);
+
+    if (--table->refCnt > 0) return;
+
+    for (auto itr = tables.begin(); itr != tables.end(); ++itr) {
+        if (*itr == table) {
+            *itr = tables.back();
+            tables.pop_back();
+            break;
+        }
+    }
+    _freeTable(table);
+}
+
+
+//The table needs no more entries than the pixels the gradient spans.
+static uint32_t _tableSize(float extent)
+{
+    uint32_t size = GRADIENT_STOP_MIN_SIZE;
+    while (size < GRADIENT_STOP_SIZE && static_cast<float>(size) < extent * 2.0f) size <<= 1;
+    return size;
+}
+
+
+bool _prepareLinear(SwFill* fill, const LinearGradient* linear, const Matrix* transform, float& extent)
 {
     float x1, x2, y1, y2;
     if (linear->linear(&x1, &y1, &x2, &y2) != Result::Success) return false;
@@ -121,6 +241,7 @@ bool _prepareLinear(SwFill* fill, const LinearGradient* linear, const Matrix* tr
     fill->linear.dx = x2 - x1;
     fill->linear.dy = y2 - y1;
     fill->linear.len = fill->linear.dx * fill->linear.dx + fill->linear.dy * fill->linear.dy;
+    extent = sqrt(fill->linear.len);
 
     if (fill->linear.len < FLT_EPSILON) return true;
 
@@ -132,35 +253,55 @@ bool _prepareLinear(SwFill* fill, const LinearGradient* linear, const Matrix* tr
 }
 
 
-bool _prepareRadial(SwFill* fill, const RadialGradient* radial, const Matrix* transform)
+bool _prepareRadial(SwFill* fill, const RadialGradient* radial, const Matrix* transform, float& extent)
 {
-    float radius;
-    if (radial->radial(&fill->radial.cx, &fill->radial.cy, &radius) != Result::Success) return false;
+    float cx, cy, radius, fx, fy;
+    if (radial->radial(&cx, &cy, &radius) != Result::Success) return false;
+    if (radial->focal(&fx, &fy) != Result::Success) return false;
+
+    extent = radius;
+    fill->radial.a = 0;
     if (radius < FLT_EPSILON) return true;
 
-    fill->sx = 1.0f;
-    fill->sy = 1.0f;
+    //Maps the pixel centers back to the gradient space, any affine transform is allowed.
+    auto& r = fill->radial;
+    r.a11 = 1.0f; r.a12 = 0.0f; r.a13 = 0.0f;
+    r.a21 = 0.0f; r.a22 = 1.0f; r.a23 = 0.0f;
 
     if (transform) {
-        auto tx = fill->radial.cx * transform->e11 + fill->radial.cy * transform->e12 + transform->e13;
-        auto ty = fill->radial.cx * transform->e21 + fill->radial.cy * transform->e22 + transform->e23;
-        fill->radial.cx = tx;
-        fill->radial.cy = ty;
-
-        auto sx = sqrt(pow(transform->e11, 2) + pow(transform->e21, 2));
-        auto sy = sqrt(pow(transform->e12, 2) + pow(transform->e22, 2));
-
-        //FIXME; Scale + Rotation is not working properly
-        radius *= sx;
+        auto det = transform->e11 * transform->e22 - transform->e12 * transform->e21;
+        if (fabsf(det) < FLT_EPSILON) return true;
+        auto invDet = 1.0f / det;
+        r.a11 = transform->e22 * invDet;
+        r.a12 = -transform->e12 * invDet;
+        r.a13 = (transform->e12 * transform->e23 - transform->e13 * transform->e22) * invDet;
+        r.a21 = -transform->e21 * invDet;
+        r.a22 = transform->e11 * invDet;
+        r.a23 = (transform->e21 * transform->e13 - transform->e11 * transform->e23) * invDet;
+
+        auto sx = sqrtf(transform->e11 * transform->e11 + transform->e21 * transform->e21);
+        auto sy = sqrtf(transform->e12 * transform->e12 + transform->e22 * transform->e22);
+        extent *= max(sx, sy);
+    }
 
-        if (abs(sx - sy) > FLT_EPSILON) {
-            fill->sx = sx;
-            fill->sy = sy;
-        }
+    //The focal point out of the circle is moved onto it, just inside to keep the cone open.
+    auto dx = cx - fx;
+    auto dy = cy - fy;
+    auto dist = sqrtf(dx * dx + dy * dy);
+    auto limit = radius * 0.99f;
+    if (dist > limit) {
+        dx *= limit / dist;
+        dy *= limit / dist;
+        fx = cx - dx;
+        fy = cy - dy;
     }
 
-    fill->radial.a = radius * radius;
-    fill->radial.inv2a = pow(1 / (2 * fill->radial.a), 2);
+    r.fx = fx;
+    r.fy = fy;
+    r.dx = dx;
+    r.dy = dy;
+    r.a = radius * radius - (dx * dx + dy * dy);
+    r.inva = 1.0f / r.a;
 
     return true;
 }
@@ -168,22 +309,24 @@ bool _prepareRadial(SwFill* fill, const RadialGradient* radial, const Matrix* tr
 
 static inline uint32_t _clamp(const SwFill* fill, int32_t pos)
 {
+    auto size = static_cast<int32_t>(fill->size);
+
     switch (fill->spread) {
         case FillSpread::Pad: {
-            if (pos >= GRADIENT_STOP_SIZE) pos = GRADIENT_STOP_SIZE - 1;
+            if (pos >= size) pos = size - 1;
             else if (pos < 0) pos = 0;
             break;
         }
         case FillSpread::Repeat: {
-            if (pos < 0) pos = GRADIENT_STOP_SIZE + pos;
-            pos = pos % GRADIENT_STOP_SIZE;
+            if (pos < 0) pos = size + pos;
+            pos = pos % size;
             break;
         }
         case FillSpread::Reflect: {
-            auto limit = GRADIENT_STOP_SIZE * 2;
+            auto limit = size * 2;
             pos = pos % limit;
             if (pos < 0) pos = limit + pos;
-            if (pos >= GRADIENT_STOP_SIZE) pos = (limit - pos - 1);
+            if (pos >= size) pos = (limit - pos - 1);
             break;
         }
     }
@@ -200,7 +343,7 @@ static inline uint32_t _fixedPixel(const SwFill* fill, int32_t pos)
 
 static inline uint32_t _pixel(const SwFill* fill, float pos)
 {
-    auto i = static_cast<int32_t>(pos * (GRADIENT_STOP_SIZE - 1) + 0.5f);
+    auto i = static_cast<int32_t>(pos * (fill->size - 1) + 0.5f);
     return fill->ctable[_clamp(fill, i)];
 }
 
@@ -209,23 +352,29 @@ static inline uint32_t _pixel(const SwFill* fill, float pos)
 /* External Class Implementation                                        */
 /************************************************************************/
 
+/* The color of a point p is the one of the largest t where p lies on the circle
+   interpolated from the focal point (t = 0) to the gradient circle (t = 1):
+   |q - t * d| = t * r, with q = p - focal, d = center - focal.
+   It comes to t = (sqrt(b^2 + a * |q|^2) - b) / a, with b = q.d, a = r^2 - |d|^2,
+   where q and b step linearly along the scanline. */
 void fillFetchRadial(const SwFill* fill, uint32_t* dst, uint32_t y, uint32_t x, uint32_t len)
 {
-    //Rotation
-    auto rx = (x + 0.5f - fill->radial.cx) * fill->sy;
-    auto ry = (y + 0.5f - fill->radial.cy) * fill->sx;
-    auto inv2a = fill->radial.inv2a;
-    auto rxy = rx * rx + ry * ry;
-    auto rxryPlus = 2 * rx;
-    auto det = (-4 * fill->radial.a * -rxy) * inv2a;
-    auto detDelta = (4 * fill->radial.a * (rxryPlus + 1.0f)) * inv2a;
-    auto detDelta2 = (4 * fill->radial.a * 2.0f) * inv2a;
-
-   for (uint32_t i = 0 ; i < len ; ++i) {
-        *dst = _pixel(fill, sqrt(det));
+    auto& r = fill->radial;
+
+    auto px = x + 0.5f;
+    auto py = y + 0.5f;
+    auto qx = r.a11 * px + r.a12 * py + r.a13 - r.fx;
+    auto qy = r.a21 * px + r.a22 * py + r.a23 - r.fy;
+    auto b = qx * r.dx + qy * r.dy;
+    auto db = r.a11 * r.dx + r.a21 * r.dy;
+
+    for (uint32_t i = 0 ; i < len ; ++i) {
+        auto det = b * b + r.a * (qx * qx + qy * qy);
+        *dst = _pixel(fill, (sqrtf(det) - b) * r.inva);
         ++dst;
-        det += detDelta;
-        detDelta += detDelta2;
+        qx += r.a11;
+        qy += r.a21;
+        b += db;
     }
 }
 
@@ -235,8 +384,8 @@ void fillFetchLinear(const SwFill* fill, uint32_t* dst, uint32_t y, uint32_t x,
     //Rotation
     float rx = x + 0.5f;
     float ry = y + 0.5f;
-    float t = (fill->linear.dx * rx + fill->linear.dy * ry + fill->linear.offset) * (GRADIENT_STOP_SIZE - 1);
-    float inc = (fill->linear.dx) * (GRADIENT_STOP_SIZE - 1);
+    float t = (fill->linear.dx * rx + fill->linear.dy * ry + fill->linear.offset) * (fill->size - 1);
+    float inc = (fill->linear.dx) * (fill->size - 1);
 
     if (abs(inc) < FLT_EPSILON) {
         auto color = _fixedPixel(fill, static_cast<int32_t>(t * FIXPT_SIZE));
@@ -262,7 +411,7 @@ void fillFetchLinear(const SwFill* fill, uint32_t* dst, uint32_t y, uint32_t x,
     //we have to fallback to float math
     } else {
         while (dst < dst + len) {
-            *dst = _pixel(fill, t / GRADIENT_STOP_SIZE);
+            *dst = _pixel(fill, t / fill->size);
             ++dst;
             t += inc;
         }
@@ -276,28 +425,38 @@ bool fillGenColorTable(SwFill* fill, const Fill* fdata, const Matrix* transform,
 
     fill->spread = fdata->spread();
 
-    if (ctable) {
-        if (!_updateColorTable(fill, fdata, surface)) return false;
-    }
+    auto extent = 0.0f;
 
     if (fdata->id() == FILL_ID_LINEAR) {
-        return _prepareLinear(fill, static_cast<const LinearGradient*>(fdata), transform);
+        if (!_prepareLinear(fill, static_cast<const LinearGradient*>(fdata), transform, extent)) return false;
     } else if (fdata->id() == FILL_ID_RADIAL) {
-        return _prepareRadial(fill, static_cast<const RadialGradient*>(fdata), transform);
+        if (!_prepareRadial(fill, static_cast<const RadialGradient*>(fdata), transform, extent)) return false;
+    } else {
+        //LOG: What type of gradient?!
+        return false;
     }
 
-    //LOG: What type of gradient?!
+    //The color stops are changed or the gradient is scaled.
+    auto size = _tableSize(extent);
+
+    if (ctable || !fill->table || fill->size != size) {
+        //Take the new one first, the same table is kept then.
+        auto table = _acquireTable(fdata, size, surface);
+        if (!table) return false;
+        _releaseTable(fill->table);
+        fill->table = table;
+        fill->ctable = table->data;
+        fill->size = size;
+        fill->translucent = table->translucent;
+    }
 
-    return false;
+    return true;
 }
 
 
 void fillReset(SwFill* fill)
 {
-    if (fill->ctable) {
-        free(fill->ctable);
-        fill->ctable = nullptr;
-    }
+    //The color table is swapped on the next generation, it might be shared by this one again.
     fill->translucent = false;
 }
 
@@ -306,7 +465,7 @@ void fillFree(SwFill* fill)
 {
     if (!fill) return;
 
-    if (fill->ctable) free(fill->ctable);
+    _releaseTable(fill->table);
 
     free(fill);
-}
\ No newline at end of file
+}
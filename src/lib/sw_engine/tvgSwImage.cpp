@@ -19,6 +19,7 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
+#include <float.h>
 #include <math.h>
 #include "tvgSwCommon.h"
 
@@ -74,6 +75,25 @@ static bool _updateBBox(SwOutline* outline, SwBBox& bbox, const SwSize& clip)
 }
 
 
+//Averages 2x2 premultiplied pixels into one, the last row/column is repeated for the odd sizes.
+static void _boxFilter(const uint32_t* src, uint32_t sw, uint32_t sh, uint32_t stride, uint32_t* dst, uint32_t dw, uint32_t dh)
+{
+    for (uint32_t y = 0; y < dh; ++y) {
+        auto row0 = src + min(y * 2, sh - 1) * stride;
+        auto row1 = src + min(y * 2 + 1, sh - 1) * stride;
+        for (uint32_t x = 0; x < dw; ++x) {
+            auto x0 = min(x * 2, sw - 1);
+            auto x1 = min(x * 2 + 1, sw - 1);
+            auto c0 = row0[x0], c1 = row0[x1], c2 = row1[x0], c3 = row1[x1];
+            //Two channels at once with 10 bits of headroom for each.
+            auto rb = (((c0 & 0x00ff00ff) + (c1 & 0x00ff00ff) + (c2 & 0x00ff00ff) + (c3 & 0x00ff00ff) + 0x00020002) >> 2) & 0x00ff00ff;
+            auto ag = ((((c0 >> 8) & 0x00ff00ff) + ((c1 >> 8) & 0x00ff00ff) + ((c2 >> 8) & 0x00ff00ff) + ((c3 >> 8) & 0x00ff00ff) + 0x00020002) << 6) & 0xff00ff00;
+            dst[y * dw + x] = ag | rb;
+        }
+    }
+}
+
+
 static bool _checkValid(const SwOutline* outline, const SwBBox& bbox, const SwSize& clip)
 {
     if (outline->ptsCnt == 0 || outline->cntrsCnt <= 0) return false;
@@ -108,14 +128,6 @@ bool imagePrepared(SwImage* image)
 }
 
 
-bool imageGenRle(SwImage* image, TVG_UNUSED const Picture* pdata, const SwSize& clip, bool antiAlias, bool hasComposite)
-{
-    if ((image->rle = rleRender(image->rle, image->outline, image->bbox, clip, antiAlias))) return true;
-
-    return false;
-}
-
-
 void imageDelOutline(SwImage* image, uint32_t tid)
 {
     mpoolRetOutline(tid);
@@ -172,4 +184,86 @@ bool imageGenOutline(SwImage* image, const Picture* pdata, unsigned tid, const M
 void imageFree(SwImage* image)
 {
     rleFree(image->rle);
+    imageResetMipmap(image);
+}
+
+
+void imageResetMipmap(SwImage* image)
+{
+    for (uint32_t i = 0; i < image->mipmap.cnt; ++i) {
+        free(image->mipmap.levels[i]);
+        image->mipmap.levels[i] = nullptr;
+    }
+    image->mipmap.cnt = 0;
+    image->mipmap.level = 0;
+    image->mipmap.src = nullptr;
+}
+
+
+bool imageGenMipmap(SwImage* image, const Matrix* transform)
+{
+    auto& mipmap = image->mipmap;
+    mipmap.level = 0;
+
+    if (image->filter != FilterMethod::Mipmap || !transform) return true;
+    if (!image->data || image->width == 0 || image->height == 0) return false;
+
+    //Source pixels stepped per target pixel, the column lengths of the inverse transform.
+    auto det = fabsf(transform->e11 * transform->e22 - transform->e12 * transform->e21);
+    if (det < FLT_EPSILON) return false;
+    auto sx = sqrtf(transform->e22 * transform->e22 + transform->e21 * transform->e21) / det;
+    auto sy = sqrtf(transform->e12 * transform->e12 + transform->e11 * transform->e11) / det;
+    auto scale = max(sx, sy);
+    if (scale < 2.0f) return true;
+
+    auto level = min(static_cast<uint32_t>(log2f(scale)), static_cast<uint32_t>(SW_MIPMAP_MAX));
+
+    //The image data is replaced.
+    if (mipmap.src != image->data) {
+        imageResetMipmap(image);
+        mipmap.src = image->data;
+    }
+
+    auto src = image->data;
+    auto sw = image->width;
+    auto sh = image->height;
+    auto stride = image->stride;
+
+    for (uint32_t i = 0; i < level; ++i) {
+        //Nothing to reduce anymore.
+        if (sw == 1 && sh == 1) break;
+
+        auto dw = max(sw >> 1, 1U);
+        auto dh = max(sh >> 1, 1U);
+
+        if (i == mipmap.cnt) {
+            auto dst = static_cast<uint32_t*>(malloc(sizeof(uint32_t) * dw * dh));
+            if (!dst) break;
+            _boxFilter(src, sw, sh, stride, dst, dw, dh);
+            mipmap.levels[i] = dst;
+            ++mipmap.cnt;
+        }
+
+        src = mipmap.levels[i];
+        sw = dw;
+        sh = dh;
+        stride = dw;
+        mipmap.level = i + 1;
+    }
+    return true;
+}
+
+
+const uint32_t* imageMipmap(const SwImage* image, uint32_t* w, uint32_t* h)
+{
+    auto& mipmap = image->mipmap;
+    if (mipmap.level == 0 || mipmap.src != image->data) return nullptr;
+
+    *w = image->width;
+    *h = image->height;
+    for (uint32_t i = 0; i < mipmap.level; ++i) {
+        *w = max(*w >> 1, 1U);
+        *h = max(*h >> 1, 1U);
+    }
+    return mipmap.levels[mipmap.level - 1];
 }
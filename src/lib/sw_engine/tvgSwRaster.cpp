@@ -23,6 +23,7 @@
 #include "tvgRender.h"
 #include <float.h>
 #include <math.h>
+#include <string.h>
 
 /************************************************************************/
 /* Internal Class Implementation                                        */
@@ -46,6 +47,116 @@ static uint32_t _argbJoin(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
 }
 
 
+/* Pixel formats of the target. The kernels blend in the premultiplied 32 bits colorspace of the compositor,
+   the formats convert the pixels on their load and store, there is no conversion pass over the target. */
+
+//ABGR8888, ARGB8888 and the layers
+struct SwPixel32
+{
+    using Pixel = uint32_t;
+    static constexpr bool direct = true;    //the fills write the target pixels as they are
+
+    static uint32_t load(Pixel p) { return p; }
+    static Pixel store(uint32_t c) { return c; }
+    static void fill(Pixel* dst, uint32_t c, uint32_t offset, uint32_t len) { rasterRGBA32(dst, c, offset, len); }
+    static void copy(Pixel* dst, const uint32_t* src, uint32_t len) { memcpy(dst, src, len * sizeof(uint32_t)); }
+};
+
+
+template<typename Format, typename P>
+struct SwPixelConvert
+{
+    using Pixel = P;
+    static constexpr bool direct = false;
+
+    static void fill(Pixel* dst, uint32_t c, uint32_t offset, uint32_t len)
+    {
+        auto p = Format::store(c);
+        dst += offset;
+        while (len--) *dst++ = p;
+    }
+
+    static void copy(Pixel* dst, const uint32_t* src, uint32_t len)
+    {
+        for (uint32_t i = 0; i < len; ++i) dst[i] = Format::store(src[i]);
+    }
+};
+
+
+//BGRA8888: the ARGB8888 rotated, the alpha is in the lowest byte.
+struct SwPixelBGRA : SwPixelConvert<SwPixelBGRA, uint32_t>
+{
+    static uint32_t load(Pixel p) { return (p >> 8) | (p << 24); }
+    static Pixel store(uint32_t c) { return (c << 8) | (c >> 24); }
+};
+
+
+//ABGR8888S: the ABGR8888 with the straight alpha.
+struct SwPixelStraight : SwPixelConvert<SwPixelStraight, uint32_t>
+{
+    static uint32_t load(Pixel p)
+    {
+        auto a = p >> 24;
+        if (a == 255 || a == 0) return a ? p : 0;
+        return (p & 0xff000000) | (ALPHA_BLEND(p, a + 1) & 0x00ffffff);
+    }
+
+    static Pixel store(uint32_t c)
+    {
+        auto a = c >> 24;
+        if (a == 255 || a == 0) return c;
+        auto r = min((c & 0xff) * 255 / a, 255u);
+        auto g = min(((c >> 8) & 0xff) * 255 / a, 255u);
+        auto b = min(((c >> 16) & 0xff) * 255 / a, 255u);
+        return (c & 0xff000000) | (b << 16) | (g << 8) | r;
+    }
+};
+
+
+//RGB565: the opaque 16 bits pixels.
+struct SwPixel565 : SwPixelConvert<SwPixel565, uint16_t>
+{
+    static uint32_t load(Pixel p)
+    {
+        auto r = (p >> 11) & 0x1f;
+        auto g = (p >> 5) & 0x3f;
+        auto b = p & 0x1f;
+        return 0xff000000 | ((r << 3 | r >> 2) << 16) | ((g << 2 | g >> 4) << 8) | (b << 3 | b >> 2);
+    }
+
+    static Pixel store(uint32_t c)
+    {
+        return static_cast<Pixel>(((c >> 8) & 0xf800) | ((c >> 5) & 0x07e0) | ((c >> 3) & 0x001f));
+    }
+};
+
+
+//A8: the alpha channel only.
+struct SwPixelA8 : SwPixelConvert<SwPixelA8, uint8_t>
+{
+    static uint32_t load(Pixel p) { return static_cast<uint32_t>(p) << 24; }
+    static Pixel store(uint32_t c) { return static_cast<Pixel>(c >> 24); }
+};
+
+
+//Instantiates the kernel for the pixel format of the target.
+#define SW_DISPATCH(surface, kernel, ...) \
+    switch ((surface)->cs) { \
+        case SwCanvas::BGRA8888: return kernel<SwPixelBGRA>(__VA_ARGS__); \
+        case SwCanvas::ABGR8888S: return kernel<SwPixelStraight>(__VA_ARGS__); \
+        case SwCanvas::RGB565: return kernel<SwPixel565>(__VA_ARGS__); \
+        case SwCanvas::A8: return kernel<SwPixelA8>(__VA_ARGS__); \
+        default: return kernel<SwPixel32>(__VA_ARGS__); \
+    }
+
+
+template<typename Dst>
+static typename Dst::Pixel* _address(SwSurface* surface, SwCoord x, SwCoord y)
+{
+    return reinterpret_cast<typename Dst::Pixel*>(surface->buffer) + y * surface->stride + x;
+}
+
+
 static void _inverse(const Matrix* transform, Matrix* invM)
 {
     // computes the inverse of a matrix m
@@ -67,19 +178,28 @@ static void _inverse(const Matrix* transform, Matrix* invM)
 }
 
 
-static bool _identify(const Matrix* transform)
+//Whole pixel translation, the nearest samples are the image pixels themselves.
+static bool _translation(const Matrix* transform, int32_t* tx, int32_t* ty)
 {
-    if (!transform ||
-        transform->e11 != 1.0f || transform->e12 != 0.0f || transform->e13 != 0.0f ||
-        transform->e21 != 0.0f || transform->e22 != 1.0f || transform->e23 != 0.0f ||
+    *tx = *ty = 0;
+
+    if (!transform) return true;
+
+    if (transform->e11 != 1.0f || transform->e12 != 0.0f || transform->e21 != 0.0f || transform->e22 != 1.0f ||
         transform->e31 != 0.0f || transform->e32 != 0.0f || transform->e33 != 1.0f)
         return false;
 
+    auto x = roundf(transform->e13);
+    auto y = roundf(transform->e23);
+    if (fabsf(transform->e13 - x) > 0.001f || fabsf(transform->e23 - y) > 0.001f) return false;
+
+    *tx = static_cast<int32_t>(x);
+    *ty = static_cast<int32_t>(y);
     return true;
 }
 
 
-static SwBBox _clipRegion(Surface* surface, SwBBox& in)
+static SwBBox _clipRegion(Surface* surface, const SwBBox& in)
 {
     auto bbox = in;
 
@@ -91,9 +211,10 @@ static SwBBox _clipRegion(Surface* surface, SwBBox& in)
     return bbox;
 }
 
+template<typename Dst>
 static bool _rasterTranslucentRect(SwSurface* surface, const SwBBox& region, uint32_t color)
 {
-    auto buffer = surface->buffer + (region.min.y * surface->stride) + region.min.x;
+    auto buffer = _address<Dst>(surface, region.min.x, region.min.y);
     auto h = static_cast<uint32_t>(region.max.y - region.min.y);
     auto w = static_cast<uint32_t>(region.max.x - region.min.x);
     auto ialpha = 255 - surface->comp.alpha(color);
@@ -101,154 +222,423 @@ static bool _rasterTranslucentRect(SwSurface* surface, const SwBBox& region, uin
     for (uint32_t y = 0; y < h; ++y) {
         auto dst = &buffer[y * surface->stride];
         for (uint32_t x = 0; x < w; ++x) {
-            dst[x] = color + ALPHA_BLEND(dst[x], ialpha);
+            dst[x] = Dst::store(color + ALPHA_BLEND(Dst::load(dst[x]), ialpha));
         }
     }
     return true;
 }
 
 
+template<typename Dst>
 static bool _rasterSolidRect(SwSurface* surface, const SwBBox& region, uint32_t color)
 {
-    auto buffer = surface->buffer + (region.min.y * surface->stride);
+    auto buffer = _address<Dst>(surface, 0, region.min.y);
     auto w = static_cast<uint32_t>(region.max.x - region.min.x);
     auto h = static_cast<uint32_t>(region.max.y - region.min.y);
 
     for (uint32_t y = 0; y < h; ++y) {
-        rasterRGBA32(buffer + y * surface->stride, color, region.min.x, w);
+        Dst::fill(buffer + y * surface->stride, color, region.min.x, w);
     }
     return true;
 }
 
 
+template<typename Dst>
 static bool _rasterTranslucentRle(SwSurface* surface, SwRleData* rle, uint32_t color)
 {
     if (!rle) return false;
 
-    auto span = rle->spans;
     uint32_t src;
 
-    for (uint32_t i = 0; i < rle->size; ++i) {
-        auto dst = &surface->buffer[span->y * surface->stride + span->x];
-        if (span->coverage < 255) src = ALPHA_BLEND(color, span->coverage);
-        else src = color;
-        auto ialpha = 255 - surface->comp.alpha(src);
-        for (uint32_t i = 0; i < span->len; ++i) {
-            dst[i] = src + ALPHA_BLEND(dst[i], ialpha);
+    for (auto y = rle->top; y < rle->bottom; ++y) {
+        auto rowEnd = RLE_ROW(rle, y + 1);
+        for (auto span = RLE_ROW(rle, y); span < rowEnd; ++span) {
+            auto dst = _address<Dst>(surface, span->x, y);
+            if (span->coverage < 255) src = ALPHA_BLEND(color, span->coverage);
+            else src = color;
+            auto ialpha = 255 - surface->comp.alpha(src);
+            for (uint32_t i = 0; i < span->len; ++i) {
+                dst[i] = Dst::store(src + ALPHA_BLEND(Dst::load(dst[i]), ialpha));
+            }
         }
-        ++span;
     }
     return true;
 }
 
 
-static bool _rasterTranslucentImageRle(SwSurface* surface, SwRleData* rle, uint32_t *img, uint32_t opacity, const Matrix* invTransform, uint32_t w, uint32_t h)
+/* Image sampling steps the inverse-transformed source position along a scanline
+   incrementally in 32.32 fixed point. The positions are biased by a half pixel,
+   so the integer part is the nearest source pixel. Each span is clipped against
+   the source rectangle once, the inner loops neither round nor check bounds. */
+
+#define SW_SAMPLE_BITS 32
+
+struct SwSampler
 {
-    auto span = rle->spans;
+    int64_t u, v;       //source position of the first sample
+    int64_t du, dv;     //step per destination pixel
+};
 
-    for (uint32_t i = 0; i < rle->size; ++i) {
-        for (uint32_t x = 0; x < span->len; ++x) {
-            auto rX = static_cast<uint32_t>(roundf((span->x + x) * invTransform->e11 + span->y * invTransform->e12 + invTransform->e13));
-            auto rY = static_cast<uint32_t>(roundf((span->x + x) * invTransform->e21 + span->y * invTransform->e22 + invTransform->e23));
 
-            if (rX < 0 || rX >= w || rY < 0 || rY >= h) continue;
+static int64_t _toSample(double v)
+{
+    return static_cast<int64_t>(floor(v * static_cast<double>(1LL << SW_SAMPLE_BITS)));
+}
 
-            auto dst = &surface->buffer[span->y * surface->stride + span->x + x];
-            auto index = rY * w + rX;        //TODO: need to use image's stride
-            if (dst && img && img[index]) {
-                auto alpha = ALPHA_MULTIPLY(span->coverage, opacity);
-                auto src = ALPHA_BLEND(img[index], alpha);
-                auto invAlpha = 255 - surface->comp.alpha(src);
-                *dst = src + ALPHA_BLEND(*dst, invAlpha);
-            }
+
+static bool _inside(int64_t p, int64_t limit)
+{
+    return p >= 0 && p < limit;
+}
+
+
+//Narrows [begin, end) down to the steps where the sample p + i * dp stays in [0, limit).
+static void _clipSamples(int64_t p, int64_t dp, int64_t limit, int32_t* begin, int32_t* end)
+{
+    if (*begin >= *end) return;
+
+    if (dp == 0) {
+        if (!_inside(p, limit)) *end = *begin;
+        return;
+    }
+
+    //A conservative estimation first, then it's fixed up with the exact samples.
+    auto t0 = static_cast<double>(-p) / dp;
+    auto t1 = static_cast<double>(limit - p) / dp;
+    if (t0 > t1) {
+        auto t = t0;
+        t0 = t1;
+        t1 = t;
+    }
+    auto lo = floor(t0) - 1;
+    auto hi = ceil(t1) + 1;
+    if (lo > *begin) *begin = (lo < *end) ? static_cast<int32_t>(lo) : *end;
+    if (hi < *end) *end = (hi > *begin) ? static_cast<int32_t>(hi) : *begin;
+
+    while (*begin < *end && !_inside(p + *begin * dp, limit)) ++(*begin);
+    while (*end > *begin && !_inside(p + (*end - 1) * dp, limit)) --(*end);
+}
+
+
+/* Prepares sampling the span of len pixels from (x, y), returns the steps [begin, end) hitting the image.
+   Bilinear samples keep the exact position, the fraction weights the neighbour pixels then. */
+static bool _sampleSpan(const Matrix* invTransform, int32_t x, int32_t y, int32_t len, uint32_t w, uint32_t h, SwSampler* sampler, int32_t* begin, int32_t* end, bool bilinear = false)
+{
+    sampler->u = _toSample(x * static_cast<double>(invTransform->e11) + y * static_cast<double>(invTransform->e12) + invTransform->e13 + 0.5);
+    sampler->v = _toSample(x * static_cast<double>(invTransform->e21) + y * static_cast<double>(invTransform->e22) + invTransform->e23 + 0.5);
+    sampler->du = _toSample(invTransform->e11);
+    sampler->dv = _toSample(invTransform->e21);
+
+    *begin = 0;
+    *end = len;
+    _clipSamples(sampler->u, sampler->du, static_cast<int64_t>(w) << SW_SAMPLE_BITS, begin, end);
+    _clipSamples(sampler->v, sampler->dv, static_cast<int64_t>(h) << SW_SAMPLE_BITS, begin, end);
+
+    if (*begin >= *end) return false;
+
+    sampler->u += *begin * sampler->du;
+    sampler->v += *begin * sampler->dv;
+
+    if (bilinear) {
+        sampler->u -= (1LL << (SW_SAMPLE_BITS - 1));
+        sampler->v -= (1LL << (SW_SAMPLE_BITS - 1));
+    }
+
+    return true;
+}
+
+
+//Transparent source pixels leave the destination untouched, it's a select rather than a branch.
+template<typename Dst>
+static void _blendSamples(typename Dst::Pixel* dst, const uint32_t* img, uint32_t stride, SwSampler& s, int32_t len)
+{
+    for (int32_t i = 0; i < len; ++i, s.u += s.du, s.v += s.dv) {
+        auto src = img[(s.v >> SW_SAMPLE_BITS) * stride + (s.u >> SW_SAMPLE_BITS)];
+        auto blended = Dst::store(src + ALPHA_BLEND(Dst::load(dst[i]), 255 - _colorAlpha(src)));
+        dst[i] = src ? blended : dst[i];
+    }
+}
+
+
+template<typename Dst>
+static void _blendSamples(typename Dst::Pixel* dst, const uint32_t* img, uint32_t stride, SwSampler& s, int32_t len, uint32_t alpha)
+{
+    for (int32_t i = 0; i < len; ++i, s.u += s.du, s.v += s.dv) {
+        auto pixel = img[(s.v >> SW_SAMPLE_BITS) * stride + (s.u >> SW_SAMPLE_BITS)];
+        auto src = ALPHA_BLEND(pixel, alpha);
+        auto blended = Dst::store(src + ALPHA_BLEND(Dst::load(dst[i]), 255 - _colorAlpha(src)));
+        dst[i] = pixel ? blended : dst[i];
+    }
+}
+
+
+//Interpolates the four neighbours of the sample, two channels are computed at once.
+template<typename Dst>
+static void _blendBilinearSamples(typename Dst::Pixel* dst, const uint32_t* img, uint32_t w, uint32_t h, uint32_t stride, SwSampler& s, int32_t len, uint32_t alpha)
+{
+    auto maxX = static_cast<int64_t>(w) - 1;
+    auto maxY = static_cast<int64_t>(h) - 1;
+
+    for (int32_t i = 0; i < len; ++i, s.u += s.du, s.v += s.dv) {
+        auto x0 = s.u >> SW_SAMPLE_BITS;
+        auto y0 = s.v >> SW_SAMPLE_BITS;
+        auto fx = static_cast<uint32_t>((s.u >> (SW_SAMPLE_BITS - 8)) & 0xff);
+        auto fy = static_cast<uint32_t>((s.v >> (SW_SAMPLE_BITS - 8)) & 0xff);
+        auto x1 = x0 + 1;
+        auto y1 = y0 + 1;
+
+        //Edge pixels are repeated outward.
+        x0 = x0 < 0 ? 0 : x0;
+        y0 = y0 < 0 ? 0 : y0;
+        x1 = x1 > maxX ? maxX : x1;
+        y1 = y1 > maxY ? maxY : y1;
+
+        auto row0 = img + y0 * stride;
+        auto row1 = img + y1 * stride;
+        auto top = COLOR_INTERPOLATE(row0[x0], 256 - fx, row0[x1], fx);
+        auto bottom = COLOR_INTERPOLATE(row1[x0], 256 - fx, row1[x1], fx);
+        auto src = COLOR_INTERPOLATE(top, 256 - fy, bottom, fy);
+        if (alpha < 255) src = ALPHA_BLEND(src, alpha);
+
+        auto blended = Dst::store(src + ALPHA_BLEND(Dst::load(dst[i]), 255 - _colorAlpha(src)));
+        dst[i] = src ? blended : dst[i];
+    }
+}
+
+
+template<typename Dst>
+static bool _rasterBilinearImageRle(SwSurface* surface, SwRleData* rle, const uint32_t *img, uint32_t opacity, const Matrix* invTransform, uint32_t w, uint32_t h, uint32_t stride)
+{
+    if (!rle || !img) return false;
+
+    SwSampler sampler;
+    int32_t begin, end;
+
+    for (auto y = rle->top; y < rle->bottom; ++y) {
+        auto rowEnd = RLE_ROW(rle, y + 1);
+        for (auto span = RLE_ROW(rle, y); span < rowEnd; ++span) {
+            if (!_sampleSpan(invTransform, span->x, y, span->len, w, h, &sampler, &begin, &end, true)) continue;
+            auto dst = _address<Dst>(surface, span->x + begin, y);
+            auto alpha = (opacity < 255) ? ALPHA_MULTIPLY(span->coverage, opacity) : span->coverage;
+            _blendBilinearSamples<Dst>(dst, img, w, h, stride, sampler, end - begin, alpha);
         }
-        ++span;
     }
     return true;
 }
 
 
-static bool _rasterImageRle(SwSurface* surface, SwRleData* rle, uint32_t *img, const Matrix* invTransform, uint32_t w, uint32_t h)
+template<typename Dst>
+static bool _rasterBilinearImage(SwSurface* surface, const uint32_t *img, uint32_t opacity, const SwBBox& region, const Matrix* invTransform, uint32_t w, uint32_t h, uint32_t stride)
 {
-    if (!rle) return false;
+    if (!img) return false;
 
-    auto span = rle->spans;
+    auto len = static_cast<int32_t>(region.max.x - region.min.x);
+    SwSampler sampler;
+    int32_t begin, end;
 
-    for (uint32_t i = 0; i < rle->size; ++i) {
-        for (uint32_t x = 0; x < span->len; ++x) {
-            auto rX = static_cast<uint32_t>(roundf((span->x + x) * invTransform->e11 + span->y * invTransform->e12 + invTransform->e13));
-            auto rY = static_cast<uint32_t>(roundf((span->x + x) * invTransform->e21 + span->y * invTransform->e22 + invTransform->e23));
+    for (auto y = region.min.y; y < region.max.y; ++y) {
+        if (!_sampleSpan(invTransform, region.min.x, y, len, w, h, &sampler, &begin, &end, true)) continue;
+        auto dst = _address<Dst>(surface, region.min.x + begin, y);
+        _blendBilinearSamples<Dst>(dst, img, w, h, stride, sampler, end - begin, opacity);
+    }
+    return true;
+}
 
-            if (rX < 0 || rX >= w || rY < 0 || rY >= h) continue;
 
-            auto dst = &surface->buffer[span->y * surface->stride + span->x + x];
-            auto index = rY * w + rX;        //TODO: need to use image's stride
-            if (dst && img && img[index]) {
-                auto src = ALPHA_BLEND(img[index], span->coverage);
-                auto invAlpha = 255 - surface->comp.alpha(src);
-                *dst = src + ALPHA_BLEND(*dst, invAlpha);
-            }
+//Maps the inverse transform onto the mipmap level picked at the preparation.
+static const uint32_t* _mipmap(const SwImage* image, Matrix* invTransform, uint32_t* w, uint32_t* h, uint32_t* stride)
+{
+    *stride = image->stride;
+
+    auto data = imageMipmap(image, w, h);
+    if (!data) {
+        *w = image->width;
+        *h = image->height;
+        return image->data;
+    }
+
+    //Generated levels are tightly packed.
+    *stride = *w;
+
+    //Pixel centers of the level: (i + 0.5) / ratio - 0.5 in the image.
+    auto rx = static_cast<float>(*w) / image->width;
+    auto ry = static_cast<float>(*h) / image->height;
+    invTransform->e11 *= rx;
+    invTransform->e12 *= rx;
+    invTransform->e13 = (invTransform->e13 + 0.5f) * rx - 0.5f;
+    invTransform->e21 *= ry;
+    invTransform->e22 *= ry;
+    invTransform->e23 = (invTransform->e23 + 0.5f) * ry - 0.5f;
+
+    return data;
+}
+
+
+template<typename Dst>
+static bool _rasterTranslucentImageRle(SwSurface* surface, SwRleData* rle, uint32_t *img, uint32_t opacity, const Matrix* invTransform, uint32_t w, uint32_t h, uint32_t stride)
+{
+    if (!rle || !img) return false;
+
+    SwSampler sampler;
+    int32_t begin, end;
+
+    for (auto y = rle->top; y < rle->bottom; ++y) {
+        auto rowEnd = RLE_ROW(rle, y + 1);
+        for (auto span = RLE_ROW(rle, y); span < rowEnd; ++span) {
+            if (!_sampleSpan(invTransform, span->x, y, span->len, w, h, &sampler, &begin, &end)) continue;
+            auto dst = _address<Dst>(surface, span->x + begin, y);
+            _blendSamples<Dst>(dst, img, stride, sampler, end - begin, ALPHA_MULTIPLY(span->coverage, opacity));
         }
-        ++span;
     }
     return true;
 }
 
 
-static bool _rasterTranslucentImage(SwSurface* surface, uint32_t *img, uint32_t opacity,const SwBBox& region, const Matrix* invTransform, uint32_t w, uint32_t h)
+template<typename Dst>
+static bool _rasterImageRle(SwSurface* surface, SwRleData* rle, uint32_t *img, const Matrix* invTransform, uint32_t w, uint32_t h, uint32_t stride)
 {
-    for (auto y = region.min.y; y < region.max.y; y++) {
-        for (auto x = region.min.x; x < region.max.x; x++) {
-            auto rX = static_cast<uint32_t>(roundf(x * invTransform->e11 + y * invTransform->e12 + invTransform->e13));
-            auto rY = static_cast<uint32_t>(roundf(x * invTransform->e21 + y * invTransform->e22 + invTransform->e23));
+    if (!rle || !img) return false;
 
-            if (rX < 0 || rX >= w || rY < 0 || rY >= h) continue;
+    SwSampler sampler;
+    int32_t begin, end;
 
-            auto dst = &surface->buffer[y * surface->stride + x];
-            auto index = rX + (rY * w); //TODO: need to use image's stride
-            if (dst && img && img[index]) {
-                auto src = ALPHA_BLEND(img[index], opacity);
-                auto invAlpha = 255 - surface->comp.alpha(src);
-                *dst = src + ALPHA_BLEND(*dst, invAlpha);
-            }
+    for (auto y = rle->top; y < rle->bottom; ++y) {
+        auto rowEnd = RLE_ROW(rle, y + 1);
+        for (auto span = RLE_ROW(rle, y); span < rowEnd; ++span) {
+            if (!_sampleSpan(invTransform, span->x, y, span->len, w, h, &sampler, &begin, &end)) continue;
+            auto dst = _address<Dst>(surface, span->x + begin, y);
+            _blendSamples<Dst>(dst, img, stride, sampler, end - begin, span->coverage);
         }
     }
     return true;
 }
 
 
-static bool _rasterImage(SwSurface* surface, uint32_t *img, const SwBBox& region, uint32_t w, uint32_t h)
+template<typename Dst>
+static bool _rasterTranslucentImage(SwSurface* surface, uint32_t *img, uint32_t opacity,const SwBBox& region, const Matrix* invTransform, uint32_t w, uint32_t h, uint32_t stride)
 {
-    for (auto y = region.min.y; y < region.max.y; y++) {
-        for (auto x = region.min.x; x < region.max.x; x++) {
-            auto dst = &surface->buffer[y * surface->stride + x];
-            auto index = x + (y * w); //TODO: need to use image's stride
-            if (dst && img && img[index]) {
-                auto src = img[index];
-                auto invAlpha = 255 - surface->comp.alpha(src);
-                *dst = src + ALPHA_BLEND(*dst, invAlpha);
-            }
+    if (!img) return false;
+
+    auto len = static_cast<int32_t>(region.max.x - region.min.x);
+    SwSampler sampler;
+    int32_t begin, end;
+
+    for (auto y = region.min.y; y < region.max.y; ++y) {
+        if (!_sampleSpan(invTransform, region.min.x, y, len, w, h, &sampler, &begin, &end)) continue;
+        auto dst = _address<Dst>(surface, region.min.x + begin, y);
+        _blendSamples<Dst>(dst, img, stride, sampler, end - begin, opacity);
+    }
+    return true;
+}
+
+
+//Intersects the region with the image placed at (tx, ty), returns false if nothing is left.
+static bool _imageRegion(const SwBBox& region, int32_t tx, int32_t ty, uint32_t w, uint32_t h, SwBBox* out)
+{
+    out->min.x = max(region.min.x, static_cast<SwCoord>(tx));
+    out->min.y = max(region.min.y, static_cast<SwCoord>(ty));
+    out->max.x = min(region.max.x, static_cast<SwCoord>(tx + static_cast<int32_t>(w)));
+    out->max.y = min(region.max.y, static_cast<SwCoord>(ty + static_cast<int32_t>(h)));
+    return (out->max.x > out->min.x && out->max.y > out->min.y);
+}
+
+
+template<typename Dst>
+static bool _rasterOpaqueImage(SwSurface* surface, uint32_t *img, const SwBBox& region, int32_t tx, int32_t ty, uint32_t w, uint32_t h, uint32_t stride)
+{
+    if (!img) return false;
+
+    SwBBox bbox;
+    if (!_imageRegion(region, tx, ty, w, h, &bbox)) return true;
+
+    auto len = static_cast<uint32_t>(bbox.max.x - bbox.min.x);
+
+    for (auto y = bbox.min.y; y < bbox.max.y; ++y) {
+        auto dst = _address<Dst>(surface, bbox.min.x, y);
+        auto src = img + (y - ty) * stride + (bbox.min.x - tx);
+        Dst::copy(dst, src, len);
+    }
+    return true;
+}
+
+
+template<typename Dst>
+static bool _rasterTranslucentImage(SwSurface* surface, uint32_t *img, uint32_t opacity, const SwBBox& region, int32_t tx, int32_t ty, uint32_t w, uint32_t h, uint32_t stride)
+{
+    if (!img) return false;
+
+    SwBBox bbox;
+    if (!_imageRegion(region, tx, ty, w, h, &bbox)) return true;
+
+    auto len = static_cast<uint32_t>(bbox.max.x - bbox.min.x);
+
+    for (auto y = bbox.min.y; y < bbox.max.y; ++y) {
+        auto dst = _address<Dst>(surface, bbox.min.x, y);
+        auto src = img + (y - ty) * stride + (bbox.min.x - tx);
+        for (uint32_t x = 0; x < len; ++x) {
+            auto tmp = ALPHA_BLEND(src[x], opacity);
+            dst[x] = Dst::store(tmp + ALPHA_BLEND(Dst::load(dst[x]), 255 - _colorAlpha(tmp)));
         }
     }
     return true;
 }
 
 
-static bool _rasterImage(SwSurface* surface, uint32_t *img, const SwBBox& region, const Matrix* invTransform, uint32_t w, uint32_t h)
+template<typename Dst>
+static bool _rasterImage(SwSurface* surface, uint32_t *img, const SwBBox& region, int32_t tx, int32_t ty, uint32_t w, uint32_t h, uint32_t stride)
 {
-    for (auto y = region.min.y; y < region.max.y; y++) {
-        for (auto x = region.min.x; x < region.max.x; x++) {
-            auto rX = static_cast<uint32_t>(roundf(x * invTransform->e11 + y * invTransform->e12 + invTransform->e13));
-            auto rY = static_cast<uint32_t>(roundf(x * invTransform->e21 + y * invTransform->e22 + invTransform->e23));
+    if (!img) return false;
+
+    SwBBox bbox;
+    if (!_imageRegion(region, tx, ty, w, h, &bbox)) return true;
+
+    auto len = static_cast<uint32_t>(bbox.max.x - bbox.min.x);
+
+    for (auto y = bbox.min.y; y < bbox.max.y; ++y) {
+        auto dst = _address<Dst>(surface, bbox.min.x, y);
+        auto src = img + (y - ty) * stride + (bbox.min.x - tx);
+        for (uint32_t x = 0; x < len; ++x) {
+            auto blended = Dst::store(src[x] + ALPHA_BLEND(Dst::load(dst[x]), 255 - _colorAlpha(src[x])));
+            dst[x] = src[x] ? blended : dst[x];
+        }
+    }
+    return true;
+}
 
-            if (rX < 0 || rX >= w || rY < 0 || rY >= h) continue;
 
-            auto dst = &surface->buffer[y * surface->stride + x];
-            auto index = rX + (rY * w); //TODO: need to use image's stride
-            if (dst && img && img[index]) {
-                auto src = img[index];
-                auto invAlpha = 255 - surface->comp.alpha(src);
-                *dst = src + ALPHA_BLEND(*dst, invAlpha);
+template<typename Dst>
+static bool _rasterImageRle(SwSurface* surface, SwRleData* rle, uint32_t *img, uint32_t opacity, bool opaque, int32_t tx, int32_t ty, uint32_t w, uint32_t h, uint32_t stride)
+{
+    if (!rle || !img) return false;
+
+    //The rows of the image
+    auto top = max(rle->top, static_cast<SwCoord>(ty));
+    auto bottom = min(rle->bottom, static_cast<SwCoord>(ty) + h);
+
+    for (auto y = top; y < bottom; ++y) {
+        auto rowEnd = RLE_ROW(rle, y + 1);
+        auto row = img + (y - ty) * stride;
+        for (auto span = RLE_ROW(rle, y); span < rowEnd; ++span) {
+            auto x0 = max(static_cast<int32_t>(span->x), tx);
+            auto x1 = min(static_cast<int32_t>(span->x + span->len), tx + static_cast<int32_t>(w));
+            if (x1 <= x0) continue;
+            auto dst = _address<Dst>(surface, x0, y);
+            auto src = row + (x0 - tx);
+            auto len = x1 - x0;
+            auto alpha = (opacity < 255) ? ALPHA_MULTIPLY(span->coverage, opacity) : span->coverage;
+            if (alpha == 255) {
+                if (opaque) {
+                    Dst::copy(dst, src, len);
+                } else {
+                    for (int32_t x = 0; x < len; ++x) {
+                        dst[x] = Dst::store(src[x] + ALPHA_BLEND(Dst::load(dst[x]), 255 - _colorAlpha(src[x])));
+                    }
+                }
+            } else {
+                for (int32_t x = 0; x < len; ++x) {
+                    auto tmp = ALPHA_BLEND(src[x], alpha);
+                    dst[x] = Dst::store(tmp + ALPHA_BLEND(Dst::load(dst[x]), 255 - _colorAlpha(tmp)));
+                }
             }
         }
     }
@@ -256,113 +646,160 @@ static bool _rasterImage(SwSurface* surface, uint32_t *img, const SwBBox& region
 }
 
 
-bool rasterImage(SwSurface* surface, SwImage* image, uint8_t opacity, const Matrix* transform)
+template<typename Dst>
+static bool _rasterImage(SwSurface* surface, uint32_t *img, const SwBBox& region, const Matrix* invTransform, uint32_t w, uint32_t h, uint32_t stride)
+{
+    if (!img) return false;
+
+    auto len = static_cast<int32_t>(region.max.x - region.min.x);
+    SwSampler sampler;
+    int32_t begin, end;
+
+    for (auto y = region.min.y; y < region.max.y; ++y) {
+        if (!_sampleSpan(invTransform, region.min.x, y, len, w, h, &sampler, &begin, &end)) continue;
+        auto dst = _address<Dst>(surface, region.min.x + begin, y);
+        _blendSamples<Dst>(dst, img, stride, sampler, end - begin);
+    }
+    return true;
+}
+
+
+template<typename Dst>
+static bool _rasterImage(SwSurface* surface, SwImage* image, uint8_t opacity, const Matrix* transform)
 {
     Matrix invTransform = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
     if (transform) _inverse(transform, &invTransform);
+
+    //Fast track: the pixel aligned image is copied or blended as it is, filtering makes no difference.
+    int32_t tx, ty;
+    if (_translation(transform, &tx, &ty)) {
+        if (image->rle) return _rasterImageRle<Dst>(surface, image->rle, image->data, opacity, image->opaque, tx, ty, image->width, image->height, image->stride);
+        auto region = _clipRegion(surface, image->bbox);
+        if (opacity < 255) return _rasterTranslucentImage<Dst>(surface, image->data, opacity, region, tx, ty, image->width, image->height, image->stride);
+        if (image->opaque) return _rasterOpaqueImage<Dst>(surface, image->data, region, tx, ty, image->width, image->height, image->stride);
+        return _rasterImage<Dst>(surface, image->data, region, tx, ty, image->width, image->height, image->stride);
+    }
+
+    if (image->filter != FilterMethod::Nearest) {
+        const uint32_t* data = image->data;
+        auto w = image->width;
+        auto h = image->height;
+        auto stride = image->stride;
+        if (image->filter == FilterMethod::Mipmap) data = _mipmap(image, &invTransform, &w, &h, &stride);
+        if (image->rle) return _rasterBilinearImageRle<Dst>(surface, image->rle, data, opacity, &invTransform, w, h, stride);
+        return _rasterBilinearImage<Dst>(surface, data, opacity, image->bbox, &invTransform, w, h, stride);
+    }
+
     if (image->rle) {
-        if (opacity < 255) return _rasterTranslucentImageRle(surface, image->rle, image->data, opacity, &invTransform, image->width, image->height );
-        return _rasterImageRle(surface, image->rle, image->data, &invTransform, image->width, image->height );
+        if (opacity < 255) return _rasterTranslucentImageRle<Dst>(surface, image->rle, image->data, opacity, &invTransform, image->width, image->height, image->stride);
+        return _rasterImageRle<Dst>(surface, image->rle, image->data, &invTransform, image->width, image->height, image->stride);
     }
     else {
-        // Fast track
-        if (_identify(transform)) {
-            return _rasterImage(surface, image->data, image->bbox, image->width, image->height);
-        }
-        else {
-            if (opacity < 255) return _rasterTranslucentImage(surface, image->data, opacity, image->bbox, &invTransform, image->width, image->height);
-            return _rasterImage(surface, image->data, image->bbox, &invTransform, image->width, image->height);
-        }
+        if (opacity < 255) return _rasterTranslucentImage<Dst>(surface, image->data, opacity, image->bbox, &invTransform, image->width, image->height, image->stride);
+        return _rasterImage<Dst>(surface, image->data, image->bbox, &invTransform, image->width, image->height, image->stride);
     }
 }
 
 
+template<typename Dst>
 static bool _rasterSolidRle(SwSurface* surface, SwRleData* rle, uint32_t color)
 {
     if (!rle) return false;
 
-    auto span = rle->spans;
-
-    for (uint32_t i = 0; i < rle->size; ++i) {
-        if (span->coverage == 255) {
-            rasterRGBA32(surface->buffer + span->y * surface->stride, color, span->x, span->len);
-        } else {
-            auto dst = &surface->buffer[span->y * surface->stride + span->x];
-            auto src = ALPHA_BLEND(color, span->coverage);
-            auto ialpha = 255 - span->coverage;
-            for (uint32_t i = 0; i < span->len; ++i) {
-                dst[i] = src + ALPHA_BLEND(dst[i], ialpha);
+    for (auto y = rle->top; y < rle->bottom; ++y) {
+        auto rowEnd = RLE_ROW(rle, y + 1);
+        for (auto span = RLE_ROW(rle, y); span < rowEnd; ++span) {
+            if (span->coverage == 255) {
+                Dst::fill(_address<Dst>(surface, 0, y), color, span->x, span->len);
+            } else {
+                auto dst = _address<Dst>(surface, span->x, y);
+                auto src = ALPHA_BLEND(color, span->coverage);
+                auto ialpha = 255 - span->coverage;
+                for (uint32_t i = 0; i < span->len; ++i) {
+                    dst[i] = Dst::store(src + ALPHA_BLEND(Dst::load(dst[i]), ialpha));
+                }
             }
         }
-        ++span;
     }
     return true;
 }
 
 
+template<typename Dst>
 static bool _rasterLinearGradientRect(SwSurface* surface, const SwBBox& region, const SwFill* fill)
 {
     if (!fill || fill->linear.len < FLT_EPSILON) return false;
 
-    auto buffer = surface->buffer + (region.min.y * surface->stride) + region.min.x;
+    auto buffer = _address<Dst>(surface, region.min.x, region.min.y);
     auto h = static_cast<uint32_t>(region.max.y - region.min.y);
     auto w = static_cast<uint32_t>(region.max.x - region.min.x);
 
+    auto tmpBuf = static_cast<uint32_t*>(alloca(surface->w * sizeof(uint32_t)));
+    if (!tmpBuf) return false;
+
     //Translucent Gradient
     if (fill->translucent) {
-
-        auto tmpBuf = static_cast<uint32_t*>(alloca(surface->w * sizeof(uint32_t)));
-        if (!tmpBuf) return false;
-
         for (uint32_t y = 0; y < h; ++y) {
             auto dst = &buffer[y * surface->stride];
             fillFetchLinear(fill, tmpBuf, region.min.y + y, region.min.x, 0, w);
             for (uint32_t x = 0; x < w; ++x) {
-                dst[x] = tmpBuf[x] + ALPHA_BLEND(dst[x], 255 - surface->comp.alpha(tmpBuf[x]));
+                dst[x] = Dst::store(tmpBuf[x] + ALPHA_BLEND(Dst::load(dst[x]), 255 - surface->comp.alpha(tmpBuf[x])));
             }
         }
     //Opaque Gradient
     } else {
         for (uint32_t y = 0; y < h; ++y) {
-            fillFetchLinear(fill, buffer + y * surface->stride, region.min.y + y, region.min.x, 0, w);
+            auto dst = &buffer[y * surface->stride];
+            if (Dst::direct) {
+                fillFetchLinear(fill, reinterpret_cast<uint32_t*>(dst), region.min.y + y, region.min.x, 0, w);
+            } else {
+                fillFetchLinear(fill, tmpBuf, region.min.y + y, region.min.x, 0, w);
+                Dst::copy(dst, tmpBuf, w);
+            }
         }
     }
     return true;
 }
 
 
+template<typename Dst>
 static bool _rasterRadialGradientRect(SwSurface* surface, const SwBBox& region, const SwFill* fill)
 {
     if (!fill || fill->radial.a < FLT_EPSILON) return false;
 
-    auto buffer = surface->buffer + (region.min.y * surface->stride) + region.min.x;
+    auto buffer = _address<Dst>(surface, region.min.x, region.min.y);
     auto h = static_cast<uint32_t>(region.max.y - region.min.y);
     auto w = static_cast<uint32_t>(region.max.x - region.min.x);
 
+    auto tmpBuf = static_cast<uint32_t*>(alloca(surface->w * sizeof(uint32_t)));
+    if (!tmpBuf) return false;
+
     //Translucent Gradient
     if (fill->translucent) {
-
-        auto tmpBuf = static_cast<uint32_t*>(alloca(surface->w * sizeof(uint32_t)));
-        if (!tmpBuf) return false;
-
         for (uint32_t y = 0; y < h; ++y) {
             auto dst = &buffer[y * surface->stride];
             fillFetchRadial(fill, tmpBuf, region.min.y + y, region.min.x, w);
             for (uint32_t x = 0; x < w; ++x) {
-                dst[x] = tmpBuf[x] + ALPHA_BLEND(dst[x], 255 - surface->comp.alpha(tmpBuf[x]));
+                dst[x] = Dst::store(tmpBuf[x] + ALPHA_BLEND(Dst::load(dst[x]), 255 - surface->comp.alpha(tmpBuf[x])));
             }
         }
     //Opaque Gradient
     } else {
         for (uint32_t y = 0; y < h; ++y) {
             auto dst = &buffer[y * surface->stride];
-            fillFetchRadial(fill, dst, region.min.y + y, region.min.x, w);
+            if (Dst::direct) {
+                fillFetchRadial(fill, reinterpret_cast<uint32_t*>(dst), region.min.y + y, region.min.x, w);
+            } else {
+                fillFetchRadial(fill, tmpBuf, region.min.y + y, region.min.x, w);
+                Dst::copy(dst, tmpBuf, w);
+            }
         }
     }
     return true;
 }
 
 
+template<typename Dst>
 static bool _rasterLinearGradientRle(SwSurface* surface, SwRleData* rle, const SwFill* fill)
 {
     if (!rle || !fill || fill->linear.len < FLT_EPSILON) return false;
@@ -370,45 +807,53 @@ static bool _rasterLinearGradientRle(SwSurface* surface, SwRleData* rle, const S
     auto buf = static_cast<uint32_t*>(alloca(surface->w * sizeof(uint32_t)));
     if (!buf) return false;
 
-    auto span = rle->spans;
-
     //Translucent Gradient
     if (fill->translucent) {
-        for (uint32_t i = 0; i < rle->size; ++i) {
-            auto dst = &surface->buffer[span->y * surface->stride + span->x];
-            fillFetchLinear(fill, buf, span->y, span->x, 0, span->len);
-            if (span->coverage == 255) {
-                for (uint32_t i = 0; i < span->len; ++i) {
-                    dst[i] = buf[i] + ALPHA_BLEND(dst[i], 255 - surface->comp.alpha(buf[i]));
-                }
-            } else {
-                for (uint32_t i = 0; i < span->len; ++i) {
-                    auto tmp = ALPHA_BLEND(buf[i], span->coverage);
-                    dst[i] = tmp + ALPHA_BLEND(dst[i], 255 - surface->comp.alpha(tmp));
+        for (auto y = rle->top; y < rle->bottom; ++y) {
+            auto rowEnd = RLE_ROW(rle, y + 1);
+            for (auto span = RLE_ROW(rle, y); span < rowEnd; ++span) {
+                auto dst = _address<Dst>(surface, span->x, y);
+                fillFetchLinear(fill, buf, y, span->x, 0, span->len);
+                if (span->coverage == 255) {
+                    for (uint32_t i = 0; i < span->len; ++i) {
+                        dst[i] = Dst::store(buf[i] + ALPHA_BLEND(Dst::load(dst[i]), 255 - surface->comp.alpha(buf[i])));
+                    }
+                } else {
+                    for (uint32_t i = 0; i < span->len; ++i) {
+                        auto tmp = ALPHA_BLEND(buf[i], span->coverage);
+                        dst[i] = Dst::store(tmp + ALPHA_BLEND(Dst::load(dst[i]), 255 - surface->comp.alpha(tmp)));
+                    }
                 }
             }
-            ++span;
         }
     //Opaque Gradient
     } else {
-        for (uint32_t i = 0; i < rle->size; ++i) {
-            if (span->coverage == 255) {
-                fillFetchLinear(fill, surface->buffer + span->y * surface->stride, span->y, span->x, span->x, span->len);
-            } else {
-                auto dst = &surface->buffer[span->y * surface->stride + span->x];
-                fillFetchLinear(fill, buf, span->y, span->x, 0, span->len);
-                auto ialpha = 255 - span->coverage;
-                for (uint32_t i = 0; i < span->len; ++i) {
-                    dst[i] = ALPHA_BLEND(buf[i], span->coverage) + ALPHA_BLEND(dst[i], ialpha);
+        for (auto y = rle->top; y < rle->bottom; ++y) {
+            auto rowEnd = RLE_ROW(rle, y + 1);
+            for (auto span = RLE_ROW(rle, y); span < rowEnd; ++span) {
+                auto dst = _address<Dst>(surface, span->x, y);
+                if (span->coverage == 255) {
+                    if (Dst::direct) {
+                        fillFetchLinear(fill, reinterpret_cast<uint32_t*>(_address<Dst>(surface, 0, y)), y, span->x, span->x, span->len);
+                    } else {
+                        fillFetchLinear(fill, buf, y, span->x, 0, span->len);
+                        Dst::copy(dst, buf, span->len);
+                    }
+                } else {
+                    fillFetchLinear(fill, buf, y, span->x, 0, span->len);
+                    auto ialpha = 255 - span->coverage;
+                    for (uint32_t i = 0; i < span->len; ++i) {
+                        dst[i] = Dst::store(ALPHA_BLEND(buf[i], span->coverage) + ALPHA_BLEND(Dst::load(dst[i]), ialpha));
+                    }
                 }
             }
-            ++span;
         }
     }
     return true;
 }
 
 
+template<typename Dst>
 static bool _rasterRadialGradientRle(SwSurface* surface, SwRleData* rle, const SwFill* fill)
 {
     if (!rle || !fill || fill->radial.a < FLT_EPSILON) return false;
@@ -416,112 +861,344 @@ static bool _rasterRadialGradientRle(SwSurface* surface, SwRleData* rle, const S
     auto buf = static_cast<uint32_t*>(alloca(surface->w * sizeof(uint32_t)));
     if (!buf) return false;
 
-    auto span = rle->spans;
-
     //Translucent Gradient
     if (fill->translucent) {
-        for (uint32_t i = 0; i < rle->size; ++i) {
-            auto dst = &surface->buffer[span->y * surface->stride + span->x];
-            fillFetchRadial(fill, buf, span->y, span->x, span->len);
-            if (span->coverage == 255) {
-                for (uint32_t i = 0; i < span->len; ++i) {
-                    dst[i] = buf[i] + ALPHA_BLEND(dst[i], 255 - surface->comp.alpha(buf[i]));
-                }
-            } else {
-                for (uint32_t i = 0; i < span->len; ++i) {
-                    auto tmp = ALPHA_BLEND(buf[i], span->coverage);
-                    dst[i] = tmp + ALPHA_BLEND(dst[i], 255 - surface->comp.alpha(tmp));
+        for (auto y = rle->top; y < rle->bottom; ++y) {
+            auto rowEnd = RLE_ROW(rle, y + 1);
+            for (auto span = RLE_ROW(rle, y); span < rowEnd; ++span) {
+                auto dst = _address<Dst>(surface, span->x, y);
+                fillFetchRadial(fill, buf, y, span->x, span->len);
+                if (span->coverage == 255) {
+                    for (uint32_t i = 0; i < span->len; ++i) {
+                        dst[i] = Dst::store(buf[i] + ALPHA_BLEND(Dst::load(dst[i]), 255 - surface->comp.alpha(buf[i])));
+                    }
+                } else {
+                    for (uint32_t i = 0; i < span->len; ++i) {
+                        auto tmp = ALPHA_BLEND(buf[i], span->coverage);
+                        dst[i] = Dst::store(tmp + ALPHA_BLEND(Dst::load(dst[i]), 255 - surface->comp.alpha(tmp)));
+                    }
                 }
             }
-            ++span;
         }
     //Opaque Gradient
     } else {
-        for (uint32_t i = 0; i < rle->size; ++i) {
-            auto dst = &surface->buffer[span->y * surface->stride + span->x];
-            if (span->coverage == 255) {
-                fillFetchRadial(fill, dst, span->y, span->x, span->len);
-            } else {
-                fillFetchRadial(fill, buf, span->y, span->x, span->len);
-                auto ialpha = 255 - span->coverage;
-                for (uint32_t i = 0; i < span->len; ++i) {
-                    dst[i] = ALPHA_BLEND(buf[i], span->coverage) + ALPHA_BLEND(dst[i], ialpha);
+        for (auto y = rle->top; y < rle->bottom; ++y) {
+            auto rowEnd = RLE_ROW(rle, y + 1);
+            for (auto span = RLE_ROW(rle, y); span < rowEnd; ++span) {
+                auto dst = _address<Dst>(surface, span->x, y);
+                if (span->coverage == 255) {
+                    if (Dst::direct) {
+                        fillFetchRadial(fill, reinterpret_cast<uint32_t*>(dst), y, span->x, span->len);
+                    } else {
+                        fillFetchRadial(fill, buf, y, span->x, span->len);
+                        Dst::copy(dst, buf, span->len);
+                    }
+                } else {
+                    fillFetchRadial(fill, buf, y, span->x, span->len);
+                    auto ialpha = 255 - span->coverage;
+                    for (uint32_t i = 0; i < span->len; ++i) {
+                        dst[i] = Dst::store(ALPHA_BLEND(buf[i], span->coverage) + ALPHA_BLEND(Dst::load(dst[i]), ialpha));
+                    }
                 }
             }
-            ++span;
         }
     }
     return true;
 }
 
 
-/************************************************************************/
-/* External Class Implementation                                        */
-/************************************************************************/
+/* Coverage methods of the A8 target. The spans are written as they are, neither the colors
+   nor the blending are involved. */
 
-bool rasterCompositor(SwSurface* surface)
+struct SwCoverageMax
 {
-    if (surface->cs == SwCanvas::ABGR8888) {
-        surface->comp.alpha = _colorAlpha;
-        surface->comp.join = _abgrJoin;
-    } else if (surface->cs == SwCanvas::ARGB8888) {
-        surface->comp.alpha = _colorAlpha;
-        surface->comp.join = _argbJoin;
-    } else {
-        //What Color Space ???
-        return false;
+    static uint8_t combine(uint8_t dst, uint8_t src) { return dst > src ? dst : src; }
+};
+
+
+struct SwCoverageAdd
+{
+    static uint8_t combine(uint8_t dst, uint8_t src)
+    {
+        auto v = static_cast<uint32_t>(dst) + src;
+        return v > 255 ? 255 : v;
+    }
+};
+
+
+template<typename Op>
+static void _combineCoverage(uint8_t* dst, uint8_t src, uint32_t len)
+{
+    //Full coverage saturates both of the methods.
+    if (src == 255) {
+        memset(dst, 255, len);
+        return;
+    }
+    for (uint32_t i = 0; i < len; ++i) dst[i] = Op::combine(dst[i], src);
+}
+
+
+template<typename Op>
+static bool _rasterCoverage(SwSurface* surface, const SwShape* rect, const SwRleData* rle, uint32_t alpha)
+{
+    if (rect) {
+        auto region = _clipRegion(surface, rect->bbox);
+        if (region.max.x <= region.min.x) return true;
+        auto len = static_cast<uint32_t>(region.max.x - region.min.x);
+        for (auto y = region.min.y; y < region.max.y; ++y) {
+            _combineCoverage<Op>(_address<SwPixelA8>(surface, region.min.x, y), alpha, len);
+        }
+        return true;
     }
 
+    if (!rle) return false;
+
+    for (auto y = rle->top; y < rle->bottom; ++y) {
+        auto rowEnd = RLE_ROW(rle, y + 1);
+        for (auto span = RLE_ROW(rle, y); span < rowEnd; ++span) {
+            //Either of them is taken as it is when the other one is full.
+            auto src = (alpha < 255 && span->coverage < 255) ? ALPHA_MULTIPLY(span->coverage, alpha) : min(static_cast<uint32_t>(span->coverage), alpha);
+            _combineCoverage<Op>(_address<SwPixelA8>(surface, span->x, y), src, span->len);
+        }
+    }
     return true;
 }
 
 
-bool rasterGradientShape(SwSurface* surface, SwShape* shape, unsigned id)
+//Draws the coverage of the rect, or of the spans, unless the drawings are blended over.
+static bool _coverage(SwSurface* surface, const SwShape* rect, const SwRleData* rle, uint32_t alpha, bool* ret)
+{
+    if (surface->cs != SwCanvas::A8 || surface->coverage == SwCanvas::Over) return false;
+
+    if (surface->coverage == SwCanvas::Max) *ret = _rasterCoverage<SwCoverageMax>(surface, rect, rle, alpha);
+    else *ret = _rasterCoverage<SwCoverageAdd>(surface, rect, rle, alpha);
+
+    return true;
+}
+
+
+//The alpha of the gradient varies over the pixels, it's fetched along.
+template<typename Op>
+static void _combineGradient(SwSurface* surface, const SwFill* fill, unsigned id, uint8_t* dst, uint32_t* buf, uint32_t x, uint32_t y, uint32_t len, uint8_t coverage)
+{
+    if (id == FILL_ID_LINEAR) fillFetchLinear(fill, buf, y, x, 0, len);
+    else fillFetchRadial(fill, buf, y, x, len);
+
+    for (uint32_t i = 0; i < len; ++i) {
+        auto src = surface->comp.alpha(buf[i]);
+        if (coverage < 255) src = ALPHA_MULTIPLY(src, coverage);
+        dst[i] = Op::combine(dst[i], src);
+    }
+}
+
+
+template<typename Op>
+static bool _rasterGradientCoverage(SwSurface* surface, const SwShape* shape, unsigned id)
+{
+    auto fill = shape->fill;
+    if (!fill) return false;
+    if (id == FILL_ID_LINEAR && fill->linear.len < FLT_EPSILON) return false;
+    if (id == FILL_ID_RADIAL && fill->radial.a < FLT_EPSILON) return false;
+
+    //Opaque gradients cover as much as the solid colors.
+    if (!fill->translucent) return _rasterCoverage<Op>(surface, shape->rect ? shape : nullptr, shape->rle, 255);
+
+    auto buf = static_cast<uint32_t*>(alloca(surface->w * sizeof(uint32_t)));
+    if (!buf) return false;
+
+    if (shape->rect) {
+        auto region = _clipRegion(surface, shape->bbox);
+        if (region.max.x <= region.min.x) return true;
+        auto len = static_cast<uint32_t>(region.max.x - region.min.x);
+        for (auto y = region.min.y; y < region.max.y; ++y) {
+            _combineGradient<Op>(surface, fill, id, _address<SwPixelA8>(surface, region.min.x, y), buf, region.min.x, y, len, 255);
+        }
+        return true;
+    }
+
+    auto rle = shape->rle;
+    if (!rle) return false;
+
+    for (auto y = rle->top; y < rle->bottom; ++y) {
+        auto rowEnd = RLE_ROW(rle, y + 1);
+        for (auto span = RLE_ROW(rle, y); span < rowEnd; ++span) {
+            _combineGradient<Op>(surface, fill, id, _address<SwPixelA8>(surface, span->x, y), buf, span->x, y, span->len, span->coverage);
+        }
+    }
+    return true;
+}
+
+
+template<typename Dst>
+static bool _rasterGradientShape(SwSurface* surface, SwShape* shape, unsigned id)
 {
     //Fast Track
     if (shape->rect) {
         auto region = _clipRegion(surface, shape->bbox);
-        if (id == FILL_ID_LINEAR) return _rasterLinearGradientRect(surface, region, shape->fill);
-        return _rasterRadialGradientRect(surface, region, shape->fill);
+        if (id == FILL_ID_LINEAR) return _rasterLinearGradientRect<Dst>(surface, region, shape->fill);
+        return _rasterRadialGradientRect<Dst>(surface, region, shape->fill);
     } else {
-        if (id == FILL_ID_LINEAR) return _rasterLinearGradientRle(surface, shape->rle, shape->fill);
-        return _rasterRadialGradientRle(surface, shape->rle, shape->fill);
+        if (id == FILL_ID_LINEAR) return _rasterLinearGradientRle<Dst>(surface, shape->rle, shape->fill);
+        return _rasterRadialGradientRle<Dst>(surface, shape->rle, shape->fill);
     }
     return false;
 }
 
 
+template<typename Dst>
+static bool _rasterSolidShape(SwSurface* surface, SwShape* shape, uint32_t color, uint8_t a)
+{
+    //Fast Track
+    if (shape->rect) {
+        auto region = _clipRegion(surface, shape->bbox);
+        if (a == 255) return _rasterSolidRect<Dst>(surface, region, color);
+        return _rasterTranslucentRect<Dst>(surface, region, color);
+    } else{
+        if (a == 255) return _rasterSolidRle<Dst>(surface, shape->rle, color);
+        return _rasterTranslucentRle<Dst>(surface, shape->rle, color);
+    }
+    return false;
+}
+
+
+template<typename Dst>
+static bool _rasterStroke(SwSurface* surface, SwShape* shape, uint32_t color, uint8_t a)
+{
+    if (a == 255) return _rasterSolidRle<Dst>(surface, shape->strokeRle, color);
+    return _rasterTranslucentRle<Dst>(surface, shape->strokeRle, color);
+}
+
+
+template<typename Dst>
+static bool _rasterClear(SwSurface* surface)
+{
+    auto buffer = _address<Dst>(surface, 0, 0);
+
+    if (surface->w == surface->stride) {
+        Dst::fill(buffer, 0x00000000, 0, surface->w * surface->h);
+    } else {
+        for (uint32_t i = 0; i < surface->h; i++) {
+            Dst::fill(buffer + surface->stride * i, 0x00000000, 0, surface->w);
+        }
+    }
+    return true;
+}
+
+
+template<typename Dst>
+static bool _rasterLayer(SwSurface* surface, const SwLayer* layer, const SwLayer* mask, bool inverse, uint32_t opacity, const SwBBox& region)
+{
+    auto src = layer->surface.buffer;
+    auto stride = layer->surface.stride;
+
+    for (auto y = region.min.y; y < region.max.y; ++y) {
+        auto dst = _address<Dst>(surface, 0, y);
+        auto s = &src[y * stride];
+
+        //Translucent blending
+        if (!mask) {
+            for (auto x = region.min.x; x < region.max.x; ++x) {
+                if (!s[x]) continue;
+                auto tmp = (opacity < 255) ? ALPHA_BLEND(s[x], opacity) : s[x];
+                dst[x] = Dst::store(tmp + ALPHA_BLEND(Dst::load(dst[x]), 255 - surface->comp.alpha(tmp)));
+            }
+            continue;
+        }
+
+        //Masked blending, the mask is transparent out of its region.
+        auto inside = (y >= mask->region.min.y && y < mask->region.max.y);
+        auto m = inside ? &mask->surface.buffer[y * mask->surface.stride] : nullptr;
+        for (auto x = region.min.x; x < region.max.x; ++x) {
+            uint32_t alpha = 0;
+            if (inside && x >= mask->region.min.x && x < mask->region.max.x) alpha = surface->comp.alpha(m[x]);
+            if (inverse) alpha = 255 - alpha;
+            if (opacity < 255) alpha = ALPHA_MULTIPLY(alpha, opacity);
+            if (alpha == 0 || !s[x]) continue;
+            auto tmp = (alpha < 255) ? ALPHA_BLEND(s[x], alpha) : s[x];
+            dst[x] = Dst::store(tmp + ALPHA_BLEND(Dst::load(dst[x]), 255 - surface->comp.alpha(tmp)));
+        }
+    }
+    return true;
+}
+
+
+/************************************************************************/
+/* External Class Implementation                                        */
+/************************************************************************/
+
+bool rasterCompositor(SwSurface* surface)
+{
+    //The drawings are blended in the premultiplied colorspace of the same channel order.
+    switch (surface->cs) {
+        case SwCanvas::ABGR8888:
+        case SwCanvas::ABGR8888S: {
+            surface->comp.join = _abgrJoin;
+            surface->comp.cs = SwCanvas::ABGR8888;
+            break;
+        }
+        case SwCanvas::ARGB8888:
+        case SwCanvas::BGRA8888:
+        case SwCanvas::RGB565:
+        case SwCanvas::A8: {
+            surface->comp.join = _argbJoin;
+            surface->comp.cs = SwCanvas::ARGB8888;
+            break;
+        }
+        default: {
+            //What Color Space ???
+            return false;
+        }
+    }
+    surface->comp.alpha = _colorAlpha;
+
+    return true;
+}
+
+
+bool rasterGradientShape(SwSurface* surface, SwShape* shape, unsigned id)
+{
+    if (surface->cs == SwCanvas::A8 && surface->coverage != SwCanvas::Over) {
+        if (surface->coverage == SwCanvas::Max) return _rasterGradientCoverage<SwCoverageMax>(surface, shape, id);
+        return _rasterGradientCoverage<SwCoverageAdd>(surface, shape, id);
+    }
+
+    SW_DISPATCH(surface, _rasterGradientShape, surface, shape, id);
+}
+
+
 bool rasterSolidShape(SwSurface* surface, SwShape* shape, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
 {
+    bool ret;
+    if (_coverage(surface, shape->rect ? shape : nullptr, shape->rle, a, &ret)) return ret;
+
     r = ALPHA_MULTIPLY(r, a);
     g = ALPHA_MULTIPLY(g, a);
     b = ALPHA_MULTIPLY(b, a);
 
     auto color = surface->comp.join(r, g, b, a);
 
-    //Fast Track
-    if (shape->rect) {
-        auto region = _clipRegion(surface, shape->bbox);
-        if (a == 255) return _rasterSolidRect(surface, region, color);
-        return _rasterTranslucentRect(surface, region, color);
-    } else{
-        if (a == 255) return _rasterSolidRle(surface, shape->rle, color);
-        return _rasterTranslucentRle(surface, shape->rle, color);
-    }
-    return false;
+    SW_DISPATCH(surface, _rasterSolidShape, surface, shape, color, a);
 }
 
 
 bool rasterStroke(SwSurface* surface, SwShape* shape, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
 {
+    bool ret;
+    if (_coverage(surface, nullptr, shape->strokeRle, a, &ret)) return ret;
+
     r = ALPHA_MULTIPLY(r, a);
     g = ALPHA_MULTIPLY(g, a);
     b = ALPHA_MULTIPLY(b, a);
 
     auto color = surface->comp.join(r, g, b, a);
 
-    if (a == 255) return _rasterSolidRle(surface, shape->strokeRle, color);
-    return _rasterTranslucentRle(surface, shape->strokeRle, color);
+    SW_DISPATCH(surface, _rasterStroke, surface, shape, color, a);
+}
+
+
+bool rasterImage(SwSurface* surface, SwImage* image, uint8_t opacity, const Matrix* transform)
+{
+    SW_DISPATCH(surface, _rasterImage, surface, image, opacity, transform);
 }
 
 
@@ -529,12 +1206,27 @@ bool rasterClear(SwSurface* surface)
 {
     if (!surface || !surface->buffer || surface->stride <= 0 || surface->w <= 0 || surface->h <= 0) return false;
 
-    if (surface->w == surface->stride) {
-        rasterRGBA32(surface->buffer, 0x00000000, 0, surface->w * surface->h);
-    } else {
-        for (uint32_t i = 0; i < surface->h; i++) {
-            rasterRGBA32(surface->buffer + surface->stride * i, 0x00000000, 0, surface->w);
-        }
+    SW_DISPATCH(surface, _rasterClear, surface);
+}
+
+
+bool rasterLayer(SwSurface* surface, const SwLayer* layer, const SwLayer* mask, bool inverse, uint32_t opacity)
+{
+    auto region = layer->region;
+
+    //Moved drawings can be partly out of the target.
+    region.min.x = max(region.min.x, static_cast<SwCoord>(0));
+    region.min.y = max(region.min.y, static_cast<SwCoord>(0));
+    region.max.x = min(region.max.x, static_cast<SwCoord>(surface->w));
+    region.max.y = min(region.max.y, static_cast<SwCoord>(surface->h));
+
+    //Nothing is visible out of the mask.
+    if (mask && !inverse) {
+        region.min.x = max(region.min.x, mask->region.min.x);
+        region.min.y = max(region.min.y, mask->region.min.y);
+        region.max.x = min(region.max.x, mask->region.max.x);
+        region.max.y = min(region.max.y, mask->region.max.y);
     }
-    return true;
+
+    SW_DISPATCH(surface, _rasterLayer, surface, layer, mask, inverse, opacity, region);
 }
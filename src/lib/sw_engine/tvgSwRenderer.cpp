@@ -19,6 +19,8 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
+#include <algorithm>
+#include <mutex>
 #include "tvgSwCommon.h"
 #include "tvgTaskScheduler.h"
 #include "tvgSwRenderer.h"
@@ -29,6 +31,102 @@
 static bool initEngine = false;
 static uint32_t rendererCnt = 0;
 
+//Maximum number of the free layer memory kept for reuse.
+#define SW_LAYER_POOL 8
+
+//Default memory budget of the retained layers over all the renderers.
+#define SW_CACHE_BUDGET (32 * 1024 * 1024)
+
+static mutex cacheMtx;
+static size_t cacheLimit = SW_CACHE_BUDGET;
+static size_t cacheUsage = 0;
+static vector<SwLayer*> cacheList;              //retained layers of all the renderers, least recently used first
+
+
+//Grows the bbox to cover the spans.
+static void _merge(SwBBox& bbox, const SwRleData* rle, bool& valid)
+{
+    if (!rle) return;
+
+    for (auto y = rle->top; y < rle->bottom; ++y) {
+        auto rowEnd = RLE_ROW(rle, y + 1);
+        for (auto span = RLE_ROW(rle, y); span < rowEnd; ++span) {
+            if (!valid) {
+                bbox.min.x = span->x;
+                bbox.min.y = y;
+                bbox.max.x = span->x + span->len;
+                bbox.max.y = y + 1;
+                valid = true;
+                continue;
+            }
+            if (span->x < bbox.min.x) bbox.min.x = span->x;
+            if (y < bbox.min.y) bbox.min.y = y;
+            if (span->x + span->len > bbox.max.x) bbox.max.x = span->x + span->len;
+            if (y + 1 > bbox.max.y) bbox.max.y = y + 1;
+        }
+    }
+}
+
+
+//Worth rasterizing on another worker
+static bool _large(const SwBBox& bbox)
+{
+    constexpr auto LARGE_PIXELS = 256 * 256;
+
+    return TaskScheduler::threads() > 0 && (bbox.max.x - bbox.min.x) * (bbox.max.y - bbox.min.y) >= LARGE_PIXELS;
+}
+
+
+//Layer pixels start at the 32 bytes boundary of the memory.
+static uint32_t* _pixels(void* mem)
+{
+    return reinterpret_cast<uint32_t*>((reinterpret_cast<uintptr_t>(mem) + 31) & ~static_cast<uintptr_t>(31));
+}
+
+
+//Snapshot of a drawing, the paint might be updated during the rasterization.
+struct SwDrawing
+{
+    SwShape shape;
+    SwImage image;
+    Matrix transform;
+    bool picture = false;
+    bool transformed = false;
+    bool gradient = false;
+    uint32_t fillId = 0;
+    uint8_t color[4] = {0, 0, 0, 0};        //opacity applied
+    uint8_t stroke[4] = {0, 0, 0, 0};       //opacity applied
+    uint32_t opacity = 255;
+    uint32_t clip = 0;                      //first clip path of the drawing
+    uint32_t clipCnt = 0;
+};
+
+
+//Frame rasterized to one of the target buffers while the next one is prepared.
+struct SwFrame : Task
+{
+    SwSurface surface;
+    vector<SwDrawing> drawings;
+    vector<SwShape> clips;                  //clip paths of the drawings
+    uint32_t id = 0;
+    bool started = false;
+
+    //Engine data replaced by the updates during the rasterization.
+    vector<SwRleData*> rles;
+    vector<SwFill*> fills;
+    vector<uint32_t*> levels;
+
+    ~SwFrame()
+    {
+        for (auto rle : rles) rleFree(rle);
+        for (auto fill : fills) fillFree(fill);
+        for (auto level : levels) free(level);
+    }
+
+    void run(unsigned tid) override;
+};
+
+
 struct SwTask : Task
 {
     Matrix* transform = nullptr;
@@ -36,8 +134,25 @@ struct SwTask : Task
     RenderUpdateFlag flags = RenderUpdateFlag::None;
     vector<Composite> compList;
     uint32_t opacity;
+    uint32_t pinned = 0;                        //last frame drawing the engine data
 
     virtual bool dispose() = 0;
+    virtual bool bounds(SwBBox& bbox) = 0;      //area to be drawn
+    virtual void retire(SwFrame* frame) = 0;    //hands the engine data over to the frame
+};
+
+
+//Fill of a large stroked shape rasterized on another worker while the stroke is made.
+struct SwFillRleTask : Task
+{
+    SwShape* shape;
+    SwSize clip;
+    bool antiAlias;
+
+    void run(TVG_UNUSED unsigned tid) override
+    {
+        shapeGenRle(shape, nullptr, clip, antiAlias);
+    }
 };
 
 
@@ -45,6 +160,7 @@ struct SwShapeTask : SwTask
 {
     SwShape shape;
     const Shape* sdata = nullptr;
+    SwFillRleTask filler;
 
     void run(unsigned tid) override
     {
@@ -77,7 +193,12 @@ struct SwShapeTask : SwTask
                        shape outline below stroke could be full covered by stroke drawing.
                        Thus it turns off antialising in that condition. */
                     auto antiAlias = (strokeAlpha > 0 && strokeWidth > 2) ? false : true;
-                    if (!shapeGenRle(&shape, sdata, clip, antiAlias, compList.size() > 0 ? true : false)) goto end;
+                    if (strokeAlpha > 0 && (flags & (RenderUpdateFlag::Stroke | RenderUpdateFlag::Transform)) && _large(shape.bbox)) {
+                        filler.shape = &shape;
+                        filler.clip = clip;
+                        filler.antiAlias = antiAlias;
+                        TaskScheduler::request(&filler);
+                    } else if (!shapeGenRle(&shape, sdata, clip, antiAlias)) goto end;
                 }
             }
         }
@@ -96,27 +217,21 @@ struct SwShapeTask : SwTask
         //Stroke
         if (flags & (RenderUpdateFlag::Stroke | RenderUpdateFlag::Transform)) {
             if (strokeAlpha > 0) {
-                shapeResetStroke(&shape, sdata, transform);
-                if (!shapeGenStrokeRle(&shape, sdata, tid, transform, clip)) goto end;
+                //Moved only, the stroke outline made before is placed again.
+                auto moved = !(flags & (RenderUpdateFlag::Path | RenderUpdateFlag::Stroke | RenderUpdateFlag::All)) && shapeMoveStroke(&shape, tid, transform, clip);
+                if (!moved) {
+                    //dash lengths are measured on the path
+                    if (flags & (RenderUpdateFlag::Path | RenderUpdateFlag::All)) shapeResetDash(&shape);
+                    shapeResetStroke(&shape, sdata, transform);
+                    if (!shapeGenStrokeRle(&shape, sdata, tid, transform, clip)) goto end;
+                }
             } else {
                 shapeDelStroke(&shape);
             }
         }
 
-        //Composition
-        for (auto comp : compList) {
-             SwShape *compShape = &static_cast<SwShapeTask*>(comp.edata)->shape;
-             if (comp.method == CompositeMethod::ClipPath) {
-                  //Clip to fill(path) rle
-                  if (shape.rle && compShape->rect) rleClipRect(shape.rle, &compShape->bbox);
-                  else if (shape.rle && compShape->rle) rleClipPath(shape.rle, compShape->rle);
-
-                  //Clip to stroke rle
-                  if (shape.strokeRle && compShape->rect) rleClipRect(shape.strokeRle, &compShape->bbox);
-                  else if (shape.strokeRle && compShape->rle) rleClipPath(shape.strokeRle, compShape->rle);
-             }
-        }
     end:
+        filler.done();
         shapeDelOutline(&shape, tid);
     }
 
@@ -125,6 +240,32 @@ struct SwShapeTask : SwTask
        shapeFree(&shape);
        return true;
     }
+
+    void retire(SwFrame* frame) override
+    {
+        if (shape.rle) frame->rles.push_back(shape.rle);
+        if (shape.strokeRle) frame->rles.push_back(shape.strokeRle);
+        if (shape.fill) frame->fills.push_back(shape.fill);
+        shape.rle = nullptr;
+        shape.strokeRle = nullptr;
+        shape.fill = nullptr;
+        shape.rect = false;
+        pinned = 0;
+    }
+
+    bool bounds(SwBBox& bbox) override
+    {
+        if (opacity == 0) return false;
+
+        auto valid = false;
+        if (shape.rect) {
+            bbox = shape.bbox;
+            valid = true;
+        }
+        _merge(bbox, shape.rle, valid);
+        _merge(bbox, shape.strokeRle, valid);
+        return valid;
+    }
 };
 
 
@@ -133,6 +274,8 @@ struct SwImageTask : SwTask
     SwImage image;
     const Picture* pdata = nullptr;
     uint32_t *pixels = nullptr;
+    uint32_t stride = 0;
+    bool opaque = false;
 
     void run(unsigned tid) override
     {
@@ -145,23 +288,20 @@ struct SwImageTask : SwTask
         if (prepareImage) {
             imageReset(&image);
             if (!imagePrepare(&image, pdata, tid, clip, transform)) goto end;
+        }
 
-            if (compList.size() > 0) {
-                if (!imageGenRle(&image, pdata, clip, false, true)) goto end;
-
-                //Composition
-                for (auto comp : compList) {
-                     SwShape *compShape = &static_cast<SwShapeTask*>(comp.edata)->shape;
-                     if (comp.method == CompositeMethod::ClipPath) {
-                          //Clip to fill(path) rle
-                          if (image.rle && compShape->rect) rleClipRect(image.rle, &compShape->bbox);
-                          else if (image.rle && compShape->rle) rleClipPath(image.rle, compShape->rle);
-                     }
-                }
-            }
+        if (this->pixels) {
+            image.data = this->pixels;
+            image.stride = this->stride;
+            image.opaque = this->opaque;
         }
+        image.filter = pdata->filter();
+
+        //Pixels might be changed, the levels are regenerated.
+        if (flags & RenderUpdateFlag::Image) imageResetMipmap(&image);
 
-        if (this->pixels) image.data = this->pixels;
+        //Levels are made here, the rasterization only reads them.
+        imageGenMipmap(&image, transform);
     end:
         imageDelOutline(&image, tid);
     }
@@ -171,9 +311,182 @@ struct SwImageTask : SwTask
        imageFree(&image);
        return true;
     }
+
+    void retire(SwFrame* frame) override
+    {
+        auto& mipmap = image.mipmap;
+        for (uint32_t i = 0; i < mipmap.cnt; ++i) {
+            frame->levels.push_back(mipmap.levels[i]);
+            mipmap.levels[i] = nullptr;
+        }
+        mipmap.cnt = 0;
+        mipmap.level = 0;
+        mipmap.src = nullptr;
+        pinned = 0;
+    }
+
+    bool bounds(SwBBox& bbox) override
+    {
+        if (!image.data) return false;
+
+        auto valid = false;
+        if (image.rle) _merge(bbox, image.rle, valid);
+        else {
+            bbox = image.bbox;
+            valid = true;
+        }
+        return valid;
+    }
 };
 
 
+//Buffer for the clipped spans, the other one if the spans are in it.
+static SwRleData* _clipBuffer(SwRleData** buffers, const SwRleData* rle)
+{
+    for (auto i = 0; i < 2; ++i) {
+        if (!buffers[i]) buffers[i] = static_cast<SwRleData*>(calloc(1, sizeof(SwRleData)));
+        if (!buffers[i]) return nullptr;
+    }
+    auto buffer = buffers[0];
+    if (rle && rle->spans >= buffer->spans && rle->spans < buffer->spans + buffer->alloc) return buffers[1];
+    return buffer;
+}
+
+
+//Cuts the rect or the spans by the clip paths, false if nothing is left.
+static bool _clip(const SwShape* targets, uint32_t cnt, SwRleData** buffers, bool& rect, SwBBox& bbox, SwRleData*& rle, SwRleData& view)
+{
+    for (auto target = targets; target < targets + cnt; ++target) {
+
+        //Rect in a rect stays a rect.
+        if (rect && target->rect) {
+            bbox.min.x = max(bbox.min.x, target->bbox.min.x);
+            bbox.min.y = max(bbox.min.y, target->bbox.min.y);
+            bbox.max.x = min(bbox.max.x, target->bbox.max.x);
+            bbox.max.y = min(bbox.max.y, target->bbox.max.y);
+            if (bbox.max.x <= bbox.min.x || bbox.max.y <= bbox.min.y) return false;
+            continue;
+        }
+
+        //A rect leaves the clip spans in it.
+        if (rect) {
+            if (!target->rle) return false;
+            rle = rleClipRect(target->rle, bbox, &view, _clipBuffer(buffers, nullptr));
+            rect = false;
+        } else if (!rle) {
+            return false;
+        } else if (target->rect) {
+            rle = rleClipRect(rle, target->bbox, &view, _clipBuffer(buffers, rle));
+        } else if (target->rle) {
+            rle = rleClipPath(rle, target->rle, &view, _clipBuffer(buffers, rle));
+        } else {
+            return false;
+        }
+        if (!rle || rle->size == 0) return false;
+    }
+    return true;
+}
+
+
+static void _clipPaths(const vector<Composite>& compList, vector<SwShape>& targets)
+{
+    for (auto& comp : compList) {
+        if (comp.method == CompositeMethod::ClipPath) targets.push_back(static_cast<SwShapeTask*>(comp.edata)->shape);
+    }
+}
+
+
+static void _shapeDrawing(SwShapeTask* task, SwDrawing& drawing)
+{
+    auto sdata = task->sdata;
+    auto opacity = task->opacity;
+
+    drawing.shape = task->shape;
+    drawing.opacity = opacity;
+
+    if (auto fill = sdata->fill()) {
+        drawing.gradient = true;
+        drawing.fillId = fill->id();
+    } else {
+        auto color = drawing.color;
+        sdata->fillColor(color, color + 1, color + 2, color + 3);
+        color[3] = static_cast<uint8_t>((opacity * (uint32_t) color[3]) / 255);
+    }
+
+    auto stroke = drawing.stroke;
+    sdata->strokeColor(stroke, stroke + 1, stroke + 2, stroke + 3);
+    stroke[3] = static_cast<uint8_t>((opacity * (uint32_t) stroke[3]) / 255);
+}
+
+
+static bool _drawShape(SwSurface* surface, const SwDrawing& drawing, const SwShape* clips, uint32_t clipCnt, SwRleData** buffers)
+{
+    //Clipped for this drawing only, the shape keeps its own spans.
+    auto clipped = drawing.shape;
+    SwRleData view;
+
+    if (_clip(clips, clipCnt, buffers, clipped.rect, clipped.bbox, clipped.rle, view)) {
+        if (drawing.gradient) {
+            //FIXME: pass opacity to apply gradient fill?
+            rasterGradientShape(surface, &clipped, drawing.fillId);
+        } else {
+            auto color = drawing.color;
+            if (color[3] > 0) rasterSolidShape(surface, &clipped, color[0], color[1], color[2], color[3]);
+        }
+    }
+
+    auto stroke = drawing.stroke;
+    if (stroke[3] == 0 || !clipped.strokeRle) return true;
+
+    auto rect = false;
+    if (_clip(clips, clipCnt, buffers, rect, clipped.bbox, clipped.strokeRle, view)) rasterStroke(surface, &clipped, stroke[0], stroke[1], stroke[2], stroke[3]);
+
+    return true;
+}
+
+
+static bool _drawImage(SwSurface* surface, SwImage& image, uint32_t opacity, const Matrix* transform, const SwShape* clips, uint32_t clipCnt, SwRleData** buffers)
+{
+    if (clipCnt == 0) return rasterImage(surface, &image, opacity, transform);
+
+    //Clipped for this drawing only, the image keeps its own area.
+    auto bbox = image.bbox;
+    auto rle = image.rle;
+    auto rect = !rle;
+    SwRleData view;
+
+    auto ret = true;
+    if (_clip(clips, clipCnt, buffers, rect, image.bbox, image.rle, view)) {
+        ret = rasterImage(surface, &image, opacity, transform);
+    }
+
+    image.bbox = bbox;
+    image.rle = rle;
+
+    return ret;
+}
+
+
+void SwFrame::run(TVG_UNUSED unsigned tid)
+{
+    rasterClear(&surface);
+
+    SwRleData* buffers[2] = {nullptr, nullptr};
+
+    for (auto& drawing : drawings) {
+        auto targets = drawing.clipCnt > 0 ? &clips[drawing.clip] : nullptr;
+        if (!drawing.picture) {
+            _drawShape(&surface, drawing, targets, drawing.clipCnt, buffers);
+            continue;
+        }
+        _drawImage(&surface, drawing.image, drawing.opacity, drawing.transformed ? &drawing.transform : nullptr, targets, drawing.clipCnt, buffers);
+    }
+
+    rleFree(buffers[0]);
+    rleFree(buffers[1]);
+}
+
+
 static void _termEngine()
 {
     if (rendererCnt > 0) return;
@@ -189,9 +502,30 @@ static void _termEngine()
 SwRenderer::~SwRenderer()
 {
     clear();
+    abort();
 
     if (surface) delete(surface);
 
+    for (auto& mem : pool) free(mem.first);
+
+    rleFree(clips[0]);
+    rleFree(clips[1]);
+
+    //Layers not disposed yet
+    {
+        lock_guard<mutex> lock(cacheMtx);
+        auto cnt = 0;
+        for (auto layer : cacheList) {
+            if (layer->owner == this) {
+                cacheUsage -= layer->charge;
+                layer->charge = 0;
+            } else {
+                cacheList[cnt++] = layer;
+            }
+        }
+        cacheList.resize(cnt);
+    }
+
     --rendererCnt;
     if (!initEngine) _termEngine();
 }
@@ -202,6 +536,17 @@ bool SwRenderer::clear()
     for (auto task : tasks) task->done();
     tasks.clear();
 
+    //The paints are going to be freed.
+    reclaim(0);
+
+    return true;
+}
+
+
+bool SwRenderer::sync()
+{
+    reclaim(0);
+
     return true;
 }
 
@@ -210,6 +555,10 @@ bool SwRenderer::target(uint32_t* buffer, uint32_t stride, uint32_t w, uint32_t
 {
     if (!buffer || stride == 0 || w == 0 || h == 0) return false;
 
+    reclaim(0);
+    buffers.clear();
+    next = 0;
+
     if (!surface) {
         surface = new SwSurface;
         if (!surface) return false;
@@ -217,16 +566,151 @@ bool SwRenderer::target(uint32_t* buffer, uint32_t stride, uint32_t w, uint32_t
 
     surface->buffer = buffer;
     surface->stride = stride;
-    surface->w = w;
-    surface->h = h;
     surface->cs = cs;
+    surface->coverage = method;
+
+    tw = w;
+    th = h;
+    resize();
 
     return rasterCompositor(surface);
 }
 
 
+bool SwRenderer::target(uint32_t** buffers, uint32_t cnt, uint32_t stride, uint32_t w, uint32_t h, uint32_t cs)
+{
+    if (!buffers || cnt == 0) return false;
+
+    for (uint32_t i = 0; i < cnt; ++i) {
+        if (!buffers[i]) return false;
+    }
+
+    if (!target(buffers[0], stride, w, h, cs)) return false;
+
+    if (cnt > 1) this->buffers.assign(buffers, buffers + cnt);
+
+    return true;
+}
+
+
+bool SwRenderer::coverage(uint32_t method)
+{
+    if (method > SwCanvas::Add) return false;
+
+    //The frames in the rasterization are drawn as they were.
+    reclaim(0);
+
+    this->method = method;
+    if (surface) surface->coverage = method;
+
+    return true;
+}
+
+
+bool SwRenderer::viewport(int32_t x, int32_t y, uint32_t w, uint32_t h)
+{
+    vx = x;
+    vy = y;
+    vw = w;
+    vh = h;
+
+    if (surface) resize();
+
+    return true;
+}
+
+
+bool SwRenderer::async()
+{
+    return true;
+}
+
+
+bool SwRenderer::record()
+{
+    if (buffers.size() < 2 || !surface) return false;
+
+    //Up to the buffers but one are in the rasterization, the next frame waits for the oldest one.
+    reclaim(buffers.size() - 2);
+
+    recording = new SwFrame;
+    if (!recording) return false;
+
+    recording->id = ++recorded;
+    recording->surface = *surface;
+    recording->surface.buffer = buffers[next];
+
+    return true;
+}
+
+
+//Finishes the frames in the rasterization until the given number of them is left.
+void SwRenderer::reclaim(uint32_t keep)
+{
+    while (frames.size() > keep) {
+        auto frame = frames.front();
+        frames.pop_front();
+        frame->done();
+        reclaimed = frame->id;
+        delete(frame);
+    }
+}
+
+
+//Drops the frame in the recording, it's drawn directly instead. Its id isn't given out again,
+//the tasks pinned to it aren't held by any frame.
+void SwRenderer::abort()
+{
+    if (!recording) return;
+
+    delete(recording);
+    recording = nullptr;
+}
+
+
+//Frame in the rasterization which draws the engine data of the task.
+SwFrame* SwRenderer::holder(SwTask* task)
+{
+    if (task->pinned <= reclaimed) return nullptr;
+
+    //Aborted recordings leave gaps in the ids.
+    for (auto frame : frames) {
+        if (frame->id == task->pinned) return frame;
+    }
+    return nullptr;
+}
+
+
+void SwRenderer::resize()
+{
+    //Nothing out of the viewport is prepared nor drawn.
+    surface->w = (vw > 0 && vw < tw) ? vw : tw;
+    surface->h = (vh > 0 && vh < th) ? vh : th;
+
+    //Drawings of the layers are made for the previous target.
+    ++generation;
+}
+
+
 bool SwRenderer::preRender()
 {
+    //Cleared by the frame on its rasterization.
+    if (recording && !recording->started) {
+        recording->started = true;
+        return true;
+    }
+
+    //A drawing couldn't be recorded.
+    abort();
+
+    current = surface;
+
+    if (!buffers.empty()) {
+        reclaim(0);
+        surface->buffer = buffers[next];
+        next = (next + 1) % buffers.size();
+    }
+
     return rasterClear(surface);
 }
 
@@ -234,6 +718,23 @@ bool SwRenderer::preRender()
 bool SwRenderer::postRender()
 {
     tasks.clear();
+
+    if (recording) {
+        frames.push_back(recording);
+        next = (next + 1) % buffers.size();
+        TaskScheduler::request(recording);
+        recording = nullptr;
+    }
+
+    //The budget might be lowered.
+    trim(0);
+
+    //The drawings of this frame can be dropped from now on.
+    lock_guard<mutex> lock(cacheMtx);
+    for (auto layer : cacheList) {
+        if (layer->owner == this) layer->busy = false;
+    }
+
     return true;
 }
 
@@ -243,26 +744,57 @@ bool SwRenderer::render(TVG_UNUSED const Picture& picture, void *data)
     auto task = static_cast<SwImageTask*>(data);
     task->done();
 
-    return rasterImage(surface, &task->image, task->opacity, task->transform);
+    vector<SwShape> targets;
+    _clipPaths(task->compList, targets);
+
+    if (!recording) return _drawImage(current, task->image, task->opacity, task->transform, targets.data(), targets.size(), clips);
+
+    recording->drawings.emplace_back();
+    auto& drawing = recording->drawings.back();
+    drawing.picture = true;
+    drawing.image = task->image;
+    drawing.opacity = task->opacity;
+    if (task->transform) {
+        drawing.transform = *task->transform;
+        drawing.transformed = true;
+    }
+    drawing.clip = recording->clips.size();
+    drawing.clipCnt = targets.size();
+    recording->clips.insert(recording->clips.end(), targets.begin(), targets.end());
+
+    task->pinned = recording->id;
+    for (auto& comp : task->compList) static_cast<SwTask*>(comp.edata)->pinned = recording->id;
+
+    return true;
 }
 
+
 bool SwRenderer::render(TVG_UNUSED const Shape& shape, void *data)
 {
     auto task = static_cast<SwShapeTask*>(data);
     task->done();
 
-    uint8_t r, g, b, a;
-    if (auto fill = task->sdata->fill()) {
-        //FIXME: pass opacity to apply gradient fill?
-        rasterGradientShape(surface, &task->shape, fill->id());
-    } else{
-        task->sdata->fillColor(&r, &g, &b, &a);
-        a = static_cast<uint8_t>((task->opacity * (uint32_t) a) / 255);
-        if (a > 0) rasterSolidShape(surface, &task->shape, r, g, b, a);
+    //Invisible, its data might be left from the last update.
+    if (task->opacity == 0) return true;
+
+    vector<SwShape> targets;
+    _clipPaths(task->compList, targets);
+
+    if (!recording) {
+        SwDrawing drawing;
+        _shapeDrawing(task, drawing);
+        return _drawShape(current, drawing, targets.data(), targets.size(), clips);
     }
-    task->sdata->strokeColor(&r, &g, &b, &a);
-    a = static_cast<uint8_t>((task->opacity * (uint32_t) a) / 255);
-    if (a > 0) rasterStroke(surface, &task->shape, r, g, b, a);
+
+    recording->drawings.emplace_back();
+    auto& drawing = recording->drawings.back();
+    _shapeDrawing(task, drawing);
+    drawing.clip = recording->clips.size();
+    drawing.clipCnt = targets.size();
+    recording->clips.insert(recording->clips.end(), targets.begin(), targets.end());
+
+    task->pinned = recording->id;
+    for (auto& comp : task->compList) static_cast<SwTask*>(comp.edata)->pinned = recording->id;
 
     return true;
 }
@@ -273,11 +805,294 @@ bool SwRenderer::dispose(void *data)
     auto task = static_cast<SwTask*>(data);
     if (!task) return true;
 
+    //Its data might be drawn yet, so might be the image pixels which are freed along.
+    while (!frames.empty() && frames.front()->id <= task->pinned) reclaim(frames.size() - 1);
+
     task->done();
     task->dispose();
     if (task->transform) free(task->transform);
     delete(task);
 
+    ++updates;
+
+    return true;
+}
+
+
+bool SwRenderer::region(void* data, RenderRegion& region)
+{
+    auto task = static_cast<SwTask*>(data);
+    if (!task || !surface) return false;
+
+    task->done();
+
+    SwBBox bbox;
+    if (!task->bounds(bbox)) return false;
+
+    auto x0 = max(bbox.min.x, static_cast<SwCoord>(0));
+    auto y0 = max(bbox.min.y, static_cast<SwCoord>(0));
+    auto x1 = min(bbox.max.x, static_cast<SwCoord>(surface->w));
+    auto y1 = min(bbox.max.y, static_cast<SwCoord>(surface->h));
+    if (x1 <= x0 || y1 <= y0) return false;
+
+    region = {static_cast<uint32_t>(x0), static_cast<uint32_t>(y0), static_cast<uint32_t>(x1 - x0), static_cast<uint32_t>(y1 - y0)};
+
+    return true;
+}
+
+
+uint32_t SwRenderer::revision()
+{
+    return updates;
+}
+
+
+bool SwRenderer::request(SwLayer* layer, uint32_t size)
+{
+    if (layer->mem && layer->size >= size) return true;
+
+    release(layer);
+
+    //The smallest one that fits
+    auto best = pool.end();
+    for (auto p = pool.begin(); p < pool.end(); ++p) {
+        if (p->second < size) continue;
+        if (best == pool.end() || p->second < best->second) best = p;
+    }
+
+    if (best != pool.end()) {
+        layer->mem = best->first;
+        layer->size = best->second;
+        pool.erase(best);
+        return true;
+    }
+
+    layer->mem = malloc(sizeof(uint32_t) * size + 31);
+    if (!layer->mem) return false;
+    layer->size = size;
+
+    return true;
+}
+
+
+void SwRenderer::release(SwLayer* layer)
+{
+    //Another renderer may drop a kept layer until it's taken out of the budget.
+    if (layer->owner) {
+        lock_guard<mutex> lock(cacheMtx);
+        if (layer->charge > 0) {
+            cacheUsage -= layer->charge;
+            layer->charge = 0;
+            cacheList.erase(find(cacheList.begin(), cacheList.end(), layer));
+        }
+    }
+
+    layer->valid = false;
+
+    if (!layer->mem) return;
+
+    if (pool.size() < SW_LAYER_POOL) pool.push_back({layer->mem, layer->size});
+    else free(layer->mem);
+
+    layer->mem = nullptr;
+    layer->size = 0;
+}
+
+
+//Counts the drawing in the cache budget, false if it doesn't fit.
+bool SwRenderer::keep(SwLayer* layer)
+{
+    if (layer->charge > 0) return true;
+
+    auto bytes = sizeof(uint32_t) * layer->size;
+    trim(bytes);
+
+    lock_guard<mutex> lock(cacheMtx);
+    if (cacheUsage + bytes > cacheLimit) return false;
+    cacheUsage += bytes;
+    layer->charge = bytes;
+    layer->owner = this;
+    layer->busy = true;
+    cacheList.push_back(layer);
+
+    return true;
+}
+
+
+//Drops the least recently used drawings of any renderer until the bytes fit in the budget.
+//Drawings in the current frame of their renderers are kept.
+void SwRenderer::trim(size_t bytes)
+{
+    vector<SwLayer*> drops;
+    {
+        lock_guard<mutex> lock(cacheMtx);
+        //Nothing is dropped for the one which never fits.
+        if (bytes > cacheLimit) return;
+        auto p = cacheList.begin();
+        while (cacheUsage + bytes > cacheLimit && p < cacheList.end()) {
+            auto layer = *p;
+            if (layer->busy) {
+                ++p;
+                continue;
+            }
+            cacheUsage -= layer->charge;
+            layer->charge = 0;
+            p = cacheList.erase(p);
+            //The owner doesn't touch an idle layer without the lock, its memory can go right away.
+            if (layer->owner == this) {
+                drops.push_back(layer);
+            } else {
+                layer->valid = false;
+                free(layer->mem);
+                layer->mem = nullptr;
+                layer->size = 0;
+            }
+        }
+    }
+    for (auto layer : drops) release(layer);
+}
+
+
+void* SwRenderer::prepareComposite(void* cmp, bool retain)
+{
+    auto layer = static_cast<SwLayer*>(cmp);
+    if (!layer) {
+        layer = new SwLayer;
+        if (!layer) return nullptr;
+    }
+    layer->retain = retain;
+
+    //The most recently used one, it's kept until the frame is drawn.
+    if (layer->owner) {
+        lock_guard<mutex> lock(cacheMtx);
+        if (layer->charge > 0) {
+            layer->busy = true;
+            cacheList.erase(find(cacheList.begin(), cacheList.end(), layer));
+            cacheList.push_back(layer);
+        }
+    }
+
+    return layer;
+}
+
+
+bool SwRenderer::beginComposite(void* cmp, const RenderRegion& region)
+{
+    auto layer = static_cast<SwLayer*>(cmp);
+    if (!layer || !current) return false;
+
+    //Layers aren't recorded, the frame is drawn directly.
+    if (recording) {
+        abort();
+        return false;
+    }
+
+    //The layer keeps the pixel alignment of the canvas for the vectorized fills.
+    auto x = region.x & ~7u;
+    auto stride = (region.x + region.w - x + 7) & ~7u;
+    if (!request(layer, stride * region.h)) return false;
+
+    auto pixels = _pixels(layer->mem);
+    memset(pixels, 0x00, sizeof(uint32_t) * stride * region.h);
+
+    //The raster functions draw in the canvas coordinates, rebase the buffer to the region.
+    layer->surface = *current;
+    layer->surface.cs = current->comp.cs;
+    layer->surface.stride = stride;
+    layer->surface.buffer = pixels - (region.y * stride + x);
+
+    layer->region.min.x = region.x;
+    layer->region.min.y = region.y;
+    layer->region.max.x = region.x + region.w;
+    layer->region.max.y = region.y + region.h;
+    layer->valid = false;
+    layer->whole = (region.x > 0 && region.y > 0 && region.x + region.w < current->w && region.y + region.h < current->h);
+
+    //Switch the render target
+    layer->recover = current;
+    current = &layer->surface;
+
+    return true;
+}
+
+
+bool SwRenderer::endComposite(void* cmp)
+{
+    auto layer = static_cast<SwLayer*>(cmp);
+    if (!layer || current != &layer->surface) return false;
+
+    current = layer->recover;
+    layer->recover = nullptr;
+    layer->valid = true;
+    layer->generation = generation;
+
+    return true;
+}
+
+
+bool SwRenderer::composite(void* cmp, void* mask, CompositeMethod method, uint32_t opacity)
+{
+    auto layer = static_cast<SwLayer*>(cmp);
+    auto mlayer = static_cast<SwLayer*>(mask);
+    if (!layer || !layer->valid || !current) return false;
+
+    if (recording) {
+        abort();
+        return false;
+    }
+
+    auto masking = (method == CompositeMethod::AlphaMask || method == CompositeMethod::InvAlphaMask);
+    if (masking && mlayer && !mlayer->valid) mlayer = nullptr;
+
+    //Nothing is visible without the mask.
+    auto ret = true;
+    if (!(method == CompositeMethod::AlphaMask && !mlayer)) {
+        ret = rasterLayer(current, layer, masking ? mlayer : nullptr, method == CompositeMethod::InvAlphaMask, opacity);
+    }
+
+    //Transient drawings give the memory back to the pool, so do the ones over the budget.
+    if (!layer->retain || !keep(layer)) release(layer);
+    if (mlayer && !mlayer->retain) release(mlayer);
+
+    return ret;
+}
+
+
+bool SwRenderer::cached(void* cmp)
+{
+    auto layer = static_cast<SwLayer*>(cmp);
+    if (!layer || recording) return false;
+
+    return (layer->retain && layer->valid && layer->mem && layer->generation == generation);
+}
+
+
+bool SwRenderer::moveComposite(void* cmp, int32_t x, int32_t y)
+{
+    auto layer = static_cast<SwLayer*>(cmp);
+    if (!layer || !layer->valid) return false;
+
+    layer->region.min.x += x;
+    layer->region.min.y += y;
+    layer->region.max.x += x;
+    layer->region.max.y += y;
+    layer->surface.buffer -= (y * static_cast<int32_t>(layer->surface.stride) + x);
+
+    //The parts out of the target weren't drawn.
+    return layer->whole;
+}
+
+
+bool SwRenderer::disposeComposite(void* cmp)
+{
+    auto layer = static_cast<SwLayer*>(cmp);
+    if (!layer) return true;
+
+    release(layer);
+    delete(layer);
+
+    ++updates;
+
     return true;
 }
 
@@ -290,9 +1105,14 @@ void SwRenderer::prepareCommon(SwTask* task, const RenderTransform* transform, u
         task->compList.assign(compList.begin(), compList.end());
     }
 
-    if (transform) {
+    //The viewport origin is placed at the target origin. Untransformed paints take the matrix as well
+    //since the outlines are rounded differently, the tiles of a scene must match each other.
+    if (transform || vx != 0 || vy != 0 || vw != 0 || vh != 0) {
         if (!task->transform) task->transform = static_cast<Matrix*>(malloc(sizeof(Matrix)));
-        *task->transform = transform->m;
+        if (transform) *task->transform = transform->m;
+        else *task->transform = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+        task->transform->e13 -= vx;
+        task->transform->e23 -= vy;
     } else {
         if (task->transform) free(task->transform);
         task->transform = nullptr;
@@ -302,12 +1122,14 @@ void SwRenderer::prepareCommon(SwTask* task, const RenderTransform* transform, u
     task->surface = surface;
     task->flags = flags;
 
+    ++updates;
+
     tasks.push_back(task);
     TaskScheduler::request(task);
 }
 
 
-void* SwRenderer::prepare(const Picture& pdata, void* data, uint32_t *pixels, const RenderTransform* transform, uint32_t opacity, vector<Composite>& compList, RenderUpdateFlag flags)
+void* SwRenderer::prepare(const Picture& pdata, void* data, uint32_t *pixels, uint32_t stride, bool opaque, const RenderTransform* transform, uint32_t opacity, vector<Composite>& compList, RenderUpdateFlag flags)
 {
     //prepare task
     auto task = static_cast<SwImageTask*>(data);
@@ -321,8 +1143,13 @@ void* SwRenderer::prepare(const Picture& pdata, void* data, uint32_t *pixels, co
     //Finish previous task if it has duplicated request.
     task->done();
 
+    //The frames in the rasterization keep the current levels.
+    if (auto frame = holder(task)) task->retire(frame);
+
     task->pdata = &pdata;
     task->pixels = pixels;
+    task->stride = stride;
+    task->opaque = opaque;
 
     prepareCommon(task, transform, opacity, compList, flags);
 
@@ -343,6 +1170,13 @@ void* SwRenderer::prepare(const Shape& sdata, void* data, const RenderTransform*
 
     //Finish previous task if it has duplicated request.
     task->done();
+
+    //Regenerated, the frames in the rasterization keep the current data.
+    if (auto frame = holder(task)) {
+        task->retire(frame);
+        flags = static_cast<RenderUpdateFlag>(flags | RenderUpdateFlag::Path | RenderUpdateFlag::Gradient | RenderUpdateFlag::Stroke);
+    }
+
     task->sdata = &sdata;
 
     prepareCommon(task, transform, opacity, compList, flags);
@@ -351,6 +1185,13 @@ void* SwRenderer::prepare(const Shape& sdata, void* data, const RenderTransform*
 }
 
 
+void SwRenderer::cacheBudget(uint32_t bytes)
+{
+    lock_guard<mutex> lock(cacheMtx);
+    cacheLimit = bytes;
+}
+
+
 bool SwRenderer::init(uint32_t threads)
 {
     if (rendererCnt > 0) return false;
@@ -23,10 +23,14 @@
 #define _TVG_SW_RENDERER_H_
 
 #include <vector>
+#include <deque>
 #include "tvgRender.h"
 
 struct SwSurface;
 struct SwTask;
+struct SwLayer;
+struct SwRleData;
+struct SwFrame;
 
 namespace tvg
 {
@@ -35,27 +39,66 @@ class SwRenderer : public RenderMethod
 {
 public:
     void* prepare(const Shape& shape, void* data, const RenderTransform* transform, uint32_t opacity, vector<Composite>& compList, RenderUpdateFlag flags) override;
-    void* prepare(const Picture& picture, void* data, uint32_t *buffer, const RenderTransform* transform, uint32_t opacity, vector<Composite>& compList, RenderUpdateFlag flags) override;
+    void* prepare(const Picture& picture, void* data, uint32_t *buffer, uint32_t stride, bool opaque, const RenderTransform* transform, uint32_t opacity, vector<Composite>& compList, RenderUpdateFlag flags) override;
     bool dispose(void *data) override;
     bool preRender() override;
     bool postRender() override;
     bool target(uint32_t* buffer, uint32_t stride, uint32_t w, uint32_t h, uint32_t cs);
+    bool target(uint32_t** buffers, uint32_t cnt, uint32_t stride, uint32_t w, uint32_t h, uint32_t cs);
+    bool coverage(uint32_t method);
+    bool viewport(int32_t x, int32_t y, uint32_t w, uint32_t h) override;
+    bool async() override;
+    bool record() override;
+    bool sync() override;
     bool clear() override;
     bool render(const Shape& shape, void *data) override;
     bool render(const Picture& picture, void *data) override;
+    bool region(void* data, RenderRegion& region) override;
+    uint32_t revision() override;
+    void* prepareComposite(void* cmp, bool retain) override;
+    bool beginComposite(void* cmp, const RenderRegion& region) override;
+    bool endComposite(void* cmp) override;
+    bool composite(void* cmp, void* mask, CompositeMethod method, uint32_t opacity) override;
+    bool cached(void* cmp) override;
+    bool moveComposite(void* cmp, int32_t x, int32_t y) override;
+    bool disposeComposite(void* cmp) override;
 
     static SwRenderer* gen();
     static bool init(uint32_t threads);
     static bool term();
+    static void cacheBudget(uint32_t bytes);
 
 private:
     SwSurface* surface = nullptr;
+    SwSurface* current = nullptr;               //render target, the surface or a layer
     vector<SwTask*> tasks;
+    vector<pair<void*, uint32_t>> pool;         //free layer memory and its capacity in pixels
+    SwRleData* clips[2] = {nullptr, nullptr};   //spans cut by the clip paths, reused over the frames
+    int32_t vx = 0, vy = 0;                     //scene origin of the viewport
+    uint32_t vw = 0, vh = 0;                    //viewport size, zero takes the target size
+    uint32_t method = SwCanvas::Over;           //coverage combination of the A8 target
+    uint32_t tw = 0, th = 0;                    //size of the target buffer
+    uint32_t generation = 0;                    //bumped on the target change
+    uint32_t updates = 0;                       //bumped on any engine data change
+    vector<uint32_t*> buffers;                  //target buffers drawn in turn
+    deque<SwFrame*> frames;                     //frames in the rasterization, the oldest first
+    SwFrame* recording = nullptr;               //frame of the drawing in progress
+    uint32_t next = 0;                          //buffer of the next frame
+    uint32_t recorded = 0;                      //id of the last recorded frame, aborted ones included
+    uint32_t reclaimed = 0;                     //id of the last finished frame
 
     SwRenderer(){};
     ~SwRenderer();
 
     void prepareCommon(SwTask* task, const RenderTransform* transform, uint32_t opacity, vector<Composite>& compList, RenderUpdateFlag flags);
+    void resize();
+    void reclaim(uint32_t keep);
+    void abort();
+    SwFrame* holder(SwTask* task);
+    bool request(SwLayer* layer, uint32_t size);
+    void release(SwLayer* layer);
+    bool keep(SwLayer* layer);
+    void trim(size_t bytes);
 };
 
 }
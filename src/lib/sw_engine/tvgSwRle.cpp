@@ -22,8 +22,14 @@
 #include <setjmp.h>
 #include <limits.h>
 #include <memory.h>
+#include <math.h>
+#include <float.h>
+#include <vector>
+#include <algorithm>
 
 #include "tvgSwCommon.h"
+#include "tvgBezier.h"
+#include "tvgTaskScheduler.h"
 
 /************************************************************************/
 /* Internal Class Implementation                                        */
@@ -72,10 +78,6 @@ struct RleWorker
 
     SwOutline* outline;
 
-    SwSpan spans[MAX_SPANS];
-    int spansCnt;
-    int ySpan;
-
     int bandSize;
     int bandShoot;
 
@@ -135,23 +137,63 @@ static inline SwCoord HYPOT(SwPoint pt)
     return ((pt.x > pt.y) ? (pt.x + (3 * pt.y >> 3)) : (pt.y + (3 * pt.x >> 3)));
 }
 
-static void _genSpan(SwRleData* rle, SwSpan* spans, uint32_t count)
+//Makes room for the spans in the buffer, the previous ones are kept.
+static SwSpan* _reserveSpans(SwRleData* buffer, uint32_t cnt)
+{
+    if (buffer->alloc < cnt) {
+        auto spans = static_cast<SwSpan*>(realloc(buffer->spans, cnt * sizeof(SwSpan)));
+        if (!spans) return nullptr;
+        buffer->spans = spans;
+        buffer->alloc = cnt;
+    }
+    return buffer->spans;
+}
+
+
+//Makes room for the rows in the buffer, the previous ones are kept.
+static uint32_t* _reserveRows(SwRleData* buffer, uint32_t cnt)
+{
+    if (buffer->rowsAlloc < cnt) {
+        auto rows = static_cast<uint32_t*>(realloc(buffer->rows, cnt * sizeof(uint32_t)));
+        if (!rows) return nullptr;
+        buffer->rows = rows;
+        buffer->rowsAlloc = cnt;
+    }
+    return buffer->rows;
+}
+
+
+//Adds a span at the end of the row y, the rows are made in order.
+static SwSpan* _genSpan(SwRleData* rle, SwCoord y)
 {
-    auto newSize = rle->size + count;
+    if (rle->size == 0) rle->top = rle->bottom = y;
 
-    /* allocate enough memory for new spans */
     /* alloc is required to prevent free and reallocation */
     /* when the rle needs to be regenerated because of attribute change. */
-    if (rle->alloc < newSize) {
-        rle->alloc = (newSize * 2);
-        rle->spans = static_cast<SwSpan*>(realloc(rle->spans, rle->alloc * sizeof(SwSpan)));
+    if (rle->size == rle->alloc && !_reserveSpans(rle, max(rle->alloc * 2, static_cast<uint32_t>(MAX_SPANS)))) return nullptr;
+
+    if (y >= rle->bottom) {
+        auto cnt = static_cast<uint32_t>(y - rle->top + 2);
+        if (rle->rowsAlloc < cnt && !_reserveRows(rle, max(rle->rowsAlloc * 2, cnt))) return nullptr;
+        while (rle->bottom <= y) rle->rows[rle->bottom++ - rle->top] = rle->size;
     }
+    rle->rows[rle->bottom - rle->top] = rle->size + 1;
+
+    return rle->spans + rle->size++;
+}
 
-    //copy the new spans to the allocated memory
-    SwSpan* lastSpan = rle->spans + rle->size;
-    memcpy(lastSpan, spans, count * sizeof(SwSpan));
 
-    rle->size = newSize;
+//Shares the rows of the spans, the view owns no memory.
+static SwRleData* _view(SwRleData* out, SwSpan* spans, uint32_t* rows, SwCoord top, SwCoord bottom)
+{
+    out->spans = spans;
+    out->rows = rows;
+    out->top = top;
+    out->bottom = bottom;
+    out->size = (top < bottom) ? rows[bottom - top] - rows[0] : 0;
+    out->alloc = 0;
+    out->rowsAlloc = 0;
+    return out;
 }
 
 
@@ -179,62 +221,36 @@ static void _horizLine(RleWorker& rw, SwCoord x, SwCoord y, SwCoord area, SwCoor
         if (coverage >= 256) coverage = 255;
     }
 
-    //span has ushort coordinates. check limit overflow
-    if (x >= SHRT_MAX) {
-        //LOG: x coordinate overflow!
-        x = SHRT_MAX;
-    }
-    if (y >= SHRT_MAX) {
-        //LOG: y coordinate overflow!
-        y = SHRT_MAX;
-    }
-
     if (coverage > 0) {
         if (!rw.antiAlias) coverage = 255;
-        auto count = rw.spansCnt;
-        auto span = rw.spans + count - 1;
 
-        //see whether we can add this span to the current list
-        if ((count > 0) && (rw.ySpan == y) &&
-            (span->x + span->len == x) && (span->coverage == coverage)) {
+        //Clip x range
+        auto x2 = min(x + acount, rw.clip.w);
+        if (x < 0) x = 0;
 
-            //Clip x range
-            SwCoord xOver = 0;
-            if (x + acount >= rw.clip.w) xOver -= (x + acount - rw.clip.w);
-            if (x < 0) xOver += x;
+        //Nothing to draw
+        if (x2 <= x) return;
 
-            //span->len += (acount + xOver) - 1;
-            span->len += (acount + xOver);
-            return;
-        }
+        auto rle = rw.rle;
 
-        if (count >=  MAX_SPANS) {
-            _genSpan(rw.rle, rw.spans, count);
-            rw.spansCnt = 0;
-            rw.ySpan = 0;
-            span = rw.spans;
-        } else {
-            ++span;
+        //see whether we can add this span to the current list
+        if ((rle->size > 0) && (rle->bottom == y + 1)) {
+            auto span = rle->spans + rle->size - 1;
+            if ((span->x + span->len == x) && (span->coverage == coverage) && (span->len + (x2 - x) <= UINT16_MAX)) {
+                span->len += (x2 - x);
+                return;
+            }
         }
 
-        //Clip x range
-        SwCoord xOver = 0;
-        if (x + acount >= rw.clip.w) xOver -= (x + acount - rw.clip.w);
-        if (x < 0) {
-            xOver += x;
-            x = 0;
+        //add the spans to the current list, the long ones are split.
+        while (x < x2) {
+            auto span = _genSpan(rle, y);
+            if (!span) return;
+            span->x = x;
+            span->len = min(x2 - x, static_cast<SwCoord>(UINT16_MAX));
+            span->coverage = coverage;
+            x += span->len;
         }
-
-        //Nothing to draw
-        if (acount + xOver <= 0) return;
-
-        //add a span to the current list
-        span->x = x;
-        span->y = y;
-        span->len = (acount + xOver);
-        span->coverage = coverage;
-        ++rw.spansCnt;
-        rw.ySpan = y;
     }
 }
 
@@ -243,9 +259,6 @@ static void _sweep(RleWorker& rw)
 {
     if (rw.cellsCnt == 0) return;
 
-    rw.spansCnt = 0;
-    rw.ySpan = 0;
-
     for (int y = 0; y < rw.yCnt; ++y) {
         auto cover = 0;
         auto x = 0;
@@ -264,8 +277,6 @@ static void _sweep(RleWorker& rw)
 
         if (cover != 0) _horizLine(rw, x, y, cover * (ONE_PIXEL * 2), rw.cellXCnt - x);
     }
-
-    if (rw.spansCnt > 0) _genSpan(rw.rle, rw.spans, rw.spansCnt);
 }
 
 
@@ -613,101 +624,127 @@ static int _genRle(RleWorker& rw)
 }
 
 
-SwSpan* _intersectSpansRegion(const SwRleData *clip, const SwRleData *targetRle, SwSpan *outSpans, uint32_t spanCnt)
+struct HairlineSegment
 {
-    auto out = outSpans;
-    auto spans = targetRle->spans;
-    auto end = targetRle->spans + targetRle->size;
-    auto clipSpans = clip->spans;
-    auto clipEnd = clip->spans + clip->size;
+    Point p0, p1;         //along the major axis, p0 is the lower one
+    float slope;
+    float half;           //half of the thickness on the minor axis
+    SwBBox bbox;
+    bool steep;           //the major axis is y
+};
 
-    while (spanCnt && spans < end ) {
-        if (clipSpans > clipEnd) {
-            spans = end;
-            break;
-        }
-        if (clipSpans->y > spans->y) {
-            ++spans;
-            continue;
-        }
-        if (spans->y != clipSpans->y) {
-            ++clipSpans;
-            continue;
-        }
-        auto sx1 = spans->x;
-        auto sx2 = sx1 + spans->len;
-        auto cx1 = clipSpans->x;
-        auto cx2 = cx1 + clipSpans->len;
-
-        if (cx1 < sx1 && cx2 < sx1) {
-            ++clipSpans;
-            continue;
-        }
-        else if (sx1 < cx1 && sx2 < cx1) {
-            ++spans;
-            continue;
-        }
-        auto x = sx1 > cx1 ? sx1 : cx1;
-        auto len = (sx2 < cx2 ? sx2 : cx2) - x;
-        if (len) {
-            auto spansCorverage = spans->coverage;
-            auto clipSpansCoverage = clipSpans->coverage;
-            out->x = sx1 > cx1 ? sx1 : cx1;
-            out->len = (sx2 < cx2 ? sx2 : cx2) - out->x;
-            out->y = spans->y;
-            out->coverage = (uint8_t)((spansCorverage * clipSpansCoverage) >> 8);
-            ++out;
-            --spanCnt;
-        }
-        if (sx2 < cx2) ++spans;
-        else ++clipSpans;
+
+//Segments going on nearly straight overlap by half a pixel, they fully cover the pixel they share then.
+//The sharper joints aren't extended, it would make spurs out of the corners.
+static float _hairlineJoint(const Point& a, const Point& b, const Point& c)
+{
+    auto ux = b.x - a.x, uy = b.y - a.y;
+    auto vx = c.x - b.x, vy = c.y - b.y;
+    auto len = sqrtf((ux * ux + uy * uy) * (vx * vx + vy * vy));
+    if (len < FLT_EPSILON) return 0.0f;
+    return ((ux * vx + uy * vy) > 0.9f * len) ? 0.5f : 0.0f;
+}
+
+
+//The thin segment is kept in its major axis, the thickness is measured on the minor axis.
+//The ends are extended by the caps, the factors of the thickness, and by the joints in pixels.
+static void _hairlineSegment(vector<HairlineSegment>& segments, Point p0, Point p1, float width, const Matrix* transform, float cap0, float cap1, float joint0, float joint1)
+{
+    auto dx = p1.x - p0.x;
+    auto dy = p1.y - p0.y;
+    auto len = sqrtf(dx * dx + dy * dy);
+    if (len < FLT_EPSILON) return;
+    dx /= len;
+    dy /= len;
+
+    //The device thickness across the direction, it's the adjugate of the transform on the direction.
+    auto thickness = width;
+    if (transform) {
+        auto tx = transform->e22 * dx - transform->e12 * dy;
+        auto ty = transform->e11 * dy - transform->e21 * dx;
+        thickness = width * sqrtf(tx * tx + ty * ty);
     }
-    return out;
+
+    auto ext0 = cap0 * thickness + joint0;
+    auto ext1 = cap1 * thickness + joint1;
+    p0 = {p0.x - dx * ext0, p0.y - dy * ext0};
+    p1 = {p1.x + dx * ext1, p1.y + dy * ext1};
+
+    HairlineSegment seg;
+    seg.steep = fabsf(dy) > fabsf(dx);
+    if (seg.steep) {
+        swap(p0.x, p0.y);
+        swap(p1.x, p1.y);
+    }
+    if (p0.x > p1.x) swap(p0, p1);
+
+    seg.p0 = p0;
+    seg.p1 = p1;
+    seg.slope = (p1.y - p0.y) / (p1.x - p0.x);
+    seg.half = 0.5f * thickness * sqrtf(1.0f + seg.slope * seg.slope);
+
+    auto minor = minmax(p0.y, p1.y);
+    Point min = {p0.x, minor.first - seg.half};
+    Point max = {p1.x, minor.second + seg.half};
+    if (seg.steep) {
+        swap(min.x, min.y);
+        swap(max.x, max.y);
+    }
+    seg.bbox.min = {static_cast<SwCoord>(floorf(min.x)), static_cast<SwCoord>(floorf(min.y))};
+    seg.bbox.max = {static_cast<SwCoord>(ceilf(max.x)), static_cast<SwCoord>(ceilf(max.y))};
+
+    segments.push_back(seg);
 }
 
-SwSpan* _intersectSpansRect(const SwBBox *bbox, const SwRleData *targetRle, SwSpan *outSpans, uint32_t spanCnt)
+
+//Analytic coverage of the segment in the band, it's scanned column by column along the major axis.
+static void _hairlineBand(const HairlineSegment& seg, uint16_t* cover, const SwBBox& band)
 {
-    auto out = outSpans;
-    auto spans = targetRle->spans;
-    auto end = targetRle->spans + targetRle->size;
-    auto minx = static_cast<int16_t>(bbox->min.x);
-    auto miny = static_cast<int16_t>(bbox->min.y);
-    auto maxx = minx + static_cast<int16_t>(bbox->max.x - bbox->min.x) - 1;
-    auto maxy = miny + static_cast<int16_t>(bbox->max.y - bbox->min.y) - 1;
+    auto stride = band.max.x - band.min.x;
+    auto majorMin = static_cast<float>(seg.steep ? band.min.y : band.min.x);
+    auto majorMax = static_cast<float>(seg.steep ? band.max.y : band.max.x);
+    auto minorMin = static_cast<float>(seg.steep ? band.min.x : band.min.y);
+    auto minorMax = static_cast<float>(seg.steep ? band.max.x : band.max.y);
+
+    auto from = max(seg.p0.x, majorMin);
+    auto to = min(seg.p1.x, majorMax);
+
+    //columns reaching the band rows
+    if (!seg.steep && seg.slope != 0.0f) {
+        auto x0 = seg.p0.x + (minorMin - seg.half - 1.0f - seg.p0.y) / seg.slope;
+        auto x1 = seg.p0.x + (minorMax + seg.half + 1.0f - seg.p0.y) / seg.slope;
+        if (x0 > x1) swap(x0, x1);
+        from = max(from, floorf(x0));
+        to = min(to, ceilf(x1));
+    }
 
-    while (spanCnt && spans < end ) {
-        if (spans->y > maxy) {
-            spans = end;
-            break;
-        }
-        if (spans->y < miny || spans->x > maxx || spans->x + spans->len <= minx) {
-            ++spans;
-            continue;
-        }
-        if (spans->x < minx) {
-            out->len = (spans->len - (minx - spans->x)) < (maxx - minx + 1) ? (spans->len - (minx - spans->x)) : (maxx - minx + 1);
-            out->x = minx;
-        }
-        else {
-            out->x = spans->x;
-            out->len = spans->len < (maxx - spans->x + 1) ? spans->len : (maxx - spans->x + 1);
+    auto begin = static_cast<int32_t>(floorf(from));
+    auto end = static_cast<int32_t>(ceilf(to));
+
+    for (auto c = begin; c < end; ++c) {
+        auto xa = max(seg.p0.x, static_cast<float>(c));
+        auto xb = min(seg.p1.x, static_cast<float>(c + 1));
+        auto fx = xb - xa;
+        if (fx <= 0.0f) continue;
+        auto yc = seg.p0.y + seg.slope * (0.5f * (xa + xb) - seg.p0.x);
+        auto top = max(yc - seg.half, minorMin);
+        auto bottom = min(yc + seg.half, minorMax);
+        for (auto r = static_cast<int32_t>(floorf(top)); r < bottom; ++r) {
+            auto cov = static_cast<uint32_t>((min(bottom, static_cast<float>(r + 1)) - max(top, static_cast<float>(r))) * fx * 256.0f);
+            auto dst = seg.steep ? &cover[(c - band.min.y) * stride + (r - band.min.x)] : &cover[(r - band.min.y) * stride + (c - band.min.x)];
+            if (cov > *dst) *dst = static_cast<uint16_t>(cov);
         }
-        if (out->len != 0) {
-            out->y = spans->y;
-            out->coverage = spans->coverage;
-            ++out;
-        }
-        ++spans;
-        --spanCnt;
     }
-    return out;
 }
 
-/************************************************************************/
-/* External Class Implementation                                        */
-/************************************************************************/
 
-SwRleData* rleRender(SwRleData* rle, const SwOutline* outline, const SwBBox& bbox, const SwSize& clip, bool antiAlias)
+static Point _hairlinePoint(const SwPoint& pt)
+{
+    return {static_cast<float>(pt.x) / 64.0f, static_cast<float>(pt.y) / 64.0f};
+}
+
+
+static SwRleData* _render(SwRleData* rle, const SwOutline* outline, const SwBBox& bbox, const SwSize& clip, bool antiAlias)
 {
     constexpr auto RENDER_POOL_SIZE = 16384L;
     constexpr auto BAND_SIZE = 40;
@@ -730,7 +767,6 @@ SwRleData* rleRender(SwRleData* rle, const SwOutline* outline, const SwBBox& bbo
     rw.cellMax = bbox.max;
     rw.cellXCnt = rw.cellMax.x - rw.cellMin.x;
     rw.cellYCnt = rw.cellMax.y - rw.cellMin.y;
-    rw.ySpan = 0;
     rw.outline = const_cast<SwOutline*>(outline);
     rw.bandSize = rw.bufferSize / (sizeof(Cell) * 8);  //bandSize: 64
     rw.bandShoot = 0;
@@ -739,6 +775,7 @@ SwRleData* rleRender(SwRleData* rle, const SwOutline* outline, const SwBBox& bbo
 
     if (!rle) rw.rle = reinterpret_cast<SwRleData*>(calloc(1, sizeof(SwRleData)));
     else rw.rle = rle;
+    rleReset(rw.rle);
 
     //Generate RLE
     Band bands[BAND_SIZE];
@@ -826,66 +863,277 @@ SwRleData* rleRender(SwRleData* rle, const SwOutline* outline, const SwBBox& bbo
     return rw.rle;
 
 error:
-    free(rw.rle);
-    rw.rle = nullptr;
+    rleFree(rw.rle);
     return nullptr;
 }
 
 
-void rleReset(SwRleData* rle)
+//Adds the rows below the ones of the rle.
+static void _appendRows(SwRleData* rle, const SwRleData* rows)
 {
-    if (!rle) return;
-    rle->size = 0;
+    for (auto y = rows->top; y < rows->bottom; ++y) {
+        for (auto span = RLE_ROW(rows, y); span < RLE_ROW(rows, y + 1); ++span) {
+            auto dst = _genSpan(rle, y);
+            if (!dst) return;
+            *dst = *span;
+        }
+    }
 }
 
 
-void rleFree(SwRleData* rle)
+//Rows of a large outline rasterized on another worker
+struct RleBand : Task
+{
+    const SwOutline* outline;
+    SwBBox bbox;
+    SwSize clip;
+    bool antiAlias;
+    SwRleData* rle = nullptr;
+
+    void run(TVG_UNUSED unsigned tid) override
+    {
+        rle = _render(nullptr, outline, bbox, clip, antiAlias);
+    }
+};
+
+
+/************************************************************************/
+/* External Class Implementation                                        */
+/************************************************************************/
+
+void rleReset(SwRleData* rle)
 {
     if (!rle) return;
-    if (rle->spans) free(rle->spans);
-    free(rle);
+    rle->size = 0;
+    rle->top = rle->bottom = 0;
 }
 
-void updateRleSpans(SwRleData *rle, SwSpan* curSpans, uint32_t size)
+
+SwRleData* rleRender(SwRleData* rle, const SwOutline* outline, const SwBBox& bbox, const SwSize& clip, bool antiAlias)
 {
-    if (!rle->spans || !curSpans || size == 0) return;
-    rle->size = size;
-    rle->spans = static_cast<SwSpan*>(realloc(rle->spans, rle->size * sizeof(SwSpan)));
+    constexpr auto BAND_ROWS = 256;
+
+    //Tall outlines are split into the bands of rows, the workers rasterize them together.
+    auto top = max(bbox.min.y, 0L);
+    auto bottom = min(bbox.max.y, clip.h);
+    auto cnt = min((bottom - top) / BAND_ROWS, static_cast<SwCoord>(TaskScheduler::threads()));
+    if (cnt < 2) return _render(rle, outline, bbox, clip, antiAlias);
+
+    auto rows = (bottom - top + cnt - 1) / cnt;
+    vector<RleBand> bands(cnt - 1);
+
+    for (SwCoord i = 1; i < cnt; ++i) {
+        auto& band = bands[i - 1];
+        band.outline = outline;
+        band.bbox = {{bbox.min.x, top + rows * i}, {bbox.max.x, min(top + rows * (i + 1), bottom)}};
+        band.clip = clip;
+        band.antiAlias = antiAlias;
+        TaskScheduler::request(&band);
+    }
 
-    if (!rle->spans) return;
+    //the first band is made here
+    rle = _render(rle, outline, {{bbox.min.x, top}, {bbox.max.x, top + rows}}, clip, antiAlias);
 
-    for (int i = 0; i < (int)rle->size ; i++)
-    {
-       rle->spans[i].x = curSpans[i].x;
-       rle->spans[i].y = curSpans[i].y;
-       rle->spans[i].len = curSpans[i].len;
-       rle->spans[i].coverage = curSpans[i].coverage;
+    //the spans are sorted by rows, the bands are appended in order.
+    for (auto& band : bands) {
+        band.done();
+        if (!band.rle) continue;
+        if (rle) _appendRows(rle, band.rle);
+        rleFree(band.rle);
     }
+
+    return rle;
 }
 
-void rleClipPath(SwRleData *rle, const SwRleData *clip)
+
+SwRleData* rleHairline(SwRleData* rle, const SwOutline* outline, float width, const Matrix* transform, bool round, const SwSize& clip)
 {
-    if (rle->size == 0 || clip->size == 0) return;
-    auto spanCnt = rle->size > clip->size ? rle->size : clip->size;
-    auto spans = static_cast<SwSpan*>(malloc(sizeof(SwSpan) * (spanCnt)));
-    if (!spans) return;
-    auto spansEnd = _intersectSpansRegion(clip, rle, spans, spanCnt);
+    constexpr auto BAND_PIXELS = 65536;
+
+    if (!rle) rle = static_cast<SwRleData*>(calloc(1, sizeof(SwRleData)));
+    rleReset(rle);
+
+    vector<HairlineSegment> segments;
+    vector<Point> poly;
+    uint32_t first = 0;
+
+    //a round cap takes the length of the same area
+    auto cap = round ? (static_cast<float>(M_PI) / 8.0f) : 0.0f;
+
+    for (uint32_t i = 0; i < outline->cntrsCnt; ++i) {
+        auto last = outline->cntrs[i];
+        auto pts = outline->pts;
+        auto types = outline->types;
+
+        //The closed contours end on their first point.
+        auto closed = (last > first + 1 && pts[first].x == pts[last].x && pts[first].y == pts[last].y);
+
+        poly.clear();
+        poly.push_back(_hairlinePoint(pts[first]));
+        auto idx = first + 1;
+
+        while (idx <= last) {
+            if (types[idx] == SW_CURVE_TYPE_CUBIC && idx + 2 <= last) {
+                Bezier bz = {poly.back(), _hairlinePoint(pts[idx]), _hairlinePoint(pts[idx + 1]), _hairlinePoint(pts[idx + 2])};
+                //uniform flattening, the error is bound by the second differences.
+                auto ddx = max(fabsf(bz.start.x - 2 * bz.ctrl1.x + bz.ctrl2.x), fabsf(bz.ctrl1.x - 2 * bz.ctrl2.x + bz.end.x));
+                auto ddy = max(fabsf(bz.start.y - 2 * bz.ctrl1.y + bz.ctrl2.y), fabsf(bz.ctrl1.y - 2 * bz.ctrl2.y + bz.end.y));
+                auto n = min(max(static_cast<int32_t>(ceilf(sqrtf(sqrtf(ddx * ddx + ddy * ddy) * 7.5f))), 1), 256);
+                for (auto k = 1; k <= n; ++k) {
+                    poly.push_back((k == n) ? bz.end : bezPointAt(bz, static_cast<float>(k) / n));
+                }
+                idx += 3;
+            } else {
+                poly.push_back(_hairlinePoint(pts[idx]));
+                ++idx;
+            }
+        }
+        first = last + 1;
+
+        //caps are only on the ends of the opened contours
+        auto cnt = poly.size();
+        for (size_t k = 1; k < cnt; ++k) {
+            auto head = (k > 1) ? _hairlineJoint(poly[k - 2], poly[k - 1], poly[k]) : (closed ? _hairlineJoint(poly[cnt - 2], poly[0], poly[1]) : 0.0f);
+            auto tail = (k + 1 < cnt) ? _hairlineJoint(poly[k - 1], poly[k], poly[k + 1]) : (closed ? _hairlineJoint(poly[k - 1], poly[k], poly[1]) : 0.0f);
+            auto cap0 = (k == 1 && !closed) ? cap : 0.0f;
+            auto cap1 = (k + 1 == cnt && !closed) ? cap : 0.0f;
+            _hairlineSegment(segments, poly[k - 1], poly[k], width, transform, cap0, cap1, head, tail);
+        }
+    }
+
+    if (segments.empty()) return rle;
 
-    //Update Spans
-    updateRleSpans(rle, spans, spansEnd - spans);
+    SwBBox bbox = segments.front().bbox;
+    for (auto& seg : segments) {
+        bbox.min.x = min(bbox.min.x, seg.bbox.min.x);
+        bbox.min.y = min(bbox.min.y, seg.bbox.min.y);
+        bbox.max.x = max(bbox.max.x, seg.bbox.max.x);
+        bbox.max.y = max(bbox.max.y, seg.bbox.max.y);
+    }
+    bbox.min.x = max(bbox.min.x, 0L);
+    bbox.min.y = max(bbox.min.y, 0L);
+    bbox.max.x = min(bbox.max.x, clip.w);
+    bbox.max.y = min(bbox.max.y, clip.h);
+    if (bbox.max.x <= bbox.min.x || bbox.max.y <= bbox.min.y) return rle;
+
+    //The coverage is accumulated by the bands of rows, then the rows are written as spans.
+    auto w = bbox.max.x - bbox.min.x;
+    auto bandSize = std::max(BAND_PIXELS / w, 1L);
+    vector<uint16_t> cover(w * bandSize);
+
+    for (auto y = bbox.min.y; y < bbox.max.y; y += bandSize) {
+        SwBBox band = {{bbox.min.x, y}, {bbox.max.x, min(y + bandSize, bbox.max.y)}};
+        memset(cover.data(), 0, cover.size() * sizeof(uint16_t));
+
+        for (auto& seg : segments) {
+            if (seg.bbox.max.y <= band.min.y || seg.bbox.min.y >= band.max.y) continue;
+            if (seg.bbox.max.x <= band.min.x || seg.bbox.min.x >= band.max.x) continue;
+            _hairlineBand(seg, cover.data(), band);
+        }
+
+        for (auto r = band.min.y; r < band.max.y; ++r) {
+            auto row = cover.data() + (r - band.min.y) * w;
+            for (SwCoord x = 0; x < w;) {
+                if (row[x] == 0) {
+                    ++x;
+                    continue;
+                }
+                //segments meeting on a pixel take the largest coverage
+                auto coverage = min(row[x], static_cast<uint16_t>(255));
+                auto start = x;
+                while (++x < w && min(row[x], static_cast<uint16_t>(255)) == coverage && x - start < UINT16_MAX);
+
+                auto span = _genSpan(rle, r);
+                if (!span) return rle;
+                span->x = static_cast<int32_t>(bbox.min.x + start);
+                span->len = static_cast<uint16_t>(x - start);
+                span->coverage = static_cast<uint8_t>(coverage);
+            }
+        }
+    }
 
-    if (spans) free(spans);
+    return rle;
 }
 
-void rleClipRect(SwRleData *rle, const SwBBox* clip)
+
+void rleFree(SwRleData* rle)
 {
-    if (rle->size == 0) return;
-    auto spans = static_cast<SwSpan*>(malloc(sizeof(SwSpan) * (rle->size)));
-    if (!spans) return;
-    auto spansEnd = _intersectSpansRect(clip, rle, spans, rle->size);
+    if (!rle) return;
+    if (rle->spans) free(rle->spans);
+    if (rle->rows) free(rle->rows);
+    free(rle);
+}
 
-    //Update Spans
-    updateRleSpans(rle, spans, spansEnd - spans);
+SwRleData* rleClipRect(const SwRleData* rle, const SwBBox& clip, SwRleData* out, SwRleData* buffer)
+{
+    //The rows in the clip
+    auto top = max(rle->top, clip.min.y);
+    auto bottom = min(rle->bottom, clip.max.y);
+    if (top >= bottom) return _view(out, rle->spans, nullptr, 0, 0);
+
+    auto begin = RLE_ROW(rle, top);
+    auto end = RLE_ROW(rle, bottom);
+
+    //The spans are shared as long as none of them crosses the clip sides.
+    auto span = begin;
+    while (span < end && span->x >= clip.min.x && span->x + span->len <= clip.max.x) ++span;
+    if (span == end) return _view(out, rle->spans, rle->rows + (top - rle->top), top, bottom);
+
+    auto spans = _reserveSpans(buffer, end - begin);
+    auto rows = _reserveRows(buffer, bottom - top + 1);
+    if (!spans || !rows) return nullptr;
+
+    auto dst = spans;
+    for (auto y = top; y < bottom; ++y) {
+        rows[y - top] = dst - spans;
+        for (span = RLE_ROW(rle, y); span < RLE_ROW(rle, y + 1); ++span) {
+            auto x1 = max(static_cast<SwCoord>(span->x), clip.min.x);
+            auto x2 = min(static_cast<SwCoord>(span->x + span->len), clip.max.x);
+            if (x2 <= x1) continue;
+            dst->x = x1;
+            dst->len = x2 - x1;
+            dst->coverage = span->coverage;
+            ++dst;
+        }
+    }
+    rows[bottom - top] = dst - spans;
+    return _view(out, spans, rows, top, bottom);
+}
 
-    if (spans) free(spans);
+
+SwRleData* rleClipPath(const SwRleData* rle, const SwRleData* clip, SwRleData* out, SwRleData* buffer)
+{
+    //The rows in both
+    auto top = max(rle->top, clip->top);
+    auto bottom = min(rle->bottom, clip->bottom);
+    if (top >= bottom) return _view(out, rle->spans, nullptr, 0, 0);
+
+    //Each overlap ends a span of either one.
+    auto spans = _reserveSpans(buffer, rle->size + clip->size);
+    auto rows = _reserveRows(buffer, bottom - top + 1);
+    if (!spans || !rows) return nullptr;
+
+    auto dst = spans;
+    for (auto y = top; y < bottom; ++y) {
+        rows[y - top] = dst - spans;
+        auto span = RLE_ROW(rle, y);
+        auto end = RLE_ROW(rle, y + 1);
+        auto cspan = RLE_ROW(clip, y);
+        auto cend = RLE_ROW(clip, y + 1);
+
+        while (span < end && cspan < cend) {
+            auto x1 = max(span->x, cspan->x);
+            auto x2 = min(span->x + span->len, cspan->x + cspan->len);
+            if (x1 < x2) {
+                dst->x = x1;
+                dst->len = x2 - x1;
+                dst->coverage = static_cast<uint8_t>((span->coverage * cspan->coverage + 255) >> 8);
+                ++dst;
+            }
+            if (span->x + span->len < cspan->x + cspan->len) ++span;
+            else ++cspan;
+        }
+    }
+    rows[bottom - top] = dst - spans;
+    return _view(out, spans, rows, top, bottom);
 }
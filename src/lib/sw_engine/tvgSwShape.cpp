@@ -20,44 +20,11 @@
  * SOFTWARE.
  */
 #include "tvgSwCommon.h"
-#include "tvgBezier.h"
 
 /************************************************************************/
 /* Internal Class Implementation                                        */
 /************************************************************************/
 
-struct Line
-{
-    Point pt1;
-    Point pt2;
-};
-
-
-static float _lineLength(const Point& pt1, const Point& pt2)
-{
-    /* approximate sqrt(x*x + y*y) using alpha max plus beta min algorithm.
-       With alpha = 1, beta = 3/8, giving results with the largest error less
-       than 7% compared to the exact value. */
-    Point diff = {pt2.x - pt1.x, pt2.y - pt1.y};
-    if (diff.x < 0) diff.x = -diff.x;
-    if (diff.y < 0) diff.y = -diff.y;
-    return (diff.x > diff.y) ? (diff.x + diff.y * 0.375f) : (diff.y + diff.x * 0.375f);
-}
-
-
-static void _lineSplitAt(const Line& cur, float at, Line& left, Line& right)
-{
-    auto len = _lineLength(cur.pt1, cur.pt2);
-    auto dx = ((cur.pt2.x - cur.pt1.x) / len) * at;
-    auto dy = ((cur.pt2.y - cur.pt1.y) / len) * at;
-    left.pt1 = cur.pt1;
-    left.pt2.x = left.pt1.x + dx;
-    left.pt2.y = left.pt1.y + dy;
-    right.pt1 = left.pt2;
-    right.pt2 = cur.pt2;
-}
-
-
 static void _growOutlineContour(SwOutline& outline, uint32_t n)
 {
     if (outline.reservedCntrsCnt >= outline.cntrsCnt + n) return;
@@ -210,99 +177,73 @@ static bool _checkValid(const SwOutline* outline, const SwBBox& bbox, const SwSi
 }
 
 
-static void _dashLineTo(SwDashStroke& dash, const Point* to, const Matrix* transform)
+bool _fastTrack(const SwOutline* outline)
 {
-    _growOutlinePoint(*dash.outline, dash.outline->ptsCnt >> 1);
-    _growOutlineContour(*dash.outline, dash.outline->cntrsCnt >> 1);
+    //Fast Track: Othogonal rectangle?
+    if (outline->ptsCnt != 5) return false;
 
-    Line cur = {dash.ptCur, *to};
-    auto len = _lineLength(cur.pt1, cur.pt2);
+    auto pt1 = outline->pts + 0;
+    auto pt2 = outline->pts + 1;
+    auto pt3 = outline->pts + 2;
+    auto pt4 = outline->pts + 3;
 
-    if (len < dash.curLen) {
-        dash.curLen -= len;
-        if (!dash.curOpGap) {
-            _outlineMoveTo(*dash.outline, &dash.ptCur, transform);
-            _outlineLineTo(*dash.outline, to, transform);
-        }
-    } else {
-        while (len > dash.curLen) {
-            len -= dash.curLen;
-            Line left, right;
-            _lineSplitAt(cur, dash.curLen, left, right);;
-            dash.curIdx = (dash.curIdx + 1) % dash.cnt;
-            if (!dash.curOpGap) {
-                _outlineMoveTo(*dash.outline, &left.pt1, transform);
-                _outlineLineTo(*dash.outline, &left.pt2, transform);
-            }
-            dash.curLen = dash.pattern[dash.curIdx];
-            dash.curOpGap = !dash.curOpGap;
-            cur = right;
-            dash.ptCur = cur.pt1;
-        }
-        //leftovers
-        dash.curLen -= len;
-        if (!dash.curOpGap) {
-            _outlineMoveTo(*dash.outline, &cur.pt1, transform);
-            _outlineLineTo(*dash.outline, &cur.pt2, transform);
-        }
-        if (dash.curLen < 1 && TO_SWCOORD(len) > 1) {
-            //move to next dash
-            dash.curIdx = (dash.curIdx + 1) % dash.cnt;
-            dash.curLen = dash.pattern[dash.curIdx];
-            dash.curOpGap = !dash.curOpGap;
-        }
-    }
-    dash.ptCur = *to;
+    auto a = SwPoint{pt1->x, pt3->y};
+    auto b = SwPoint{pt3->x, pt1->y};
+
+    if ((*pt2 == a && *pt4 == b) || (*pt2 == b && *pt4 == a)) return true;
+
+    return false;
 }
 
 
-static void _dashCubicTo(SwDashStroke& dash, const Point* ctrl1, const Point* ctrl2, const Point* to, const Matrix* transform)
+//Scale of the transform if it rotates and scales uniformly only, then strokes are the same in the path space.
+static bool _similar(const Matrix* transform, float& scale)
 {
-    _growOutlinePoint(*dash.outline, dash.outline->ptsCnt >> 1);
-    _growOutlineContour(*dash.outline, dash.outline->cntrsCnt >> 1);
+    if (!transform) return false;
 
-    Bezier cur = {dash.ptCur, *ctrl1, *ctrl2, *to};
-    auto len = bezLength(cur);
+    scale = sqrtf(transform->e11 * transform->e11 + transform->e21 * transform->e21);
 
-    if (len < dash.curLen) {
-        dash.curLen -= len;
-        if (!dash.curOpGap) {
-            _outlineMoveTo(*dash.outline, &dash.ptCur, transform);
-            _outlineCubicTo(*dash.outline, ctrl1, ctrl2, to, transform);
-        }
-    } else {
-        while (len > dash.curLen) {
-            Bezier left, right;
-            len -= dash.curLen;
-            bezSplitAt(cur, dash.curLen, left, right);
-            dash.curIdx = (dash.curIdx + 1) % dash.cnt;
-            if (!dash.curOpGap) {
-                _outlineMoveTo(*dash.outline, &left.start, transform);
-                _outlineCubicTo(*dash.outline, &left.ctrl1, &left.ctrl2, &left.end, transform);
-            }
-            dash.curLen = dash.pattern[dash.curIdx];
-            dash.curOpGap = !dash.curOpGap;
-            cur = right;
-            dash.ptCur = right.start;
-        }
-        //leftovers
-        dash.curLen -= len;
-        if (!dash.curOpGap) {
-            _outlineMoveTo(*dash.outline, &cur.start, transform);
-            _outlineCubicTo(*dash.outline, &cur.ctrl1, &cur.ctrl2, &cur.end, transform);
-        }
-        if (dash.curLen < 1 && TO_SWCOORD(len) > 1) {
-            //move to next dash
-            dash.curIdx = (dash.curIdx + 1) % dash.cnt;
-            dash.curLen = dash.pattern[dash.curIdx];
-            dash.curOpGap = !dash.curOpGap;
-        }
+    auto tolerance = scale * 1e-4f;
+    if (fabsf(transform->e11 - transform->e22) > tolerance || fabsf(transform->e12 + transform->e21) > tolerance) return false;
+
+    return (scale > 0.0f);
+}
+
+
+static bool _genStrokeRle(SwShape* shape, SwOutline* strokeOutline, const SwSize& clip)
+{
+    SwBBox bbox;
+    _updateBBox(strokeOutline, bbox);
+
+    if (!_checkValid(strokeOutline, bbox, clip)) return false;
+
+    shape->strokeRle = rleRender(shape->strokeRle, strokeOutline, bbox, clip, true);
+
+    return true;
+}
+
+
+//Sub-pixel strokes are drawn along the path, their joins are too small to be seen. Square caps take the stroker.
+static bool _hairline(const Shape* sdata, const Matrix* transform)
+{
+    constexpr auto HAIRLINE_WIDTH = 1.0f;
+
+    if (sdata->strokeDash(nullptr) > 0) return false;
+    if (sdata->strokeCap() == StrokeCap::Square) return false;
+
+    auto width = sdata->strokeWidth();
+
+    //the largest scale of the transform
+    if (transform) {
+        auto sum = transform->e11 * transform->e11 + transform->e12 * transform->e12 + transform->e21 * transform->e21 + transform->e22 * transform->e22;
+        auto det = transform->e11 * transform->e22 - transform->e12 * transform->e21;
+        width *= sqrtf(0.5f * (sum + sqrtf(max(sum * sum - 4.0f * det * det, 0.0f))));
     }
-    dash.ptCur = *to;
+    return width <= HAIRLINE_WIDTH;
 }
 
 
-SwOutline* _genDashOutline(const Shape* sdata, const Matrix* transform)
+static bool _genOutline(SwOutline* outline, const Shape* sdata, const Matrix* transform)
 {
     const PathCommand* cmds = nullptr;
     auto cmdCnt = sdata->pathCommands(&cmds);
@@ -311,23 +252,7 @@ SwOutline* _genDashOutline(const Shape* sdata, const Matrix* transform)
     auto ptsCnt = sdata->pathCoords(&pts);
 
     //No actual shape data
-    if (cmdCnt == 0 || ptsCnt == 0) return nullptr;
-
-    SwDashStroke dash;
-    dash.curIdx = 0;
-    dash.curLen = 0;
-    dash.ptStart = {0, 0};
-    dash.ptCur = {0, 0};
-    dash.curOpGap = false;
-
-    const float* pattern;
-    dash.cnt = sdata->strokeDash(&pattern);
-    if (dash.cnt == 0) return nullptr;
-
-    //Is it safe to mutual exclusive?
-    dash.pattern = const_cast<float*>(pattern);
-    dash.outline = static_cast<SwOutline*>(calloc(1, sizeof(SwOutline)));
-    dash.outline->opened = true;
+    if (cmdCnt == 0 || ptsCnt == 0) return false;
 
     //smart reservation
     auto outlinePtsCnt = 0;
@@ -358,32 +283,33 @@ SwOutline* _genDashOutline(const Shape* sdata, const Matrix* transform)
     ++outlinePtsCnt;    //for close
     ++outlineCntrsCnt;  //for end
 
-    //Reserve Approximitely 20x...
-    _growOutlinePoint(*dash.outline, outlinePtsCnt * 20);
-    _growOutlineContour(*dash.outline, outlineCntrsCnt * 20);
+    outline->opened = true;
+
+    _growOutlinePoint(*outline, outlinePtsCnt);
+    _growOutlineContour(*outline, outlineCntrsCnt);
 
+    auto closed = false;
+
+    //Generate Outlines
     while (cmdCnt-- > 0) {
         switch(*cmds) {
             case PathCommand::Close: {
-                _dashLineTo(dash, &dash.ptStart, transform);
+                _outlineClose(*outline);
+                closed = true;
                 break;
             }
             case PathCommand::MoveTo: {
-                //reset the dash
-                dash.curIdx = 0;
-                dash.curLen = *dash.pattern;
-                dash.curOpGap = false;
-                dash.ptStart = dash.ptCur = *pts;
+                _outlineMoveTo(*outline, pts, transform);
                 ++pts;
                 break;
             }
             case PathCommand::LineTo: {
-                _dashLineTo(dash, pts, transform);
+                _outlineLineTo(*outline, pts, transform);
                 ++pts;
                 break;
             }
             case PathCommand::CubicTo: {
-                _dashCubicTo(dash, pts, pts + 1, pts + 2, transform);
+                _outlineCubicTo(*outline, pts, pts + 1, pts + 2, transform);
                 pts += 3;
                 break;
             }
@@ -391,31 +317,15 @@ SwOutline* _genDashOutline(const Shape* sdata, const Matrix* transform)
         ++cmds;
     }
 
-    _outlineEnd(*dash.outline);
-
-    return dash.outline;
-}
-
-
-bool _fastTrack(const SwOutline* outline)
-{
-    //Fast Track: Othogonal rectangle?
-    if (outline->ptsCnt != 5) return false;
-
-    auto pt1 = outline->pts + 0;
-    auto pt2 = outline->pts + 1;
-    auto pt3 = outline->pts + 2;
-    auto pt4 = outline->pts + 3;
+    _outlineEnd(*outline);
 
-    auto a = SwPoint{pt1->x, pt3->y};
-    auto b = SwPoint{pt3->x, pt1->y};
+    if (closed) outline->opened = false;
 
-    if ((*pt2 == a && *pt4 == b) || (*pt2 == b && *pt4 == a)) return true;
+    outline->fillRule = sdata->fillRule();
 
-    return false;
+    return true;
 }
 
-
 /************************************************************************/
 /* External Class Implementation                                        */
 /************************************************************************/
@@ -438,14 +348,14 @@ bool shapePrepared(SwShape* shape)
 }
 
 
-bool shapeGenRle(SwShape* shape, TVG_UNUSED const Shape* sdata, const SwSize& clip, bool antiAlias, bool hasComposite)
+bool shapeGenRle(SwShape* shape, TVG_UNUSED const Shape* sdata, const SwSize& clip, bool antiAlias)
 {
     //FIXME: Should we draw it?
     //Case: Stroke Line
     //if (shape.outline->opened) return true;
 
     //Case A: Fast Track Rectangle Drawing
-    if (!hasComposite && (shape->rect = _fastTrack(shape->outline))) return true;
+    if ((shape->rect = _fastTrack(shape->outline))) return true;
     //Case B: Normale Shape RLE Drawing
     if ((shape->rle = rleRender(shape->rle, shape->outline, shape->bbox, clip, antiAlias))) return true;
 
@@ -470,85 +380,8 @@ void shapeReset(SwShape* shape)
 
 bool shapeGenOutline(SwShape* shape, const Shape* sdata, unsigned tid, const Matrix* transform)
 {
-    const PathCommand* cmds = nullptr;
-    auto cmdCnt = sdata->pathCommands(&cmds);
-
-    const Point* pts = nullptr;
-    auto ptsCnt = sdata->pathCoords(&pts);
-
-    //No actual shape data
-    if (cmdCnt == 0 || ptsCnt == 0) return false;
-
-    //smart reservation
-    auto outlinePtsCnt = 0;
-    auto outlineCntrsCnt = 0;
-
-    for (uint32_t i = 0; i < cmdCnt; ++i) {
-        switch(*(cmds + i)) {
-            case PathCommand::Close: {
-                ++outlinePtsCnt;
-                break;
-            }
-            case PathCommand::MoveTo: {
-                ++outlineCntrsCnt;
-                ++outlinePtsCnt;
-                break;
-            }
-            case PathCommand::LineTo: {
-                ++outlinePtsCnt;
-                break;
-            }
-            case PathCommand::CubicTo: {
-                outlinePtsCnt += 3;
-                break;
-            }
-        }
-    }
-
-    ++outlinePtsCnt;    //for close
-    ++outlineCntrsCnt;  //for end
-
-    shape->outline = mpoolReqOutline(tid);
-    auto outline = shape->outline;
-    outline->opened = true;
-
-    _growOutlinePoint(*outline, outlinePtsCnt);
-    _growOutlineContour(*outline, outlineCntrsCnt);
-
-    auto closed = false;
-
-    //Generate Outlines
-    while (cmdCnt-- > 0) {
-        switch(*cmds) {
-            case PathCommand::Close: {
-                _outlineClose(*outline);
-                closed = true;
-                break;
-            }
-            case PathCommand::MoveTo: {
-                _outlineMoveTo(*outline, pts, transform);
-                ++pts;
-                break;
-            }
-            case PathCommand::LineTo: {
-                _outlineLineTo(*outline, pts, transform);
-                ++pts;
-                break;
-            }
-            case PathCommand::CubicTo: {
-                _outlineCubicTo(*outline, pts, pts + 1, pts + 2, transform);
-                pts += 3;
-                break;
-            }
-        }
-        ++cmds;
-    }
-
-    _outlineEnd(*outline);
-
-    if (closed) outline->opened = false;
-
-    outline->fillRule = sdata->fillRule();
+    auto outline = mpoolReqOutline(tid);
+    if (!_genOutline(outline, sdata, transform)) return false;
     shape->outline = outline;
 
     return true;
@@ -577,6 +410,12 @@ void shapeDelStroke(SwShape* shape)
 }
 
 
+void shapeResetDash(SwShape* shape)
+{
+    if (shape->stroke) strokeResetDash(shape->stroke);
+}
+
+
 void shapeResetStroke(SwShape* shape, const Shape* sdata, const Matrix* transform)
 {
     if (!shape->stroke) shape->stroke = static_cast<SwStroke*>(calloc(1, sizeof(SwStroke)));
@@ -590,27 +429,39 @@ void shapeResetStroke(SwShape* shape, const Shape* sdata, const Matrix* transfor
 
 bool shapeGenStrokeRle(SwShape* shape, const Shape* sdata, unsigned tid, const Matrix* transform, const SwSize& clip)
 {
-    SwOutline* shapeOutline = nullptr;
     SwOutline* strokeOutline = nullptr;
-    bool freeOutline = false;
     bool ret = true;
 
-    //Dash Style Stroke
+    if (_hairline(sdata, transform)) {
+        if (!shape->outline && !shapeGenOutline(shape, sdata, tid, transform)) return false;
+        shape->strokeRle = rleHairline(shape->strokeRle, shape->outline, sdata->strokeWidth(), transform, sdata->strokeCap() == StrokeCap::Round, clip);
+        return true;
+    }
+
+    //Stroked in the path space with the scale, the outline is placed again on the moves.
+    auto target = transform;
+    auto scale = 0.0f;
+    Matrix rest;
+    if (_similar(transform, scale)) {
+        rest = {scale, 0, 0, 0, scale, 0, 0, 0, 1};
+        transform = &rest;
+        shape->stroke->sx = shape->stroke->sy = scale;
+    }
+
+    //Dash Style Stroke, the dashes are stroked as they are cut from the path
     if (sdata->strokeDash(nullptr) > 0) {
-        shapeOutline = _genDashOutline(sdata, transform);
-        if (!shapeOutline) return false;
-        freeOutline = true;
+        if (!strokeParseDash(shape->stroke, sdata, transform)) return false;
+    //Normal Style stroke in the path space, the shape outline might be in use for the fill.
+    } else if (transform == &rest) {
+        //Made in the stroke outline, the export overwrites it after the parsing.
+        auto outline = mpoolReqStrokeOutline(tid);
+        auto parsed = _genOutline(outline, sdata, transform) && strokeParseOutline(shape->stroke, *outline);
+        mpoolRetStrokeOutline(tid);
+        if (!parsed) return false;
     //Normal Style stroke
     } else {
-        if (!shape->outline) {
-            if (!shapeGenOutline(shape, sdata, tid, transform)) return false;
-        }
-        shapeOutline = shape->outline;
-    }
-
-    if (!strokeParseOutline(shape->stroke, *shapeOutline)) {
-        ret = false;
-        goto fail;
+        if (!shape->outline && !shapeGenOutline(shape, sdata, tid, transform)) return false;
+        if (!strokeParseOutline(shape->stroke, *shape->outline)) return false;
     }
 
     strokeOutline = strokeExportOutline(shape->stroke, tid);
@@ -619,28 +470,40 @@ bool shapeGenStrokeRle(SwShape* shape, const Shape* sdata, unsigned tid, const M
         goto fail;
     }
 
-    SwBBox bbox;
-    _updateBBox(strokeOutline, bbox);
-
-    if (!_checkValid(strokeOutline, bbox, clip)) {
-        ret = false;
-        goto fail;
+    if (transform == &rest) {
+        strokeCacheOutline(shape->stroke, strokeOutline, scale);
+        strokeOutline = strokeMoveOutline(shape->stroke, target, scale, tid);
+        if (!strokeOutline) {
+            ret = false;
+            goto fail;
+        }
     }
 
-    shape->strokeRle = rleRender(shape->strokeRle, strokeOutline, bbox, clip, true);
+    ret = _genStrokeRle(shape, strokeOutline, clip);
 
 fail:
-    if (freeOutline) {
-        if (shapeOutline->cntrs) free(shapeOutline->cntrs);
-        if (shapeOutline->pts) free(shapeOutline->pts);
-        if (shapeOutline->types) free(shapeOutline->types);
-    }
     mpoolRetStrokeOutline(tid);
 
     return ret;
 }
 
 
+bool shapeMoveStroke(SwShape* shape, unsigned tid, const Matrix* transform, const SwSize& clip)
+{
+    auto scale = 0.0f;
+    if (!shape->stroke || !_similar(transform, scale)) return false;
+
+    auto strokeOutline = strokeMoveOutline(shape->stroke, transform, scale, tid);
+    if (!strokeOutline) return false;
+
+    rleReset(shape->strokeRle);
+    _genStrokeRle(shape, strokeOutline, clip);
+    mpoolRetStrokeOutline(tid);
+
+    return true;
+}
+
+
 bool shapeGenFillColors(SwShape* shape, const Fill* fill, const Matrix* transform, SwSurface* surface, bool ctable)
 {
     return fillGenColorTable(shape->fill, fill, transform, surface, ctable);
@@ -22,6 +22,7 @@
 #include <string.h>
 #include <math.h>
 #include "tvgSwCommon.h"
+#include "tvgBezier.h"
 
 
 /************************************************************************/
@@ -783,7 +784,7 @@ static void _exportBorderOutline(SwStroke& stroke, SwOutline* outline, uint32_t
     auto src = border->tags;
     auto tags = outline->types + outline->ptsCnt;
     auto cntrs = outline->cntrs + outline->cntrsCnt;
-    uint16_t idx = outline->ptsCnt;
+    auto idx = outline->ptsCnt;
 
     while (cnt > 0) {
 
@@ -807,6 +808,143 @@ static void _exportBorderOutline(SwStroke& stroke, SwOutline* outline, uint32_t
 }
 
 
+#define DASH_CURVE_STEPS 16
+
+//Arc lengths of the segment, the curves are measured at the even steps of their parameter.
+static const float* _dashLengths(SwDashStroke& dash, uint32_t& idx, const Point* pts, bool curve)
+{
+    uint32_t cnt = curve ? DASH_CURVE_STEPS : 1;
+
+    if (!dash.measured || idx + cnt > dash.lengthsCnt) {
+        if (dash.reservedLengthsCnt < idx + cnt) {
+            auto reserved = (idx + cnt) * 2;
+            auto lengths = static_cast<float*>(realloc(dash.lengths, reserved * sizeof(float)));
+            if (!lengths) return nullptr;
+            dash.lengths = lengths;
+            dash.reservedLengthsCnt = reserved;
+        }
+        auto lengths = dash.lengths + idx;
+        if (curve) {
+            Bezier bz = {pts[0], pts[1], pts[2], pts[3]};
+            auto prev = bz.start;
+            auto len = 0.0f;
+            for (uint32_t i = 1; i <= DASH_CURVE_STEPS; ++i) {
+                auto pt = bezPointAt(bz, static_cast<float>(i) / DASH_CURVE_STEPS);
+                len += sqrtf((pt.x - prev.x) * (pt.x - prev.x) + (pt.y - prev.y) * (pt.y - prev.y));
+                lengths[i - 1] = len;
+                prev = pt;
+            }
+        } else {
+            lengths[0] = sqrtf((pts[1].x - pts[0].x) * (pts[1].x - pts[0].x) + (pts[1].y - pts[0].y) * (pts[1].y - pts[0].y));
+        }
+        dash.lengthsCnt = idx + cnt;
+    }
+
+    auto lengths = dash.lengths + idx;
+    idx += cnt;
+    return lengths;
+}
+
+
+//Curve parameter at the arc length
+static float _dashAt(const float* lengths, float at)
+{
+    uint32_t i = 0;
+    while (i < DASH_CURVE_STEPS - 1 && lengths[i] < at) ++i;
+    auto prev = (i > 0) ? lengths[i - 1] : 0.0f;
+    auto len = lengths[i] - prev;
+    auto t = (len > 0.0f) ? (at - prev) / len : 1.0f;
+    return (static_cast<float>(i) + (t < 1.0f ? t : 1.0f)) / DASH_CURVE_STEPS;
+}
+
+
+static void _dashBegin(SwStroke& stroke, SwDashStroke& dash, const Point& from, const Matrix* transform)
+{
+    if (dash.drawing) return;
+
+    auto pt = mathTransform(&from, transform);
+    _beginSubPath(stroke, pt, true);
+    dash.drawing = true;
+}
+
+
+static void _dashEnd(SwStroke& stroke, SwDashStroke& dash)
+{
+    if (!dash.drawing) return;
+
+    if (!stroke.firstPt) _endSubPath(stroke);
+    dash.drawing = false;
+}
+
+
+//Start of the pattern, the offset moves the pattern along the path.
+static void _dashReset(SwDashStroke& dash, float offset, float total)
+{
+    dash.curIdx = 0;
+    dash.curOpGap = false;
+
+    auto pos = fmodf(offset, total);
+    if (pos < 0.0f) pos += total;
+
+    while (pos >= dash.pattern[dash.curIdx]) {
+        pos -= dash.pattern[dash.curIdx];
+        dash.curIdx = (dash.curIdx + 1) % dash.cnt;
+        dash.curOpGap = !dash.curOpGap;
+    }
+    dash.curLen = dash.pattern[dash.curIdx] - pos;
+}
+
+
+//Strokes the part of the segment between the arc lengths
+static void _dashTo(SwStroke& stroke, SwDashStroke& dash, const Point* pts, bool curve, const float* lengths, float from, float to, const Matrix* transform)
+{
+    if (curve) {
+        Bezier cur = {pts[0], pts[1], pts[2], pts[3]};
+        Bezier left;
+        auto t0 = _dashAt(lengths, from);
+        auto t1 = _dashAt(lengths, to);
+        if (t0 > 0.0f) bezSplitLeft(cur, t0, left);
+        if (t1 < 1.0f) {
+            bezSplitLeft(cur, (t1 - t0) / (1.0f - t0), left);
+            cur = left;
+        }
+        _dashBegin(stroke, dash, cur.start, transform);
+        _cubicTo(stroke, mathTransform(&cur.ctrl1, transform), mathTransform(&cur.ctrl2, transform), mathTransform(&cur.end, transform));
+    } else {
+        auto dx = (pts[1].x - pts[0].x) / lengths[0];
+        auto dy = (pts[1].y - pts[0].y) / lengths[0];
+        Point start = {pts[0].x + dx * from, pts[0].y + dy * from};
+        Point end = {pts[0].x + dx * to, pts[0].y + dy * to};
+        _dashBegin(stroke, dash, start, transform);
+        _lineTo(stroke, mathTransform(&end, transform));
+    }
+}
+
+
+static void _dashSegment(SwStroke& stroke, SwDashStroke& dash, const Point* pts, bool curve, const float* lengths, const Matrix* transform)
+{
+    auto len = lengths[curve ? DASH_CURVE_STEPS - 1 : 0];
+    auto pos = 0.0f;
+
+    //the dashes and the gaps ending on this segment
+    while (len - pos >= dash.curLen) {
+        auto end = pos + dash.curLen;
+        if (!dash.curOpGap) {
+            _dashTo(stroke, dash, pts, curve, lengths, pos, end, transform);
+            _dashEnd(stroke, dash);
+        }
+        pos = end;
+        dash.curIdx = (dash.curIdx + 1) % dash.cnt;
+        dash.curLen = dash.pattern[dash.curIdx];
+        dash.curOpGap = !dash.curOpGap;
+    }
+
+    //leftovers, the dash goes on the next segment
+    if (!dash.curOpGap && len > pos) _dashTo(stroke, dash, pts, curve, lengths, pos, len, transform);
+    dash.curLen -= (len - pos);
+}
+
+
 /************************************************************************/
 /* External Class Implementation                                        */
 /************************************************************************/
@@ -821,6 +959,14 @@ void strokeFree(SwStroke* stroke)
     if (stroke->borders[1].pts) free(stroke->borders[1].pts);
     if (stroke->borders[1].tags) free(stroke->borders[1].tags);
 
+    //free dash lengths
+    if (stroke->dash.lengths) free(stroke->dash.lengths);
+
+    //free cache
+    if (stroke->cache.pts) free(stroke->cache.pts);
+    if (stroke->cache.types) free(stroke->cache.types);
+    if (stroke->cache.cntrs) free(stroke->cache.cntrs);
+
     free(stroke);
 }
 
@@ -834,6 +980,7 @@ void strokeReset(SwStroke* stroke, const Shape* sdata, const Matrix* transform)
         stroke->sx = stroke->sy = 1.0f;
     }
 
+    stroke->scale = 0.0f;
     stroke->width = HALF_STROKE(sdata->strokeWidth());
     stroke->cap = sdata->strokeCap();
 
@@ -905,6 +1052,90 @@ bool strokeParseOutline(SwStroke* stroke, const SwOutline& outline)
 }
 
 
+bool strokeParseDash(SwStroke* stroke, const Shape* sdata, const Matrix* transform)
+{
+    const PathCommand* cmds = nullptr;
+    auto cmdCnt = sdata->pathCommands(&cmds);
+
+    const Point* pts = nullptr;
+    auto ptsCnt = sdata->pathCoords(&pts);
+
+    //No actual shape data
+    if (cmdCnt == 0 || ptsCnt == 0) return false;
+
+    auto& dash = stroke->dash;
+    dash.cnt = sdata->strokeDash(&dash.pattern);
+    if (dash.cnt == 0) return false;
+
+    //An odd pattern is repeated, so the dashes and the gaps are swapped in turn.
+    auto total = 0.0f;
+    for (uint32_t i = 0; i < dash.cnt; ++i) total += dash.pattern[i];
+    if (dash.cnt % 2) total *= 2.0f;
+    if (total <= 0.0f) return false;
+
+    auto offset = sdata->strokeDashOffset();
+    _dashReset(dash, offset, total);
+    dash.drawing = false;
+
+    Point start = {0, 0};
+    Point cur = {0, 0};
+    uint32_t idx = 0;
+
+    while (cmdCnt-- > 0) {
+        switch (*cmds) {
+            case PathCommand::Close: {
+                Point line[2] = {cur, start};
+                auto lengths = _dashLengths(dash, idx, line, false);
+                if (!lengths) return false;
+                _dashSegment(*stroke, dash, line, false, lengths, transform);
+                cur = start;
+                break;
+            }
+            case PathCommand::MoveTo: {
+                //every sub path starts the pattern again
+                _dashEnd(*stroke, dash);
+                _dashReset(dash, offset, total);
+                start = cur = *pts;
+                ++pts;
+                break;
+            }
+            case PathCommand::LineTo: {
+                Point line[2] = {cur, *pts};
+                auto lengths = _dashLengths(dash, idx, line, false);
+                if (!lengths) return false;
+                _dashSegment(*stroke, dash, line, false, lengths, transform);
+                cur = *pts;
+                ++pts;
+                break;
+            }
+            case PathCommand::CubicTo: {
+                Point curve[4] = {cur, pts[0], pts[1], pts[2]};
+                auto lengths = _dashLengths(dash, idx, curve, true);
+                if (!lengths) return false;
+                _dashSegment(*stroke, dash, curve, true, lengths, transform);
+                cur = pts[2];
+                pts += 3;
+                break;
+            }
+        }
+        ++cmds;
+    }
+    _dashEnd(*stroke, dash);
+
+    //the lengths are kept for the following updates
+    dash.lengthsCnt = idx;
+    dash.measured = true;
+
+    return true;
+}
+
+
+void strokeResetDash(SwStroke* stroke)
+{
+    stroke->dash.measured = false;
+}
+
+
 SwOutline* strokeExportOutline(SwStroke* stroke, unsigned tid)
 {
     uint32_t count1, count2, count3, count4;
@@ -929,5 +1160,80 @@ SwOutline* strokeExportOutline(SwStroke* stroke, unsigned tid)
     _exportBorderOutline(*stroke, outline, 0);  //left
     _exportBorderOutline(*stroke, outline, 1);  //right
 
+    //The borders overlap at the crossings, the stroke is filled as a whole regardless of the shape fill rule.
+    outline->fillRule = FillRule::Winding;
+
+    return outline;
+}
+
+
+void strokeCacheOutline(SwStroke* stroke, const SwOutline* outline, float scale)
+{
+    auto& cache = stroke->cache;
+
+    if (cache.reservedPtsCnt < outline->ptsCnt) {
+        cache.pts = static_cast<SwPoint*>(realloc(cache.pts, sizeof(SwPoint) * outline->ptsCnt));
+        cache.types = static_cast<uint8_t*>(realloc(cache.types, sizeof(uint8_t) * outline->ptsCnt));
+        cache.reservedPtsCnt = outline->ptsCnt;
+    }
+    if (cache.reservedCntrsCnt < outline->cntrsCnt) {
+        cache.cntrs = static_cast<uint32_t*>(realloc(cache.cntrs, sizeof(uint32_t) * outline->cntrsCnt));
+        cache.reservedCntrsCnt = outline->cntrsCnt;
+    }
+    if (!cache.pts || !cache.types || !cache.cntrs) {
+        stroke->scale = 0.0f;
+        return;
+    }
+
+    memcpy(cache.pts, outline->pts, sizeof(SwPoint) * outline->ptsCnt);
+    memcpy(cache.types, outline->types, sizeof(uint8_t) * outline->ptsCnt);
+    memcpy(cache.cntrs, outline->cntrs, sizeof(uint32_t) * outline->cntrsCnt);
+    cache.ptsCnt = outline->ptsCnt;
+    cache.cntrsCnt = outline->cntrsCnt;
+
+    stroke->scale = scale;
+}
+
+
+//The cached outline placed by the transform of the given scale, null if the cache is too coarse or too fine for it.
+SwOutline* strokeMoveOutline(SwStroke* stroke, const Matrix* transform, float scale, unsigned tid)
+{
+    if (stroke->scale <= 0.0f || scale < stroke->scale * 0.5f || scale > stroke->scale * 1.5f) return nullptr;
+
+    auto& cache = stroke->cache;
+
+    auto outline = mpoolReqStrokeOutline(tid);
+    if (outline->reservedPtsCnt < cache.ptsCnt) {
+        outline->pts = static_cast<SwPoint*>(realloc(outline->pts, sizeof(SwPoint) * cache.ptsCnt));
+        outline->types = static_cast<uint8_t*>(realloc(outline->types, sizeof(uint8_t) * cache.ptsCnt));
+        outline->reservedPtsCnt = cache.ptsCnt;
+    }
+    if (outline->reservedCntrsCnt < cache.cntrsCnt) {
+        outline->cntrs = static_cast<uint32_t*>(realloc(outline->cntrs, sizeof(uint32_t) * cache.cntrsCnt));
+        outline->reservedCntrsCnt = cache.cntrsCnt;
+    }
+
+    //The cache is scaled and shifted by half a pixel as the transformed points are.
+    auto e11 = transform->e11 / stroke->scale;
+    auto e12 = transform->e12 / stroke->scale;
+    auto e21 = transform->e21 / stroke->scale;
+    auto e22 = transform->e22 / stroke->scale;
+    auto e13 = transform->e13 + 0.5f;
+    auto e23 = transform->e23 + 0.5f;
+
+    auto src = cache.pts;
+    auto dst = outline->pts;
+    for (uint32_t i = 0; i < cache.ptsCnt; ++i, ++src, ++dst) {
+        auto x = src->x / 64.0f - 0.5f;
+        auto y = src->y / 64.0f - 0.5f;
+        *dst = {TO_SWCOORD(x * e11 + y * e12 + e13), TO_SWCOORD(x * e21 + y * e22 + e23)};
+    }
+
+    memcpy(outline->types, cache.types, sizeof(uint8_t) * cache.ptsCnt);
+    memcpy(outline->cntrs, cache.cntrs, sizeof(uint32_t) * cache.cntrsCnt);
+    outline->ptsCnt = cache.ptsCnt;
+    outline->cntrsCnt = cache.cntrsCnt;
+    outline->fillRule = FillRule::Winding;
+
     return outline;
 }
\ No newline at end of file
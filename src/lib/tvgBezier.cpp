@@ -147,4 +147,15 @@ void bezSplitAt(const Bezier& cur, float at, Bezier& left, Bezier& right)
     bezSplitLeft(right, t, left);
 }
 
+
+Point bezPointAt(const Bezier& bz, float t)
+{
+    auto it = 1.0f - t;
+    auto a = it * it * it;
+    auto b = 3.0f * it * it * t;
+    auto c = 3.0f * it * t * t;
+    auto d = t * t * t;
+    return {a * bz.start.x + b * bz.ctrl1.x + c * bz.ctrl2.x + d * bz.end.x, a * bz.start.y + b * bz.ctrl1.y + c * bz.ctrl2.y + d * bz.end.y};
+}
+
 }
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef _TVG_BINARY_DESC_H_
+#define _TVG_BINARY_DESC_H_
+
+#include <cstring>
+#include <utility>
+#include "tvgCommon.h"
+
+/* ThorVG binary scene format (.tvg)
+ *
+ * header : "ThorVG" magic, version(uint16), viewbox(4 x float)
+ * block  : tag(uint8), payload size(uint32), payload
+ *
+ * A paint block carries its properties and children as nested blocks in the payload.
+ * Unknown tags are skipped, so an old reader can still load a newer file.
+ * Values are written in little-endian without padding or pointers, readers don't assume
+ * any alignment. So the file is position independent and can be read in place from a
+ * memory-mapped region.
+ */
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    #define TVG_BIN_SWAP 1
+#else
+    #define TVG_BIN_SWAP 0
+#endif
+
+//Copies len bytes of unit sized values, converting them between the host and the file byte order.
+static inline void tvgBinCopy(void* dst, const void* src, uint32_t len, uint32_t unit)
+{
+    memcpy(dst, src, len);
+#if TVG_BIN_SWAP
+    if (unit < 2) return;
+    auto p = static_cast<uint8_t*>(dst);
+    for (auto end = p + len; p < end; p += unit) {
+        for (uint32_t i = 0; i < unit / 2; ++i) std::swap(p[i], p[unit - 1 - i]);
+    }
+#else
+    (void)unit;
+#endif
+}
+
+#define TVG_BIN_MAGIC "ThorVG"
+#define TVG_BIN_MAGIC_LEN 6
+#define TVG_BIN_VERSION 1
+#define TVG_BIN_HEADER_SIZE (TVG_BIN_MAGIC_LEN + sizeof(uint16_t) + 4 * sizeof(float))
+#define TVG_BIN_BLOCK_HEADER_SIZE (sizeof(uint8_t) + sizeof(uint32_t))
+
+enum class TvgBinTag : uint8_t
+{
+    //Paint classes
+    Scene = 0x01,
+    Shape = 0x02,
+    Picture = 0x03,
+
+    //Paint common
+    Opacity = 0x10,              //uint8
+    Transform = 0x11,            //Matrix
+    ClipPath = 0x12,             //Paint class block
+    AlphaMask = 0x13,            //Paint class block
+    InvAlphaMask = 0x14,         //Paint class block
+
+    //Shape
+    Path = 0x20,                 //cmdCnt(uint32), ptsCnt(uint32), cmds(uint8 x cmdCnt), pts(Point x ptsCnt)
+    FillRule = 0x21,             //uint8
+    Color = 0x22,                //r, g, b, a(uint8)
+    Fill = 0x23,                 //Fill blocks
+    Stroke = 0x24,               //Stroke blocks
+
+    //Stroke
+    StrokeWidth = 0x30,          //float
+    StrokeColor = 0x31,          //r, g, b, a(uint8)
+    StrokeCap = 0x32,            //uint8
+    StrokeJoin = 0x33,           //uint8
+    StrokeDash = 0x34,           //cnt(uint32), pattern(float x cnt), offset(float) when not zero
+
+    //Fill
+    LinearGradient = 0x40,       //x1, y1, x2, y2(float)
+    RadialGradient = 0x41,       //cx, cy, radius(float)
+    ColorStops = 0x42,           //cnt(uint32), (offset(float), r, g, b, a(uint8)) x cnt
+    Spread = 0x43,               //uint8
+    RadialFocal = 0x44,          //fx, fy(float), follows RadialGradient when the focal point is off the center
+
+    //Picture
+    RawImage = 0x50,             //w(uint32), h(uint32), pixels(uint32 x w x h)
+};
+
+#endif //_TVG_BINARY_DESC_H_
@@ -38,8 +38,7 @@ Canvas::~Canvas()
 
 Result Canvas::reserve(uint32_t n) noexcept
 {
-    pImpl->paints.reserve(n);
-    return Result::Success;
+    return pImpl->reserve(n);
 }
 
 
@@ -67,9 +66,13 @@ Result Canvas::update(Paint* paint) noexcept
 }
 
 
-Result Canvas::sync() noexcept
+Result Canvas::viewport(int32_t x, int32_t y, uint32_t w, uint32_t h) noexcept
 {
-    if (pImpl->renderer->sync()) return Result::Success;
+    return pImpl->viewport(x, y, w, h);
+}
+
 
-    return Result::InsufficientCondition;
+Result Canvas::sync() noexcept
+{
+    return pImpl->sync();
 }
\ No newline at end of file
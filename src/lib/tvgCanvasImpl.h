@@ -24,6 +24,7 @@
 
 #include <vector>
 #include "tvgPaint.h"
+#include "tvgTaskScheduler.h"
 
 /************************************************************************/
 /* Internal Class Implementation                                        */
@@ -31,11 +32,26 @@
 
 struct Canvas::Impl
 {
+    //Draws the paints after their preparations, off the caller thread.
+    struct DrawTask : Task
+    {
+        Canvas::Impl* canvas = nullptr;
+        bool success = true;
+
+        void run(TVG_UNUSED unsigned tid) override
+        {
+            success = canvas->render();
+        }
+    };
+
     vector<Paint*> paints;
     RenderMethod*  renderer;
+    DrawTask       drawer;
+    bool           refresh = false;     //every paint needs to be prepared again
 
     Impl(RenderMethod* pRenderer):renderer(pRenderer)
     {
+        drawer.canvas = this;
     }
 
     ~Impl()
@@ -44,10 +60,28 @@ struct Canvas::Impl
         delete(renderer);
     }
 
+    //Joins the drawing in progress.
+    void wait()
+    {
+        drawer.done();
+    }
+
+    Result reserve(uint32_t n)
+    {
+        //The drawing in progress iterates the paints.
+        wait();
+        paints.reserve(n);
+
+        return Result::Success;
+    }
+
     Result push(unique_ptr<Paint> paint)
     {
         auto p = paint.release();
         if (!p) return Result::MemoryCorruption;
+
+        //The drawing in progress iterates the paints.
+        wait();
         paints.push_back(p);
 
         return update(p);
@@ -57,6 +91,8 @@ struct Canvas::Impl
     {
         if (!renderer) return Result::InsufficientCondition;
 
+        wait();
+
         //Clear render target before drawing
         if (!renderer->clear()) return Result::InsufficientCondition;
 
@@ -77,10 +113,18 @@ struct Canvas::Impl
     {
         if (!renderer) return Result::InsufficientCondition;
 
+        wait();
+
         vector<Composite> compList;
 
+        //The paints are placed anew.
+        if (refresh) {
+            for (auto paint : paints) {
+                paint->pImpl->update(*renderer, nullptr, 255, compList, RenderUpdateFlag::Transform);
+            }
+            refresh = false;
         //Update single paint node
-        if (paint) {
+        } else if (paint) {
             paint->pImpl->update(*renderer, nullptr, 255, compList, RenderUpdateFlag::None);
         //Update all retained paint nodes
         } else {
@@ -91,17 +135,62 @@ struct Canvas::Impl
         return Result::Success;
     }
 
-    Result draw()
+    Result viewport(int32_t x, int32_t y, uint32_t w, uint32_t h)
     {
         if (!renderer) return Result::InsufficientCondition;
 
-        if (!renderer->preRender()) return Result::InsufficientCondition;
+        wait();
+
+        if (!renderer->viewport(x, y, w, h)) return Result::NonSupport;
+
+        refresh = true;
+
+        return Result::Success;
+    }
+
+    bool render()
+    {
+        if (!renderer->preRender()) return false;
 
         for (auto paint : paints) {
-            if (!paint->pImpl->render(*renderer)) return Result::InsufficientCondition;
+            if (!paint->pImpl->render(*renderer)) return false;
+        }
+
+        return renderer->postRender();
+    }
+
+    Result draw()
+    {
+        if (!renderer) return Result::InsufficientCondition;
+
+        wait();
+
+        if (refresh) update(nullptr);
+
+        //The engine takes a snapshot of the drawing and rasterizes it on its own, the paints can be updated right away.
+        if (renderer->record() && render()) return Result::Success;
+
+        //The drawing waits for the preparations of the paints on a worker, sync() joins it.
+        if (renderer->async() && TaskScheduler::threads() > 0) {
+            TaskScheduler::request(&drawer);
+            return Result::Success;
         }
 
-        if (!renderer->postRender()) return Result::InsufficientCondition;
+        if (!render()) return Result::InsufficientCondition;
+
+        return Result::Success;
+    }
+
+    Result sync()
+    {
+        if (!renderer) return Result::InsufficientCondition;
+
+        wait();
+
+        auto success = drawer.success;
+        drawer.success = true;
+
+        if (!renderer->sync() || !success) return Result::InsufficientCondition;
 
         return Result::Success;
     }
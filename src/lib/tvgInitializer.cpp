@@ -102,4 +102,20 @@ Result Initializer::term(CanvasEngine engine) noexcept
     initialized = false;
 
     return Result::Success;
-}
\ No newline at end of file
+}
+
+
+Result Initializer::cacheSize(uint32_t size) noexcept
+{
+    if (!LoaderMgr::cache(size)) return Result::Unknown;
+
+    return Result::Success;
+}
+
+
+Result Initializer::cacheStats(uint32_t* hits, uint32_t* misses, uint32_t* cnt) noexcept
+{
+    if (!LoaderMgr::cacheStats(hits, misses, cnt)) return Result::Unknown;
+
+    return Result::Success;
+}
@@ -36,15 +36,25 @@ public:
     float vw = 0;
     float vh = 0;
 
+    //pixels per row of the raw image, if any.
+    uint32_t stride = 0;
+
+    //every pixel of the raw image has the full alpha.
+    bool opaque = false;
+
     virtual ~Loader() {}
 
     virtual bool open(const string& path) { /* Not supported */ return false; };
     virtual bool open(const char* data, uint32_t size) { /* Not supported */ return false; };
-    virtual bool open(const uint32_t* data, uint32_t w, uint32_t h, bool copy) { /* Not supported */ return false; };
+    virtual bool open(const uint32_t* data, uint32_t w, uint32_t h, uint32_t stride, bool copy) { /* Not supported */ return false; };
     virtual bool read() = 0;
     virtual bool close() = 0;
     virtual const uint32_t* pixels() { return nullptr; };
     virtual unique_ptr<Scene> scene() { return nullptr; };
+    //the pixels were modified in place.
+    virtual void invalidate() {};
+    //the scene handed out keeps about the given bytes.
+    virtual void measured(size_t bytes) {};
 };
 
 }
@@ -19,11 +19,18 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
-#include "tvgLoaderMgr.h"
+#include <sys/stat.h>
+#include <mutex>
+#include <vector>
+#include "tvgSceneImpl.h"
+#include "tvgPictureImpl.h"
 
 #ifdef THORVG_SVG_LOADER_SUPPORT
     #include "tvgSvgLoader.h"
 #endif
+#ifdef THORVG_TVG_LOADER_SUPPORT
+    #include "tvgTvgLoader.h"
+#endif
 #include "tvgRawLoader.h"
 
 /************************************************************************/
@@ -33,12 +40,94 @@
 static int initCnt = 0;
 
 
+//A parsed file shared by every Picture loading the same path.
+struct CacheEntry
+{
+    string path;
+    time_t mtime;
+    long mtimeNsec;
+    off_t size;
+    size_t bytes;                       //decoded data, the file size until the scene is built
+
+    unique_ptr<Loader> loader;
+    Scene* scene = nullptr;             //parsed scene template, duplicated for each Picture
+    bool read = false;
+    bool readResult = false;
+    bool built = false;
+    bool measured = false;              //accounted by the built scene
+    mutex mtx;
+
+    ~CacheEntry()
+    {
+        if (scene) delete(scene);
+        if (loader) loader->close();
+    }
+};
+
+
+//Hands out duplicates of a cached scene instead of parsing the file again.
+class CacheLoader : public Loader
+{
+public:
+    shared_ptr<CacheEntry> entry;
+
+    CacheLoader(shared_ptr<CacheEntry> entry) : entry(entry)
+    {
+        vx = entry->loader->vx;
+        vy = entry->loader->vy;
+        vw = entry->loader->vw;
+        vh = entry->loader->vh;
+    }
+
+    bool read() override
+    {
+        lock_guard<mutex> lock(entry->mtx);
+        if (!entry->read) {
+            entry->readResult = entry->loader->read();
+            entry->read = true;
+        }
+        return entry->readResult;
+    }
+
+    bool close() override
+    {
+        //The cached loader is shared, it's released along with the entry.
+        return true;
+    }
+
+    const uint32_t* pixels() override
+    {
+        lock_guard<mutex> lock(entry->mtx);
+        if (entry->scene) return nullptr;
+        return entry->loader->pixels();
+    }
+
+    unique_ptr<Scene> scene() override;
+    void measured(size_t bytes) override;
+};
+
+
+//Least recently used entries come first.
+static vector<shared_ptr<CacheEntry>> cacheList;
+static uint32_t cacheMax = 0;          //budget in bytes
+static size_t cacheBytes = 0;
+static uint32_t cacheHits = 0;
+static uint32_t cacheMisses = 0;
+static mutex cacheMtx;
+
+
 static Loader* _find(FileType type)
 {
     switch(type) {
         case FileType::Svg: {
 #ifdef THORVG_SVG_LOADER_SUPPORT
             return new SvgLoader;
+#endif
+            break;
+        }
+        case FileType::Tvg: {
+#ifdef THORVG_TVG_LOADER_SUPPORT
+            return new TvgLoader;
 #endif
             break;
         }
@@ -54,14 +143,145 @@ static Loader* _find(FileType type)
 }
 
 
+static void _evict(uint32_t max)
+{
+    auto cnt = 0;
+    for (auto& entry : cacheList) {
+        if (cacheBytes <= max) break;
+        cacheBytes -= entry->bytes;
+        ++cnt;
+    }
+    cacheList.erase(cacheList.begin(), cacheList.begin() + cnt);
+}
+
+
+static void _clear()
+{
+    cacheList.clear();
+    cacheBytes = 0;
+}
+
+
 static Loader* _find(const string& path)
 {
     auto ext = path.substr(path.find_last_of(".") + 1);
     if (!ext.compare("svg")) return _find(FileType::Svg);
+    if (!ext.compare("tvg")) return _find(FileType::Tvg);
     return nullptr;
 }
 
 
+static long _mtimeNsec(const struct stat& info)
+{
+#if defined(__APPLE__)
+    return info.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+    return 0;
+#else
+    return info.st_mtim.tv_nsec;
+#endif
+}
+
+
+static bool _sameFile(const shared_ptr<CacheEntry>& entry, const string& path, const struct stat& info)
+{
+    return entry->path == path && entry->mtime == info.st_mtime && entry->mtimeNsec == _mtimeNsec(info) && entry->size == info.st_size;
+}
+
+
+static Loader* _findCache(const string& path, bool* enabled)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return nullptr;
+
+    {
+        lock_guard<mutex> lock(cacheMtx);
+
+        *enabled = (cacheMax > 0);
+        if (!*enabled) return nullptr;
+
+        for (auto entry = cacheList.begin(); entry < cacheList.end(); ++entry) {
+            if (!_sameFile(*entry, path, info)) continue;
+            //Move it to the most recently used.
+            auto hit = *entry;
+            cacheList.erase(entry);
+            cacheList.push_back(hit);
+            ++cacheHits;
+            return new CacheLoader(hit);
+        }
+        ++cacheMisses;
+    }
+
+    //Open it outside of the lock, other files can be served meanwhile.
+    auto loader = _find(path);
+    if (!loader) return nullptr;
+    if (!loader->open(path)) {
+        delete(loader);
+        return nullptr;
+    }
+
+    auto entry = make_shared<CacheEntry>();
+    entry->path = path;
+    entry->mtime = info.st_mtime;
+    entry->mtimeNsec = _mtimeNsec(info);
+    entry->size = info.st_size;
+    entry->bytes = info.st_size;
+    entry->loader = unique_ptr<Loader>(loader);
+
+    lock_guard<mutex> lock(cacheMtx);
+
+    //Drop the stale one or the one cached by another thread in the meantime.
+    for (auto old = cacheList.begin(); old < cacheList.end(); ++old) {
+        if ((*old)->path == path) {
+            cacheBytes -= (*old)->bytes;
+            cacheList.erase(old);
+            break;
+        }
+    }
+    cacheList.push_back(entry);
+    cacheBytes += entry->bytes;
+    _evict(cacheMax);
+
+    return new CacheLoader(entry);
+}
+
+
+unique_ptr<Scene> CacheLoader::scene()
+{
+    lock_guard<mutex> lock(entry->mtx);
+    if (!entry->built) {
+        auto scene = entry->loader->scene();
+        if (scene) {
+            entry->scene = scene.release();
+            //The parsing data is useless from now on.
+            entry->loader->close();
+        }
+        entry->built = true;
+    }
+    if (!entry->scene) return nullptr;
+
+    return unique_ptr<Scene>(static_cast<Scene*>(entry->scene->duplicate()));
+}
+
+
+void CacheLoader::measured(size_t bytes)
+{
+    lock_guard<mutex> lock(cacheMtx);
+
+    //Account the built scene instead of the file, if it's still cached.
+    if (entry->measured) return;
+    entry->measured = true;
+
+    for (auto& cached : cacheList) {
+        if (cached != entry) continue;
+        cacheBytes = cacheBytes - entry->bytes + bytes;
+        entry->bytes = bytes;
+        _evict(cacheMax);
+        break;
+    }
+}
+
+
 /************************************************************************/
 /* External Class Implementation                                        */
 /************************************************************************/
@@ -83,7 +303,33 @@ bool LoaderMgr::term()
     --initCnt;
     if (initCnt > 0) return true;
 
-    //TODO:
+    lock_guard<mutex> lock(cacheMtx);
+    _clear();
+
+    return true;
+}
+
+
+bool LoaderMgr::cache(uint32_t size)
+{
+    lock_guard<mutex> lock(cacheMtx);
+
+    cacheMax = size;
+    cacheHits = cacheMisses = 0;
+    if (size == 0) _clear();
+    else _evict(size);
+
+    return true;
+}
+
+
+bool LoaderMgr::cacheStats(uint32_t* hits, uint32_t* misses, uint32_t* cnt)
+{
+    lock_guard<mutex> lock(cacheMtx);
+
+    if (hits) *hits = cacheHits;
+    if (misses) *misses = cacheMisses;
+    if (cnt) *cnt = cacheList.size();
 
     return true;
 }
@@ -91,9 +337,14 @@ bool LoaderMgr::term()
 
 unique_ptr<Loader> LoaderMgr::loader(const string& path)
 {
-    auto loader = _find(path);
+    auto cached = false;
+    auto loader = _findCache(path, &cached);
+    if (loader || cached) return unique_ptr<Loader>(loader);
+
+    loader = _find(path);
 
     if (loader && loader->open(path)) return unique_ptr<Loader>(loader);
+    if (loader) delete(loader);
 
     return nullptr;
 }
@@ -103,17 +354,21 @@ unique_ptr<Loader> LoaderMgr::loader(const char* data, uint32_t size)
 {
     for (int i = 0; i < static_cast<int>(FileType::Unknown); i++) {
         auto loader = _find(static_cast<FileType>(i));
-        if (loader && loader->open(data, size)) return unique_ptr<Loader>(loader);
+        if (!loader) continue;
+        if (loader->open(data, size)) return unique_ptr<Loader>(loader);
+        delete(loader);
     }
     return nullptr;
 }
 
 
-unique_ptr<Loader> LoaderMgr::loader(uint32_t *data, uint32_t w, uint32_t h, bool copy)
+unique_ptr<Loader> LoaderMgr::loader(uint32_t *data, uint32_t w, uint32_t h, uint32_t stride, bool copy)
 {
     for (int i = 0; i < static_cast<int>(FileType::Unknown); i++) {
         auto loader = _find(static_cast<FileType>(i));
-        if (loader && loader->open(data, w, h, copy)) return unique_ptr<Loader>(loader);
+        if (!loader) continue;
+        if (loader->open(data, w, h, stride, copy)) return unique_ptr<Loader>(loader);
+        delete(loader);
     }
     return nullptr;
 }
@@ -24,15 +24,17 @@
 
 #include "tvgLoader.h"
 
-enum class FileType { Svg = 0, Raw, Unknown };
+enum class FileType { Svg = 0, Tvg, Raw, Unknown };
 
 struct LoaderMgr
 {
     static bool init();
     static bool term();
+    static bool cache(uint32_t size);
+    static bool cacheStats(uint32_t* hits, uint32_t* misses, uint32_t* cnt);
     static unique_ptr<Loader> loader(const string& path);
     static unique_ptr<Loader> loader(const char* data, uint32_t size);
-    static unique_ptr<Loader> loader(uint32_t* data, uint32_t w, uint32_t h, bool copy);
+    static unique_ptr<Loader> loader(uint32_t* data, uint32_t w, uint32_t h, uint32_t stride, bool copy);
 };
 
 #endif //_TVG_LOADER_MGR_H_
@@ -103,3 +103,22 @@ uint8_t Paint::opacity() const noexcept
 {
     return pImpl->opacity;
 }
+
+
+Result Paint::cache(bool hint) noexcept
+{
+    if (hint) {
+        if (!pImpl->cache) pImpl->cache = new RenderCache;
+        if (!pImpl->cache) return Result::FailedAllocation;
+        pImpl->cache->hint = true;
+    //Dropped on the next update
+    } else if (pImpl->cache) pImpl->cache->hint = false;
+
+    return Result::Success;
+}
+
+
+bool Paint::cache() const noexcept
+{
+    return pImpl->cache && pImpl->cache->hint;
+}
@@ -22,12 +22,67 @@
 #ifndef _TVG_PAINT_H_
 #define _TVG_PAINT_H_
 
+#include <algorithm>
 #include <float.h>
 #include <math.h>
 #include "tvgRender.h"
 
 namespace tvg
 {
+    //Shrinks the region to the overlap of both, returns false if they don't overlap.
+    static inline bool _intersect(RenderRegion& region, const RenderRegion& rhs)
+    {
+        auto x1 = min(region.x + region.w, rhs.x + rhs.w);
+        auto y1 = min(region.y + region.h, rhs.y + rhs.h);
+        region.x = max(region.x, rhs.x);
+        region.y = max(region.y, rhs.y);
+        if (x1 <= region.x || y1 <= region.y) return false;
+        region.w = x1 - region.x;
+        region.h = y1 - region.y;
+        return true;
+    }
+
+    //Grows the region to cover both.
+    static inline void _merge(RenderRegion& region, const RenderRegion& rhs)
+    {
+        auto x1 = max(region.x + region.w, rhs.x + rhs.w);
+        auto y1 = max(region.y + region.h, rhs.y + rhs.h);
+        region.x = min(region.x, rhs.x);
+        region.y = min(region.y, rhs.y);
+        region.w = x1 - region.x;
+        region.h = y1 - region.y;
+    }
+
+    //Retained drawing of a paint, see Paint::cache()
+    struct RenderCache
+    {
+        void* data = nullptr;           //offscreen kept by the engine
+        RenderTransform transform;      //transform the children are prepared with
+        bool transformed = false;       //the children have the transform
+        int32_t x = 0, y = 0;           //move of the drawing from the children
+        uint32_t opacity = 255;         //opacity of the drawing
+        bool hint = true;               //the user wants the cache
+        bool dirty = true;              //the drawing needs to be made again
+    };
+
+    //Whole pixels the transform moves the cached children, false if it does more than translating them.
+    static inline bool _translated(const RenderTransform* transform, const RenderCache& cache, int32_t& x, int32_t& y)
+    {
+        static const Matrix identity = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+        auto& m = transform ? transform->m : identity;
+        auto& c = cache.transformed ? cache.transform.m : identity;
+
+        if (fabsf(m.e11 - c.e11) > FLT_EPSILON || fabsf(m.e12 - c.e12) > FLT_EPSILON ||
+            fabsf(m.e21 - c.e21) > FLT_EPSILON || fabsf(m.e22 - c.e22) > FLT_EPSILON ||
+            fabsf(m.e31 - c.e31) > FLT_EPSILON || fabsf(m.e32 - c.e32) > FLT_EPSILON ||
+            fabsf(m.e33 - c.e33) > FLT_EPSILON) return false;
+
+        x = static_cast<int32_t>(roundf(m.e13 - c.e13)) - cache.x;
+        y = static_cast<int32_t>(roundf(m.e23 - c.e23)) - cache.y;
+
+        return true;
+    }
+
     struct StrategyMethod
     {
         virtual ~StrategyMethod() {}
@@ -36,7 +91,9 @@ namespace tvg
         virtual void* update(RenderMethod& renderer, const RenderTransform* transform, uint32_t opacity, vector<Composite> compList, RenderUpdateFlag pFlag) = 0;   //Return engine data if it has.
         virtual bool render(RenderMethod& renderer) = 0;
         virtual bool bounds(float* x, float* y, float* w, float* h) const = 0;
+        virtual bool bounds(RenderMethod& renderer, RenderRegion& region) = 0;   //Region on the render target
         virtual Paint* duplicate() = 0;
+        virtual size_t bytes() const = 0;       //Estimated memory of the paint data
     };
 
     struct Paint::Impl
@@ -47,10 +104,15 @@ namespace tvg
 
         Paint* compTarget = nullptr;
         CompositeMethod compMethod = CompositeMethod::None;
+        void* cmpData = nullptr;        //offscreen of the paint for masking
+        void* maskData = nullptr;       //offscreen of the mask
+        RenderCache* cache = nullptr;
 
         uint8_t opacity = 255;
 
         ~Impl() {
+            if (cache) delete(cache);
+            if (compTarget) delete(compTarget);
             if (smethod) delete(smethod);
             if (rTransform) delete(rTransform);
         }
@@ -123,8 +185,38 @@ namespace tvg
             return smethod->bounds(x, y, w, h);
         }
 
+        size_t bytes() const
+        {
+            auto ret = sizeof(Impl) + smethod->bytes();
+            if (compTarget) ret += compTarget->pImpl->bytes();
+            return ret;
+        }
+
+        bool bounds(RenderMethod& renderer, RenderRegion& region)
+        {
+            if (!contentBounds(renderer, region)) return false;
+
+            //Nothing is visible out of the mask.
+            if (compTarget && compMethod == CompositeMethod::AlphaMask) {
+                RenderRegion mask;
+                if (!compTarget->pImpl->bounds(renderer, mask)) return false;
+                return _intersect(region, mask);
+            }
+            return true;
+        }
+
         bool dispose(RenderMethod& renderer)
         {
+            if (cmpData) renderer.disposeComposite(cmpData);
+            if (maskData) renderer.disposeComposite(maskData);
+            cmpData = maskData = nullptr;
+
+            if (cache && cache->data) {
+                renderer.disposeComposite(cache->data);
+                cache->data = nullptr;
+                cache->dirty = true;
+            }
+
             if (compTarget) compTarget->pImpl->dispose(renderer);
             return smethod->dispose(renderer);
         }
@@ -144,6 +236,11 @@ namespace tvg
             if (compTarget && compMethod == CompositeMethod::ClipPath) {
                 compdata = compTarget->pImpl->update(renderer, pTransform, opacity, compList, pFlag);
                 if (compdata) compList.push_back({compdata, compMethod});
+            //The mask is drawn by itself, not faded by the parents.
+            } else if (compTarget && (compMethod == CompositeMethod::AlphaMask || compMethod == CompositeMethod::InvAlphaMask)) {
+                compTarget->pImpl->update(renderer, pTransform, 255, compList, pFlag);
+                cmpData = renderer.prepareComposite(cmpData, false);
+                maskData = renderer.prepareComposite(maskData, false);
             }
 
             void *edata = nullptr;
@@ -153,10 +250,10 @@ namespace tvg
 
             if (rTransform && pTransform) {
                 RenderTransform outTransform(pTransform, rTransform);
-                edata = smethod->update(renderer, &outTransform, opacity, compList, newFlag);
+                edata = updateContent(renderer, &outTransform, opacity, compList, newFlag);
             } else {
                 auto outTransform = pTransform ? pTransform : rTransform;
-                edata = smethod->update(renderer, outTransform, opacity, compList, newFlag);
+                edata = updateContent(renderer, outTransform, opacity, compList, newFlag);
             }
 
             if (compdata) compList.pop_back();
@@ -164,17 +261,134 @@ namespace tvg
             return edata;
         }
 
+        void* updateContent(RenderMethod& renderer, const RenderTransform* transform, uint32_t opacity, vector<Composite>& compList, RenderUpdateFlag flag)
+        {
+            if (!cache) return smethod->update(renderer, transform, opacity, compList, flag);
+
+            auto cFlag = static_cast<uint32_t>(flag);
+
+            //Without the hint, the children draw themselves with the opacity again.
+            if (!cache->hint) {
+                if (cache->data) {
+                    renderer.disposeComposite(cache->data);
+                    cFlag |= RenderUpdateFlag::Color | RenderUpdateFlag::Transform;
+                }
+                delete(cache);
+                cache = nullptr;
+                return smethod->update(renderer, transform, opacity, compList, static_cast<RenderUpdateFlag>(cFlag));
+            }
+
+            auto layered = cache->data ? true : false;
+            cache->data = renderer.prepareComposite(cache->data, true);
+            if (!cache->data) return smethod->update(renderer, transform, opacity, compList, flag);
+            cache->opacity = opacity;
+
+            //The drawing is faded at once, the children don't depend on the opacity.
+            if (layered) cFlag &= ~RenderUpdateFlag::Color;
+            else cFlag |= RenderUpdateFlag::Color;
+
+            //Translated only: the children stay as they were drawn and the drawing moves by the whole pixels.
+            int32_t x, y;
+            if (!(cFlag & ~RenderUpdateFlag::Transform) && compList.empty() && !cache->dirty && renderer.cached(cache->data) && _translated(transform, *cache, x, y)) {
+                auto revision = renderer.revision();
+                auto edata = smethod->update(renderer, cache->transformed ? &cache->transform : nullptr, 255, compList, RenderUpdateFlag::None);
+                if (renderer.revision() == revision && ((x == 0 && y == 0) || renderer.moveComposite(cache->data, x, y))) {
+                    cache->x += x;
+                    cache->y += y;
+                    return edata;
+                }
+                //The children are prepared with the transform of the drawing, not this one.
+                cFlag |= RenderUpdateFlag::Transform;
+            }
+
+            if (cache->x || cache->y) cFlag |= RenderUpdateFlag::Transform;
+
+            auto revision = renderer.revision();
+            auto edata = smethod->update(renderer, transform, 255, compList, static_cast<RenderUpdateFlag>(cFlag));
+            if (renderer.revision() != revision || cache->x || cache->y) cache->dirty = true;
+
+            if (transform) cache->transform = *transform;
+            cache->transformed = transform ? true : false;
+            cache->x = cache->y = 0;
+
+            return edata;
+        }
+
+        bool contentBounds(RenderMethod& renderer, RenderRegion& region)
+        {
+            if (!smethod->bounds(renderer, region)) return false;
+            if (!cache || !cache->data || (cache->x == 0 && cache->y == 0)) return true;
+
+            //The drawing is moved from the children.
+            auto x1 = static_cast<int32_t>(region.x) + cache->x;
+            auto y1 = static_cast<int32_t>(region.y) + cache->y;
+            auto x2 = x1 + static_cast<int32_t>(region.w);
+            auto y2 = y1 + static_cast<int32_t>(region.h);
+            if (x2 <= 0 || y2 <= 0) return false;
+            region.x = static_cast<uint32_t>(max(x1, 0));
+            region.y = static_cast<uint32_t>(max(y1, 0));
+            region.w = static_cast<uint32_t>(x2) - region.x;
+            region.h = static_cast<uint32_t>(y2) - region.y;
+            return true;
+        }
+
         bool render(RenderMethod& renderer)
         {
-            return smethod->render(renderer);
+            if (cmpData && maskData && compTarget && (compMethod == CompositeMethod::AlphaMask || compMethod == CompositeMethod::InvAlphaMask)) {
+                return renderMasked(renderer);
+            }
+            return renderContent(renderer);
+        }
+
+        bool renderContent(RenderMethod& renderer)
+        {
+            if (!cache || !cache->data) return smethod->render(renderer);
+            if (cache->opacity == 0) return true;
+
+            //The last drawing is blended again as long as it's valid.
+            if (cache->dirty || !renderer.cached(cache->data)) {
+                RenderRegion region;
+                if (!smethod->bounds(renderer, region)) return true;
+
+                if (!renderer.beginComposite(cache->data, region)) return false;
+                auto ret = smethod->render(renderer);
+                renderer.endComposite(cache->data);
+                if (cache->x || cache->y) renderer.moveComposite(cache->data, cache->x, cache->y);
+                cache->dirty = false;
+                if (!ret) return false;
+            }
+            return renderer.composite(cache->data, nullptr, CompositeMethod::None, cache->opacity);
+        }
+
+        //Draws the paint and the mask offscreen, then blends the paint by the mask.
+        bool renderMasked(RenderMethod& renderer)
+        {
+            //Each offscreen covers all that is drawn on it, the engine limits the blending to the mask.
+            RenderRegion region, mask;
+            if (!contentBounds(renderer, region)) return true;
+            auto masked = compTarget->pImpl->bounds(renderer, mask);
+            if (!masked && compMethod == CompositeMethod::AlphaMask) return true;
+
+            if (!renderer.beginComposite(cmpData, region)) return false;
+            auto ret = renderContent(renderer);
+            renderer.endComposite(cmpData);
+
+            if (masked) {
+                if (!renderer.beginComposite(maskData, mask)) return false;
+                compTarget->pImpl->render(renderer);
+                renderer.endComposite(maskData);
+            }
+
+            return renderer.composite(cmpData, masked ? maskData : nullptr, compMethod, 255) && ret;
         }
 
         Paint* duplicate()
         {
             auto ret = smethod->duplicate();
+            if (!ret) return nullptr;
 
             //duplicate Transform
-            if (ret && rTransform) {
+            if (rTransform) {
                 ret->pImpl->rTransform = new RenderTransform();
                 if (ret->pImpl->rTransform) {
                     *ret->pImpl->rTransform = *rTransform;
@@ -184,6 +398,11 @@ namespace tvg
 
             ret->pImpl->opacity = opacity;
 
+            if (cache && cache->hint) ret->pImpl->cache = new RenderCache;
+
+            //duplicate Composition
+            if (compTarget) ret->pImpl->composite(compTarget->duplicate(), compMethod);
+
             return ret;
         }
 
@@ -210,6 +429,11 @@ namespace tvg
             return inst->bounds(x, y, w, h);
         }
 
+        bool bounds(RenderMethod& renderer, RenderRegion& region) override
+        {
+            return inst->bounds(renderer, region);
+        }
+
         bool dispose(RenderMethod& renderer) override
         {
             return inst->dispose(renderer);
@@ -229,6 +453,11 @@ namespace tvg
         {
             return inst->duplicate();
         }
+
+        size_t bytes() const override
+        {
+            return inst->bytes();
+        }
     };
 }
 
@@ -28,6 +28,7 @@
 
 Picture::Picture() : pImpl(new Impl(this))
 {
+    _id = PAINT_ID_PICTURE;
     Paint::pImpl->method(new PaintMethod<Picture::Impl>(pImpl));
 }
 
@@ -64,7 +65,27 @@ Result Picture::load(uint32_t* data, uint32_t w, uint32_t h, bool copy) noexcept
 {
     if (!data || w <= 0 || h <= 0) return Result::InvalidArguments;
 
-    return pImpl->load(data, w, h, copy);
+    return pImpl->load(data, w, h, w, copy);
+}
+
+
+Result Picture::load(uint32_t* data, uint32_t w, uint32_t h, uint32_t stride, bool copy) noexcept
+{
+    if (!data || w <= 0 || h <= 0 || stride < w) return Result::InvalidArguments;
+
+    return pImpl->load(data, w, h, stride, copy);
+}
+
+
+Result Picture::invalidate() noexcept
+{
+    if (!pImpl->pixels || !pImpl->loader) return Result::InsufficientCondition;
+
+    pImpl->loader->invalidate();
+    pImpl->opaque = pImpl->loader->opaque;
+    Paint::pImpl->flag |= RenderUpdateFlag::Image;
+
+    return Result::Success;
 }
 
 
@@ -73,3 +94,19 @@ Result Picture::viewbox(float* x, float* y, float* w, float* h) const noexcept
     if (pImpl->viewbox(x, y, w, h)) return Result::Success;
     return Result::InsufficientCondition;
 }
+
+
+Result Picture::filter(FilterMethod method) noexcept
+{
+    if (pImpl->filterMethod == method) return Result::Success;
+    pImpl->filterMethod = method;
+    Paint::pImpl->flag |= RenderUpdateFlag::Image;
+
+    return Result::Success;
+}
+
+
+FilterMethod Picture::filter() const noexcept
+{
+    return pImpl->filterMethod;
+}
@@ -35,18 +35,27 @@ struct Picture::Impl
     unique_ptr<Loader> loader = nullptr;
     Paint* paint = nullptr;
     uint32_t *pixels = nullptr;
+    uint32_t stride = 0;
+    bool opaque = false;
     Picture *picture = nullptr;
     void *edata = nullptr;              //engine data
+    FilterMethod filterMethod = FilterMethod::Nearest;
 
     Impl(Picture* p) : picture(p)
     {
     }
 
+    ~Impl()
+    {
+        if (paint) delete(paint);
+    }
+
     bool dispose(RenderMethod& renderer)
     {
         if (paint) {
             paint->pImpl->dispose(renderer);
             delete(paint);
+            paint = nullptr;
 
             return true;
         }
@@ -63,12 +72,15 @@ struct Picture::Impl
                 auto scene = loader->scene();
                 if (scene) {
                     paint = scene.release();
+                    loader->measured(paint->pImpl->bytes());
                     loader->close();
                     if (paint) return RenderUpdateFlag::None;
                 }
             }
             if (!pixels) {
                 pixels = (uint32_t*)loader->pixels();
+                stride = loader->stride;
+                opaque = loader->opaque;
                 if (pixels) return RenderUpdateFlag::Image;
             }
         }
@@ -79,7 +91,7 @@ struct Picture::Impl
     {
         uint32_t flag = reload();
 
-        if (pixels) edata = renderer.prepare(*picture, edata, pixels, transform, opacity, compList, static_cast<RenderUpdateFlag>(pFlag | flag));
+        if (pixels) edata = renderer.prepare(*picture, edata, pixels, stride, opaque, transform, opacity, compList, static_cast<RenderUpdateFlag>(pFlag | flag));
         else if (paint) edata = paint->pImpl->update(renderer, transform, opacity, compList, static_cast<RenderUpdateFlag>(pFlag | flag));
         return edata;
     }
@@ -91,6 +103,13 @@ struct Picture::Impl
         return false;
     }
 
+    bool bounds(RenderMethod& renderer, RenderRegion& region)
+    {
+        if (pixels) return renderer.region(edata, region);
+        else if (paint) return paint->pImpl->bounds(renderer, region);
+        return false;
+    }
+
     bool viewbox(float* x, float* y, float* w, float* h)
     {
         if (!loader) return false;
@@ -125,14 +144,24 @@ struct Picture::Impl
         return Result::Success;
     }
 
-    Result load(uint32_t* data, uint32_t w, uint32_t h, bool copy)
+    Result load(uint32_t* data, uint32_t w, uint32_t h, uint32_t stride, bool copy)
     {
         if (loader) loader->close();
-        loader = LoaderMgr::loader(data, w, h, copy);
+        loader = LoaderMgr::loader(data, w, h, stride, copy);
+        //Pick up the new buffer on the next update.
+        pixels = nullptr;
         if (!loader) return Result::NonSupport;
         return Result::Success;
     }
 
+    size_t bytes() const
+    {
+        auto ret = sizeof(Picture) + sizeof(Impl);
+        if (paint) ret += paint->pImpl->bytes();
+        else if (pixels && loader) ret += static_cast<size_t>(loader->vw * loader->vh) * sizeof(uint32_t);
+        return ret;
+    }
+
     Paint* duplicate()
     {
         reload();
@@ -142,6 +171,7 @@ struct Picture::Impl
         if (!ret) return nullptr;
         auto dup = ret.get()->pImpl;
         dup->paint = paint->duplicate();
+        dup->filterMethod = filterMethod;
 
         return ret.release();
     }
@@ -31,6 +31,9 @@ struct RadialGradient::Impl
     float cx = 0;
     float cy = 0;
     float radius = 0;
+    float fx = 0;
+    float fy = 0;
+    bool focused = false;   //the focal point is off the center
 
     Fill* duplicate()
     {
@@ -40,6 +43,9 @@ struct RadialGradient::Impl
         ret->pImpl->cx = cx;
         ret->pImpl->cy = cy;
         ret->pImpl->radius = radius;
+        ret->pImpl->fx = fx;
+        ret->pImpl->fy = fy;
+        ret->pImpl->focused = focused;
 
         return ret.release();
     }
@@ -85,6 +91,25 @@ Result RadialGradient::radial(float* cx, float* cy, float* radius) const noexcep
 }
 
 
+Result RadialGradient::focal(float fx, float fy) noexcept
+{
+    pImpl->fx = fx;
+    pImpl->fy = fy;
+    pImpl->focused = true;
+
+    return Result::Success;
+}
+
+
+Result RadialGradient::focal(float* fx, float* fy) const noexcept
+{
+    if (fx) *fx = pImpl->focused ? pImpl->fx : pImpl->cx;
+    if (fy) *fy = pImpl->focused ? pImpl->fy : pImpl->cy;
+
+    return Result::Success;
+}
+
+
 unique_ptr<RadialGradient> RadialGradient::gen() noexcept
 {
     return unique_ptr<RadialGradient>(new RadialGradient);
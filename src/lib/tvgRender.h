@@ -42,6 +42,11 @@ struct Composite {
     CompositeMethod method;
 };
 
+struct RenderRegion
+{
+    uint32_t x, y, w, h;
+};
+
 enum RenderUpdateFlag {None = 0, Path = 1, Color = 2, Gradient = 4, Stroke = 8, Transform = 16, Image = 32, All = 64};
 
 struct RenderTransform
@@ -66,14 +71,26 @@ class RenderMethod
 public:
     virtual ~RenderMethod() {}
     virtual void* prepare(TVG_UNUSED const Shape& shape, TVG_UNUSED void* data, TVG_UNUSED const RenderTransform* transform, uint32_t opacity, TVG_UNUSED vector<Composite>& compList, TVG_UNUSED RenderUpdateFlag flags) { return nullptr; }
-    virtual void* prepare(TVG_UNUSED const Picture& picture, TVG_UNUSED void* data, TVG_UNUSED uint32_t *buffer, TVG_UNUSED const RenderTransform* transform, TVG_UNUSED uint32_t opacity, TVG_UNUSED vector<Composite>& compList, TVG_UNUSED RenderUpdateFlag flags) { return nullptr; }
+    virtual void* prepare(TVG_UNUSED const Picture& picture, TVG_UNUSED void* data, TVG_UNUSED uint32_t *buffer, TVG_UNUSED uint32_t stride, TVG_UNUSED bool opaque, TVG_UNUSED const RenderTransform* transform, TVG_UNUSED uint32_t opacity, TVG_UNUSED vector<Composite>& compList, TVG_UNUSED RenderUpdateFlag flags) { return nullptr; }
     virtual bool dispose(TVG_UNUSED void *data) { return true; }
     virtual bool preRender() { return true; }
     virtual bool render(TVG_UNUSED const Shape& shape, TVG_UNUSED void *data) { return true; }
     virtual bool render(TVG_UNUSED const Picture& picture, TVG_UNUSED void *data) { return true; }
     virtual bool postRender() { return true; }
+    virtual bool region(TVG_UNUSED void* data, TVG_UNUSED RenderRegion& region) { return false; }
+    virtual uint32_t revision() { return 0; }
+    virtual void* prepareComposite(TVG_UNUSED void* cmp, TVG_UNUSED bool retain) { return nullptr; }
+    virtual bool beginComposite(TVG_UNUSED void* cmp, TVG_UNUSED const RenderRegion& region) { return false; }
+    virtual bool endComposite(TVG_UNUSED void* cmp) { return true; }
+    virtual bool composite(TVG_UNUSED void* cmp, TVG_UNUSED void* mask, TVG_UNUSED CompositeMethod method, TVG_UNUSED uint32_t opacity) { return false; }
+    virtual bool cached(TVG_UNUSED void* cmp) { return false; }
+    virtual bool moveComposite(TVG_UNUSED void* cmp, TVG_UNUSED int32_t x, TVG_UNUSED int32_t y) { return false; }
+    virtual bool disposeComposite(TVG_UNUSED void* cmp) { return true; }
     virtual bool clear() { return true; }
     virtual bool sync() { return true; }
+    virtual bool async() { return false; }      //drawing can be done on the other threads
+    virtual bool record() { return false; }     //drawing is recorded and rasterized while the next one is prepared
+    virtual bool viewport(TVG_UNUSED int32_t x, TVG_UNUSED int32_t y, TVG_UNUSED uint32_t w, TVG_UNUSED uint32_t h) { return false; }
 };
 
 }
@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef _TVG_SAVER_IMPL_H_
+#define _TVG_SAVER_IMPL_H_
+
+#include <stdio.h>
+#include <cstring>
+#include "tvgPaint.h"
+#include "tvgSceneImpl.h"
+#include "tvgPictureImpl.h"
+#include "tvgBinaryDesc.h"
+
+/************************************************************************/
+/* Internal Class Implementation                                        */
+/************************************************************************/
+
+struct Saver::Impl
+{
+    char* buffer = nullptr;
+    uint32_t size = 0;
+    uint32_t reserved = 0;
+
+    ~Impl()
+    {
+        if (buffer) free(buffer);
+    }
+
+    //Appends len bytes of unit sized values in the file byte order.
+    bool write(const void* data, uint32_t len, uint32_t unit = sizeof(uint8_t))
+    {
+        if (size + len > reserved) {
+            auto newReserved = (size + len) * 2;
+            auto tmp = static_cast<char*>(realloc(buffer, newReserved));
+            if (!tmp) return false;
+            buffer = tmp;
+            reserved = newReserved;
+        }
+        tvgBinCopy(buffer + size, data, len, unit);
+        size += len;
+        return true;
+    }
+
+    //Gives the position of the payload size to be filled by closeBlock()
+    bool openBlock(TvgBinTag tag, uint32_t* pos)
+    {
+        uint32_t len = 0;
+        if (!write(&tag, sizeof(tag))) return false;
+        *pos = size;
+        return write(&len, sizeof(len), sizeof(len));
+    }
+
+    bool closeBlock(uint32_t pos)
+    {
+        if (!buffer || pos + sizeof(uint32_t) > size) return false;
+        uint32_t len = size - pos - sizeof(uint32_t);
+        tvgBinCopy(buffer + pos, &len, sizeof(len), sizeof(len));
+        return true;
+    }
+
+    bool writeBlock(TvgBinTag tag, const void* data, uint32_t len, uint32_t unit = sizeof(uint8_t))
+    {
+        if (!write(&tag, sizeof(tag))) return false;
+        if (!write(&len, sizeof(len), sizeof(len))) return false;
+        return write(data, len, unit);
+    }
+
+    bool serializeFill(const Fill* fill)
+    {
+        uint32_t pos;
+        if (!openBlock(TvgBinTag::Fill, &pos)) return false;
+
+        if (fill->id() == FILL_ID_LINEAR) {
+            float args[4];
+            static_cast<const LinearGradient*>(fill)->linear(args, args + 1, args + 2, args + 3);
+            if (!writeBlock(TvgBinTag::LinearGradient, args, sizeof(args), sizeof(float))) return false;
+        } else if (fill->id() == FILL_ID_RADIAL) {
+            auto radial = static_cast<const RadialGradient*>(fill);
+            float args[3];
+            radial->radial(args, args + 1, args + 2);
+            if (!writeBlock(TvgBinTag::RadialGradient, args, sizeof(args), sizeof(float))) return false;
+            float focal[2];
+            radial->focal(focal, focal + 1);
+            if (focal[0] != args[0] || focal[1] != args[1]) {
+                if (!writeBlock(TvgBinTag::RadialFocal, focal, sizeof(focal), sizeof(float))) return false;
+            }
+        }
+
+        auto spread = static_cast<uint8_t>(fill->spread());
+        if (!writeBlock(TvgBinTag::Spread, &spread, sizeof(spread))) return false;
+
+        const Fill::ColorStop* stops = nullptr;
+        uint32_t cnt = fill->colorStops(&stops);
+        if (cnt > 0 && stops) {
+            uint32_t stopsPos;
+            if (!openBlock(TvgBinTag::ColorStops, &stopsPos)) return false;
+            if (!write(&cnt, sizeof(cnt), sizeof(cnt))) return false;
+            for (uint32_t i = 0; i < cnt; ++i) {
+                if (!write(&stops[i].offset, sizeof(float), sizeof(float))) return false;
+                if (!write(&stops[i].r, 4 * sizeof(uint8_t))) return false;
+            }
+            if (!closeBlock(stopsPos)) return false;
+        }
+
+        return closeBlock(pos);
+    }
+
+    bool serializeStroke(const Shape* shape)
+    {
+        uint32_t pos;
+        if (!openBlock(TvgBinTag::Stroke, &pos)) return false;
+
+        auto width = shape->strokeWidth();
+        if (!writeBlock(TvgBinTag::StrokeWidth, &width, sizeof(width), sizeof(width))) return false;
+
+        uint8_t color[4];
+        shape->strokeColor(color, color + 1, color + 2, color + 3);
+        if (!writeBlock(TvgBinTag::StrokeColor, color, sizeof(color))) return false;
+
+        auto cap = static_cast<uint8_t>(shape->strokeCap());
+        if (!writeBlock(TvgBinTag::StrokeCap, &cap, sizeof(cap))) return false;
+
+        auto join = static_cast<uint8_t>(shape->strokeJoin());
+        if (!writeBlock(TvgBinTag::StrokeJoin, &join, sizeof(join))) return false;
+
+        const float* pattern = nullptr;
+        uint32_t cnt = shape->strokeDash(&pattern);
+        if (cnt > 0 && pattern) {
+            uint32_t dashPos;
+            if (!openBlock(TvgBinTag::StrokeDash, &dashPos)) return false;
+            if (!write(&cnt, sizeof(cnt), sizeof(cnt))) return false;
+            if (!write(pattern, cnt * sizeof(float), sizeof(float))) return false;
+            auto offset = shape->strokeDashOffset();
+            if (offset != 0.0f && !write(&offset, sizeof(offset), sizeof(offset))) return false;
+            if (!closeBlock(dashPos)) return false;
+        }
+
+        return closeBlock(pos);
+    }
+
+    bool serializeShape(const Shape* shape)
+    {
+        const PathCommand* cmds = nullptr;
+        const Point* pts = nullptr;
+        uint32_t cmdCnt = shape->pathCommands(&cmds);
+        uint32_t ptsCnt = shape->pathCoords(&pts);
+
+        if (cmdCnt > 0 && ptsCnt > 0) {
+            uint32_t pos;
+            if (!openBlock(TvgBinTag::Path, &pos)) return false;
+            if (!write(&cmdCnt, sizeof(cmdCnt), sizeof(cmdCnt))) return false;
+            if (!write(&ptsCnt, sizeof(ptsCnt), sizeof(ptsCnt))) return false;
+            for (uint32_t i = 0; i < cmdCnt; ++i) {
+                auto cmd = static_cast<uint8_t>(cmds[i]);
+                if (!write(&cmd, sizeof(cmd))) return false;
+            }
+            if (!write(pts, ptsCnt * sizeof(Point), sizeof(float))) return false;
+            if (!closeBlock(pos)) return false;
+        }
+
+        auto rule = static_cast<uint8_t>(shape->fillRule());
+        if (!writeBlock(TvgBinTag::FillRule, &rule, sizeof(rule))) return false;
+
+        if (auto fill = shape->fill()) {
+            if (!serializeFill(fill)) return false;
+        } else {
+            uint8_t color[4];
+            shape->fillColor(color, color + 1, color + 2, color + 3);
+            if (!writeBlock(TvgBinTag::Color, color, sizeof(color))) return false;
+        }
+
+        if (shape->strokeWidth() > 0) return serializeStroke(shape);
+
+        return true;
+    }
+
+    bool serializePicture(const Picture* picture)
+    {
+        auto impl = picture->pImpl;
+
+        //Make sure the resource is fully loaded
+        impl->reload();
+
+        if (impl->paint) return serialize(impl->paint);
+
+        if (impl->pixels && impl->loader) {
+            uint32_t w = static_cast<uint32_t>(impl->loader->vw);
+            uint32_t h = static_cast<uint32_t>(impl->loader->vh);
+            uint32_t pos;
+            if (!openBlock(TvgBinTag::RawImage, &pos)) return false;
+            if (!write(&w, sizeof(w), sizeof(w))) return false;
+            if (!write(&h, sizeof(h), sizeof(h))) return false;
+            //Rows of a strided buffer are written tightly packed.
+            for (uint32_t y = 0; y < h; ++y) {
+                if (!write(impl->pixels + y * impl->stride, w * sizeof(uint32_t), sizeof(uint32_t))) return false;
+            }
+            return closeBlock(pos);
+        }
+        return true;
+    }
+
+    bool serialize(const Paint* paint)
+    {
+        TvgBinTag tag;
+
+        switch (paint->id()) {
+            case PAINT_ID_SHAPE: tag = TvgBinTag::Shape; break;
+            case PAINT_ID_SCENE: tag = TvgBinTag::Scene; break;
+            case PAINT_ID_PICTURE: tag = TvgBinTag::Picture; break;
+            default: return false;
+        }
+
+        uint32_t pos;
+        if (!openBlock(tag, &pos)) return false;
+
+        //Paint common properties
+        auto pImpl = paint->pImpl;
+
+        if (pImpl->opacity < 255) {
+            if (!writeBlock(TvgBinTag::Opacity, &pImpl->opacity, sizeof(pImpl->opacity))) return false;
+        }
+
+        if (pImpl->rTransform && pImpl->rTransform->update()) {
+            if (!writeBlock(TvgBinTag::Transform, &pImpl->rTransform->m, sizeof(Matrix), sizeof(float))) return false;
+        }
+
+        if (pImpl->compTarget && pImpl->compMethod != CompositeMethod::None) {
+            auto compTag = TvgBinTag::ClipPath;
+            if (pImpl->compMethod == CompositeMethod::AlphaMask) compTag = TvgBinTag::AlphaMask;
+            else if (pImpl->compMethod == CompositeMethod::InvAlphaMask) compTag = TvgBinTag::InvAlphaMask;
+            uint32_t compPos;
+            if (!openBlock(compTag, &compPos)) return false;
+            if (!serialize(pImpl->compTarget)) return false;
+            if (!closeBlock(compPos)) return false;
+        }
+
+        //Class specific properties
+        switch (tag) {
+            case TvgBinTag::Shape: {
+                if (!serializeShape(static_cast<const Shape*>(paint))) return false;
+                break;
+            }
+            case TvgBinTag::Scene: {
+                for (auto child : static_cast<const Scene*>(paint)->pImpl->paints) {
+                    if (!serialize(child)) return false;
+                }
+                break;
+            }
+            case TvgBinTag::Picture: {
+                if (!serializePicture(static_cast<const Picture*>(paint))) return false;
+                break;
+            }
+            default: break;
+        }
+
+        return closeBlock(pos);
+    }
+
+    bool header(const Paint* paint)
+    {
+        float viewbox[4] = {0, 0, 0, 0};
+
+        //Picture keeps the original resource viewbox, others use their bounds.
+        if (paint->id() == PAINT_ID_PICTURE) {
+            auto impl = static_cast<const Picture*>(paint)->pImpl;
+            impl->reload();
+            impl->viewbox(viewbox, viewbox + 1, viewbox + 2, viewbox + 3);
+        } else {
+            paint->bounds(viewbox, viewbox + 1, viewbox + 2, viewbox + 3);
+        }
+
+        uint16_t version = TVG_BIN_VERSION;
+        if (!write(TVG_BIN_MAGIC, TVG_BIN_MAGIC_LEN)) return false;
+        if (!write(&version, sizeof(version), sizeof(version))) return false;
+        return write(viewbox, sizeof(viewbox), sizeof(float));
+    }
+
+    bool save(const Paint* paint, const string& path)
+    {
+        size = 0;
+
+        if (!header(paint)) return false;
+        if (!serialize(paint)) return false;
+
+        auto f = fopen(path.c_str(), "wb");
+        if (!f) return false;
+        auto written = fwrite(buffer, 1, size, f);
+        fclose(f);
+
+        return (written == size);
+    }
+};
+
+#endif //_TVG_SAVER_IMPL_H_
@@ -27,6 +27,7 @@
 
 Scene::Scene() : pImpl(new Impl())
 {
+    _id = PAINT_ID_SCENE;
     Paint::pImpl->method(new PaintMethod<Scene::Impl>(pImpl));
 }
 
@@ -64,6 +65,7 @@ Result Scene::reserve(uint32_t size) noexcept
 Result Scene::clear() noexcept
 {
     pImpl->paints.clear();
+    pImpl->dirty = true;
 
     return Result::Success;
 }
@@ -32,9 +32,21 @@
 struct Scene::Impl
 {
     vector<Paint*> paints;
+    void* layer = nullptr;          //offscreen of the children, kept as a bitmap cache
+    uint32_t opacity = 255;         //opacity of the layer
+    bool dirty = true;              //the layer needs to be drawn again
+
+    ~Impl()
+    {
+        //Paints not disposed by a canvas yet
+        for (auto paint : paints) delete(paint);
+    }
 
     bool dispose(RenderMethod& renderer)
     {
+        if (layer) renderer.disposeComposite(layer);
+        layer = nullptr;
+
         for (auto paint : paints) {
             paint->pImpl->dispose(renderer);
             delete(paint);
@@ -44,19 +56,46 @@ struct Scene::Impl
         return true;
     }
 
+    //Translucent children are blended with each other first, then the result is faded at once.
+    bool needComposition(uint32_t opacity)
+    {
+        return (opacity > 0 && opacity < 255 && paints.size() > 1);
+    }
+
     void* update(RenderMethod &renderer, const RenderTransform* transform, uint32_t opacity, vector<Composite>& compList, RenderUpdateFlag flag)
     {
         /* FXIME: it requires to return list of childr engine data
            This is necessary for scene composition */
         void* edata = nullptr;
+        auto layered = layer ? true : false;
+
+        if (needComposition(opacity)) layer = renderer.prepareComposite(layer, true);
+        else if (layer) {
+            renderer.disposeComposite(layer);
+            layer = nullptr;
+        }
+
+        //The children draw themselves with the scene opacity only without the layer.
+        auto cFlag = static_cast<uint32_t>(flag);
+        if (layered != (layer ? true : false)) cFlag |= RenderUpdateFlag::Color;
+        else if (layer) cFlag &= ~RenderUpdateFlag::Color;
+
+        this->opacity = opacity;
+        if (layer) opacity = 255;
+
+        auto revision = renderer.revision();
 
         for (auto paint : paints) {
-            edata = paint->pImpl->update(renderer, transform, opacity, compList, static_cast<uint32_t>(flag));
+            edata = paint->pImpl->update(renderer, transform, opacity, compList, cFlag);
         }
+
+        //Anything prepared again invalidates the last drawing of the layer.
+        if (renderer.revision() != revision) dirty = true;
+
         return edata;
     }
 
-    bool render(RenderMethod &renderer)
+    bool renderChildren(RenderMethod &renderer)
     {
         for (auto paint : paints) {
             if (!paint->pImpl->render(renderer)) return false;
@@ -64,6 +103,38 @@ struct Scene::Impl
         return true;
     }
 
+    bool render(RenderMethod &renderer)
+    {
+        if (!layer) return renderChildren(renderer);
+
+        //Nothing has changed, blend the last drawing again.
+        if (!dirty && renderer.cached(layer)) return renderer.composite(layer, nullptr, CompositeMethod::None, opacity);
+
+        RenderRegion region;
+        if (!bounds(renderer, region)) return true;
+
+        if (!renderer.beginComposite(layer, region)) return false;
+        auto ret = renderChildren(renderer);
+        renderer.endComposite(layer);
+        dirty = false;
+
+        return renderer.composite(layer, nullptr, CompositeMethod::None, opacity) && ret;
+    }
+
+    bool bounds(RenderMethod& renderer, RenderRegion& region)
+    {
+        auto ret = false;
+
+        for (auto paint : paints) {
+            RenderRegion child;
+            if (!paint->pImpl->bounds(renderer, child)) continue;
+            if (ret) _merge(region, child);
+            else region = child;
+            ret = true;
+        }
+        return ret;
+    }
+
     bool bounds(float* px, float* py, float* pw, float* ph)
     {
         auto x = FLT_MAX;
@@ -94,6 +165,13 @@ struct Scene::Impl
         return true;
     }
 
+    size_t bytes() const
+    {
+        auto ret = sizeof(Scene) + sizeof(Impl) + paints.capacity() * sizeof(Paint*);
+        for (auto paint : paints) ret += paint->pImpl->bytes();
+        return ret;
+    }
+
     Paint* duplicate()
     {
         auto ret = Scene::gen();
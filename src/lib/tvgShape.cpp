@@ -33,6 +33,7 @@ constexpr auto PATH_KAPPA = 0.552284f;
 
 Shape :: Shape() : pImpl(new Impl(this))
 {
+    _id = PAINT_ID_SHAPE;
     Paint::pImpl->method(new PaintMethod<Shape::Impl>(pImpl));
 }
 
@@ -336,13 +337,19 @@ Result Shape::strokeColor(uint8_t* r, uint8_t* g, uint8_t* b, uint8_t* a) const
 
 
 Result Shape::stroke(const float* dashPattern, uint32_t cnt) noexcept
+{
+    return stroke(dashPattern, cnt, 0.0f);
+}
+
+
+Result Shape::stroke(const float* dashPattern, uint32_t cnt, float offset) noexcept
 {
     if (cnt < 2 || !dashPattern) return Result::InvalidArguments;
 
     for (uint32_t i = 0; i < cnt; i++)
         if (dashPattern[i] < FLT_EPSILON) return Result::InvalidArguments;
 
-    if (!pImpl->strokeDash(dashPattern, cnt)) return Result::FailedAllocation;
+    if (!pImpl->strokeDash(dashPattern, cnt, offset)) return Result::FailedAllocation;
 
     return Result::Success;
 }
@@ -358,6 +365,14 @@ uint32_t Shape::strokeDash(const float** dashPattern) const noexcept
 }
 
 
+float Shape::strokeDashOffset() const noexcept
+{
+    if (!pImpl->stroke) return 0;
+
+    return pImpl->stroke->dashOffset;
+}
+
+
 Result Shape::stroke(StrokeCap cap) noexcept
 {
     if (!pImpl->strokeCap(cap)) return Result::FailedAllocation;
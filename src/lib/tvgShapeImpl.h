@@ -35,6 +35,7 @@ struct ShapeStroke
     uint8_t color[4] = {0, 0, 0, 0};
     float* dashPattern = nullptr;
     uint32_t dashCnt = 0;
+    float dashOffset = 0;
     StrokeCap cap = StrokeCap::Square;
     StrokeJoin join = StrokeJoin::Bevel;
 
@@ -44,11 +45,14 @@ struct ShapeStroke
     {
         width = src->width;
         dashCnt = src->dashCnt;
+        dashOffset = src->dashOffset;
         cap = src->cap;
         join = src->join;
         memcpy(color, src->color, sizeof(color));
-        dashPattern = static_cast<float*>(malloc(sizeof(float) * dashCnt));
-        memcpy(dashPattern, src->dashPattern, sizeof(float) * dashCnt);
+        if (dashCnt > 0) {
+            dashPattern = static_cast<float*>(malloc(sizeof(float) * dashCnt));
+            if (dashPattern) memcpy(dashPattern, src->dashPattern, sizeof(float) * dashCnt);
+        }
     }
 
     ~ShapeStroke()
@@ -223,6 +227,11 @@ struct Shape::Impl
         return renderer.render(*shape, edata);
     }
 
+    bool bounds(RenderMethod& renderer, RenderRegion& region)
+    {
+        return renderer.region(edata, region);
+    }
+
     void* update(RenderMethod& renderer, const RenderTransform* transform, uint32_t opacity, vector<Composite>& compList, RenderUpdateFlag pFlag)
     {
         this->edata = renderer.prepare(*shape, this->edata, transform, opacity, compList, static_cast<RenderUpdateFlag>(pFlag | flag));
@@ -285,7 +294,7 @@ struct Shape::Impl
         return true;
     }
 
-    bool strokeDash(const float* pattern, uint32_t cnt)
+    bool strokeDash(const float* pattern, uint32_t cnt, float offset)
     {
        if (!stroke) stroke = new ShapeStroke();
        if (!stroke) return false;
@@ -301,6 +310,7 @@ struct Shape::Impl
             stroke->dashPattern[i] = pattern[i];
 
         stroke->dashCnt = cnt;
+        stroke->dashOffset = offset;
         flag |= RenderUpdateFlag::Stroke;
 
         return true;
@@ -324,6 +334,18 @@ struct Shape::Impl
         flag = RenderUpdateFlag::All;
     }
 
+    size_t bytes() const
+    {
+        auto ret = sizeof(Shape) + sizeof(Impl);
+        ret += path.reservedCmdCnt * sizeof(PathCommand) + path.reservedPtsCnt * sizeof(Point);
+        if (stroke) ret += sizeof(ShapeStroke) + stroke->dashCnt * sizeof(float);
+        if (fill) {
+            const Fill::ColorStop* stops;
+            ret += sizeof(Fill) + fill->colorStops(&stops) * sizeof(Fill::ColorStop);
+        }
+        return ret;
+    }
+
     Paint* duplicate()
     {
         auto ret = Shape::gen();
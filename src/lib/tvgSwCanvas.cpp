@@ -65,6 +65,8 @@ Result SwCanvas::target(uint32_t* buffer, uint32_t stride, uint32_t w, uint32_t
     auto renderer = static_cast<SwRenderer*>(Canvas::pImpl->renderer);
     if (!renderer) return Result::MemoryCorruption;
 
+    Canvas::pImpl->wait();
+
     if (!renderer->target(buffer, stride, w, h, cs)) return Result::InvalidArguments;
 
     return Result::Success;
@@ -73,6 +75,50 @@ Result SwCanvas::target(uint32_t* buffer, uint32_t stride, uint32_t w, uint32_t
 }
 
 
+Result SwCanvas::target(uint32_t** buffers, uint32_t cnt, uint32_t stride, uint32_t w, uint32_t h, Colorspace cs) noexcept
+{
+#ifdef THORVG_SW_RASTER_SUPPORT
+    //We know renderer type, avoid dynamic_cast for performance.
+    auto renderer = static_cast<SwRenderer*>(Canvas::pImpl->renderer);
+    if (!renderer) return Result::MemoryCorruption;
+
+    Canvas::pImpl->wait();
+
+    if (!renderer->target(buffers, cnt, stride, w, h, cs)) return Result::InvalidArguments;
+
+    return Result::Success;
+#endif
+    return Result::NonSupport;
+}
+
+
+Result SwCanvas::coverage(Coverage method) noexcept
+{
+#ifdef THORVG_SW_RASTER_SUPPORT
+    //We know renderer type, avoid dynamic_cast for performance.
+    auto renderer = static_cast<SwRenderer*>(Canvas::pImpl->renderer);
+    if (!renderer) return Result::MemoryCorruption;
+
+    Canvas::pImpl->wait();
+
+    if (!renderer->coverage(method)) return Result::InvalidArguments;
+
+    return Result::Success;
+#endif
+    return Result::NonSupport;
+}
+
+
+Result SwCanvas::cacheBudget(uint32_t bytes) noexcept
+{
+#ifdef THORVG_SW_RASTER_SUPPORT
+    SwRenderer::cacheBudget(bytes);
+    return Result::Success;
+#endif
+    return Result::NonSupport;
+}
+
+
 unique_ptr<SwCanvas> SwCanvas::gen() noexcept
 {
 #ifdef THORVG_SW_RASTER_SUPPORT
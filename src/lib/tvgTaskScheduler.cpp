@@ -32,6 +32,8 @@
 
 namespace tvg {
 
+static thread_local int worker = -1;     //index of the worker thread, -1 on the others
+
 struct TaskQueue {
     deque<Task*>             taskDeque;
     mutex                    mtx;
@@ -70,6 +72,17 @@ struct TaskQueue {
         ready.notify_all();
     }
 
+    bool take(Task* task)
+    {
+        unique_lock<mutex> lock{mtx};
+        for (auto itr = taskDeque.begin(); itr != taskDeque.end(); ++itr) {
+            if (*itr != task) continue;
+            taskDeque.erase(itr);
+            return true;
+        }
+        return false;
+    }
+
     bool pop(Task** task)
     {
         unique_lock<mutex> lock{mtx};
@@ -124,6 +137,8 @@ public:
     {
         Task* task;
 
+        worker = i;
+
         //Thread Loop
         while (true) {
             auto success = false;
@@ -139,6 +154,20 @@ public:
         }
     }
 
+    //Runs the task on the current worker if it's still queued. Any other one could be waiting for the caller.
+    bool help(Task* task)
+    {
+        if (worker < 0) return false;
+
+        for (unsigned n = 0; n < threadCnt; ++n) {
+            if (taskQueues[(worker + n) % threadCnt].take(task)) {
+                (*task)(worker);
+                return true;
+            }
+        }
+        return false;
+    }
+
     void request(Task* task)
     {
         //Async
@@ -185,6 +214,13 @@ void TaskScheduler::request(Task* task)
 }
 
 
+bool TaskScheduler::help(Task* task)
+{
+    if (inst) return inst->help(task);
+    return false;
+}
+
+
 unsigned TaskScheduler::threads()
 {
     if (inst) return inst->threadCnt;
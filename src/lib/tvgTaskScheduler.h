@@ -37,6 +37,7 @@ struct TaskScheduler
     static void init(unsigned threads);
     static void term();
     static void request(Task* task);
+    static bool help(Task* task);
 };
 
 struct Task
@@ -54,6 +55,9 @@ public:
     {
         if (!pending) return;
 
+        //A worker waiting for the task runs it by itself unless another one took it.
+        if (!finished()) TaskScheduler::help(this);
+
         unique_lock<mutex> lock(mtx);
         while (!ready) cv.wait(lock);
         pending = false;
@@ -63,6 +67,12 @@ protected:
     virtual void run(unsigned tid) = 0;
 
 private:
+    bool finished()
+    {
+        lock_guard<mutex> lock(mtx);
+        return ready;
+    }
+
     void operator()(unsigned tid)
     {
         run(tid);
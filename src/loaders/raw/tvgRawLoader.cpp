@@ -28,6 +28,17 @@
 /* Internal Class Implementation                                        */
 /************************************************************************/
 
+static bool _opaque(const uint32_t* data, uint32_t w, uint32_t h, uint32_t stride)
+{
+    for (uint32_t y = 0; y < h; ++y) {
+        auto row = data + y * stride;
+        uint32_t alpha = 0xff000000;
+        for (uint32_t x = 0; x < w; ++x) alpha &= row[x];
+        if (alpha != 0xff000000) return false;
+    }
+    return true;
+}
+
 /************************************************************************/
 /* External Class Implementation                                        */
 /************************************************************************/
@@ -47,20 +58,33 @@ RawLoader::~RawLoader()
 }
 
 
-bool RawLoader::open(const uint32_t* data, uint32_t w, uint32_t h, bool copy)
+bool RawLoader::open(const uint32_t* data, uint32_t w, uint32_t h, uint32_t stride, bool copy)
 {
-    if (!data || w == 0 || h == 0) return false;
+    if (!data || w == 0 || h == 0 || stride < w) return false;
 
     vw = w;
     vh = h;
 
     this->copy = copy;
     if (copy) {
-        content = (uint32_t*)malloc(sizeof(uint32_t) * vw * vh);
-        if (!content) return false;
-        memcpy((void*)content, data, sizeof(uint32_t) * vw * vh);
+        //The copy is tightly packed.
+        auto buffer = (uint32_t*)malloc(sizeof(uint32_t) * w * h);
+        if (!buffer) return false;
+        if (stride == w) {
+            memcpy(buffer, data, sizeof(uint32_t) * w * h);
+        } else {
+            for (uint32_t y = 0; y < h; ++y) {
+                memcpy(buffer + y * w, data + y * stride, sizeof(uint32_t) * w);
+            }
+        }
+        content = buffer;
+        this->stride = w;
+    } else {
+        content = data;
+        this->stride = stride;
     }
-    else content = data;
+
+    opaque = _opaque(content, w, h, this->stride);
 
     return true;
 }
@@ -78,6 +102,12 @@ bool RawLoader::close()
 }
 
 
+void RawLoader::invalidate()
+{
+    opaque = _opaque(content, static_cast<uint32_t>(vw), static_cast<uint32_t>(vh), stride);
+}
+
+
 const uint32_t* RawLoader::pixels()
 {
     return this->content;
@@ -32,9 +32,10 @@ public:
     ~RawLoader();
 
     using Loader::open;
-    bool open(const uint32_t* data, uint32_t w, uint32_t h, bool copy) override;
+    bool open(const uint32_t* data, uint32_t w, uint32_t h, uint32_t stride, bool copy) override;
     bool read() override;
     bool close() override;
+    void invalidate() override;
 
     const uint32_t* pixels() override;
 };
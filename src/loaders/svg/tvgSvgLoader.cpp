@@ -44,11 +44,9 @@ static char* _skipSpace(const char* str, const char* end)
 }
 
 
-static string* _copyId(const char* str)
+static char* _copyId(SvgLoaderData* loader, const char* str)
 {
-    if (str == nullptr) return nullptr;
-
-    return new string(str);
+    return loader->arena.strdup(str);
 }
 
 
@@ -233,21 +231,21 @@ _PARSE_TAG(SvgFillRule, fillRule, FillRule, fillRuleTags, SvgFillRule::Winding)
  * https://www.w3.org/TR/SVG/painting.html
  */
 static inline void
-_parseDashArray(const char *str, SvgDash* dash)
+_parseDashArray(SvgArena* arena, const char *str, SvgDash* dash)
 {
     char *end = nullptr;
 
     while (*str) {
         // skip white space, comma
         str = _skipComma(str);
-        (*dash).array.push(strtof(str, &end));
+        (*dash).array.push(arena, strtof(str, &end));
         str = _skipComma(end);
     }
     //If dash array size is 1, it means that dash and gap size are the same.
-    if ((*dash).array.cnt == 1) (*dash).array.push((*dash).array.list[0]);
+    if ((*dash).array.cnt == 1) (*dash).array.push(arena, (*dash).array.list[0]);
 }
 
-static string* _idFromUrl(const char* url)
+static char* _idFromUrl(SvgArena* arena, const char* url)
 {
     char tmp[50];
     int i = 0;
@@ -266,7 +264,7 @@ static string* _idFromUrl(const char* url)
     }
     tmp[i] = '\0';
 
-    return new string(tmp);
+    return arena->strdup(tmp, i);
 }
 
 
@@ -443,7 +441,7 @@ static constexpr struct
 };
 
 
-static void _toColor(const char* str, uint8_t* r, uint8_t* g, uint8_t* b, string** ref)
+static void _toColor(SvgArena* arena, const char* str, uint8_t* r, uint8_t* g, uint8_t* b, char** ref)
 {
     unsigned int i, len = strlen(str);
     char *red, *green, *blue;
@@ -490,7 +488,7 @@ static void _toColor(const char* str, uint8_t* r, uint8_t* g, uint8_t* b, string
             }
         }
     } else if (len >= 3 && !strncmp(str, "url", 3)) {
-        *ref = _idFromUrl((const char*)(str + 3));
+        if (ref) *ref = _idFromUrl(arena, (const char*)(str + 3));
     } else {
         //Handle named color
         for (i = 0; i < (sizeof(colors) / sizeof(colors[0])); i++) {
@@ -588,14 +586,14 @@ static void _matrixCompose(const Matrix* m1,
 /* parse transform attribute
  * https://www.w3.org/TR/SVG/coords.html#TransformAttribute
  */
-static Matrix* _parseTransformationMatrix(const char* value)
+static Matrix* _parseTransformationMatrix(SvgArena* arena, const char* value)
 {
     unsigned int i;
     float points[8];
     int ptCount = 0;
     float sx, sy;
     MatrixState state = MatrixState::Unknown;
-    Matrix* matrix = (Matrix*)calloc(1, sizeof(Matrix));
+    Matrix* matrix = arena->alloc<Matrix>();
     char* str = (char*)value;
     char* end = str + strlen(str);
 
@@ -753,7 +751,7 @@ static bool _attrParseSvgNode(void* data, const char* key, const char* value)
 
 
 //https://www.w3.org/TR/SVGTiny12/painting.html#SpecifyingPaint
-static void _handlePaintAttr(SvgPaint* paint, const char* value)
+static void _handlePaintAttr(SvgLoaderData* loader, SvgPaint* paint, const char* value)
 {
     if (!strcmp(value, "none")) {
         //No paint property
@@ -765,30 +763,30 @@ static void _handlePaintAttr(SvgPaint* paint, const char* value)
         paint->curColor = true;
         return;
     }
-    _toColor(value, &paint->r, &paint->g, &paint->b, &paint->url);
+    _toColor(&loader->arena, value, &paint->r, &paint->g, &paint->b, &paint->url);
 }
 
 
-static void _handleColorAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* node, const char* value)
+static void _handleColorAttr(SvgLoaderData* loader, SvgNode* node, const char* value)
 {
     SvgStyleProperty* style = node->style;
-    _toColor(value, &style->r, &style->g, &style->b, nullptr);
+    _toColor(&loader->arena, value, &style->r, &style->g, &style->b, nullptr);
 }
 
 
-static void _handleFillAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* node, const char* value)
+static void _handleFillAttr(SvgLoaderData* loader, SvgNode* node, const char* value)
 {
     SvgStyleProperty* style = node->style;
     style->fill.flags = (SvgFillFlags)((int)style->fill.flags | (int)SvgFillFlags::Paint);
-    _handlePaintAttr(&style->fill.paint, value);
+    _handlePaintAttr(loader, &style->fill.paint, value);
 }
 
 
-static void _handleStrokeAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* node, const char* value)
+static void _handleStrokeAttr(SvgLoaderData* loader, SvgNode* node, const char* value)
 {
     SvgStyleProperty* style = node->style;
     style->stroke.flags = (SvgStrokeFlags)((int)style->stroke.flags | (int)SvgStrokeFlags::Paint);
-    _handlePaintAttr(&style->stroke.paint, value);
+    _handlePaintAttr(loader, &style->stroke.paint, value);
 }
 
 
@@ -798,10 +796,16 @@ static void _handleStrokeOpacityAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode*
     node->style->stroke.opacity = _toOpacity(value);
 }
 
-static void _handleStrokeDashArrayAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* node, const char* value)
+static void _handleStrokeDashArrayAttr(SvgLoaderData* loader, SvgNode* node, const char* value)
 {
     node->style->stroke.flags = (SvgStrokeFlags)((int)node->style->stroke.flags | (int)SvgStrokeFlags::Dash);
-    _parseDashArray(value, &node->style->stroke.dash);
+    _parseDashArray(&loader->arena, value, &node->style->stroke.dash);
+}
+
+static void _handleStrokeDashOffsetAttr(SvgLoaderData* loader, SvgNode* node, const char* value)
+{
+    node->style->stroke.flags = (SvgStrokeFlags)((int)node->style->stroke.flags | (int)SvgStrokeFlags::DashOffset);
+    node->style->stroke.dash.offset = _toFloat(loader->svgParse, value, SvgParserLengthType::Horizontal);
 }
 
 static void _handleStrokeWidthAttr(SvgLoaderData* loader, SvgNode* node, const char* value)
@@ -845,18 +849,18 @@ static void _handleFillOpacityAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* no
 }
 
 
-static void _handleTransformAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* node, const char* value)
+static void _handleTransformAttr(SvgLoaderData* loader, SvgNode* node, const char* value)
 {
-    node->transform = _parseTransformationMatrix(value);
+    node->transform = _parseTransformationMatrix(&loader->arena, value);
 }
 
-static void _handleClipPathAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* node, const char* value)
+static void _handleClipPathAttr(SvgLoaderData* loader, SvgNode* node, const char* value)
 {
     SvgStyleProperty* style = node->style;
     style->comp.flags = (SvgCompositeFlags)((int)style->comp.flags | (int)SvgCompositeFlags::ClipPath);
 
     int len = strlen(value);
-    if (len >= 3 && !strncmp(value, "url", 3)) style->comp.url = _idFromUrl((const char*)(value + 3));
+    if (len >= 3 && !strncmp(value, "url", 3)) style->comp.url = _idFromUrl(&loader->arena, (const char*)(value + 3));
 }
 
 static void _handleDisplayAttr(TVG_UNUSED SvgLoaderData* loader, SvgNode* node, const char* value)
@@ -896,6 +900,7 @@ static constexpr struct
     STYLE_DEF(stroke-linecap, StrokeLineCap),
     STYLE_DEF(stroke-opacity, StrokeOpacity),
     STYLE_DEF(stroke-dasharray, StrokeDashArray),
+    STYLE_DEF(stroke-dashoffset, StrokeDashOffset),
     STYLE_DEF(transform, Transform),
     STYLE_DEF(clip-path, ClipPath),
     STYLE_DEF(display, Display)
@@ -937,9 +942,9 @@ static bool _attrParseGNode(void* data, const char* key, const char* value)
     if (!strcmp(key, "style")) {
         return simpleXmlParseW3CAttribute(value, _parseStyleAttr, loader);
     } else if (!strcmp(key, "transform")) {
-        node->transform = _parseTransformationMatrix(value);
+        node->transform = _parseTransformationMatrix(&loader->arena, value);
     } else if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else if (!strcmp(key, "clip-path")) {
         _handleClipPathAttr(loader, node, value);
     } else {
@@ -960,21 +965,21 @@ static bool _attrParseClipPathNode(void* data, const char* key, const char* valu
     if (!strcmp(key, "style")) {
         return simpleXmlParseW3CAttribute(value, _parseStyleAttr, loader);
     } else if (!strcmp(key, "transform")) {
-        node->transform = _parseTransformationMatrix(value);
+        node->transform = _parseTransformationMatrix(&loader->arena, value);
     } else if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else {
         return _parseStyleAttr(loader, key, value);
     }
     return true;
 }
 
-static SvgNode* _createNode(SvgNode* parent, SvgNodeType type)
+static SvgNode* _createNode(SvgLoaderData* loader, SvgNode* parent, SvgNodeType type)
 {
-    SvgNode* node = (SvgNode*)calloc(1, sizeof(SvgNode));
+    SvgNode* node = loader->arena.alloc<SvgNode>();
 
     //Default fill property
-    node->style = (SvgStyleProperty*)calloc(1, sizeof(SvgStyleProperty));
+    node->style = loader->arena.alloc<SvgStyleProperty>();
 
     //Update the default value of stroke and fill
     //https://www.w3.org/TR/SVGTiny12/painting.html#SpecifyingPaint
@@ -1004,14 +1009,18 @@ static SvgNode* _createNode(SvgNode* parent, SvgNodeType type)
     node->parent = parent;
     node->type = type;
 
-    if (parent) parent->child.push(node);
+    if (parent) {
+        if (parent->lastChild) parent->lastChild->next = node;
+        else parent->child = node;
+        parent->lastChild = node;
+    }
     return node;
 }
 
 
-static SvgNode* _createDefsNode(TVG_UNUSED SvgLoaderData* loader, TVG_UNUSED SvgNode* parent, const char* buf, unsigned bufLength)
+static SvgNode* _createDefsNode(SvgLoaderData* loader, TVG_UNUSED SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    SvgNode* node = _createNode(nullptr, SvgNodeType::Defs);
+    SvgNode* node = _createNode(loader, nullptr, SvgNodeType::Defs);
     simpleXmlParseAttributes(buf, bufLength, nullptr, node);
     return node;
 }
@@ -1019,7 +1028,7 @@ static SvgNode* _createDefsNode(TVG_UNUSED SvgLoaderData* loader, TVG_UNUSED Svg
 
 static SvgNode* _createGNode(TVG_UNUSED SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::G);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::G);
 
     simpleXmlParseAttributes(buf, bufLength, _attrParseGNode, loader);
     return loader->svgParse->node;
@@ -1028,7 +1037,7 @@ static SvgNode* _createGNode(TVG_UNUSED SvgLoaderData* loader, SvgNode* parent,
 
 static SvgNode* _createSvgNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Doc);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Doc);
     SvgDocNode* doc = &(loader->svgParse->node->node.doc);
 
     doc->preserveAspect = true;
@@ -1040,7 +1049,7 @@ static SvgNode* _createSvgNode(SvgLoaderData* loader, SvgNode* parent, const cha
 
 static SvgNode* _createMaskNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Unknown);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Unknown);
 
     loader->svgParse->node->display = false;
 
@@ -1050,7 +1059,7 @@ static SvgNode* _createMaskNode(SvgLoaderData* loader, SvgNode* parent, const ch
 
 static SvgNode* _createClipPathNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::ClipPath);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::ClipPath);
 
     loader->svgParse->node->display = false;
 
@@ -1067,13 +1076,13 @@ static bool _attrParsePathNode(void* data, const char* key, const char* value)
 
     if (!strcmp(key, "d")) {
         //Temporary: need to copy
-        path->path = _copyId(value);
+        path->path = _copyId(loader, value);
     } else if (!strcmp(key, "style")) {
         return simpleXmlParseW3CAttribute(value, _parseStyleAttr, loader);
     } else if (!strcmp(key, "clip-path")) {
         _handleClipPathAttr(loader, node, value);
     } else if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else {
         return _parseStyleAttr(loader, key, value);
     }
@@ -1083,7 +1092,7 @@ static bool _attrParsePathNode(void* data, const char* key, const char* value)
 
 static SvgNode* _createPathNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Path);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Path);
 
     simpleXmlParseAttributes(buf, bufLength, _attrParsePathNode, loader);
 
@@ -1129,7 +1138,7 @@ static bool _attrParseCircleNode(void* data, const char* key, const char* value)
     } else if (!strcmp(key, "clip-path")) {
         _handleClipPathAttr(loader, node, value);
     } else if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else {
         return _parseStyleAttr(loader, key, value);
     }
@@ -1139,7 +1148,7 @@ static bool _attrParseCircleNode(void* data, const char* key, const char* value)
 
 static SvgNode* _createCircleNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Circle);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Circle);
 
     simpleXmlParseAttributes(buf, bufLength, _attrParseCircleNode, loader);
     return loader->svgParse->node;
@@ -1181,7 +1190,7 @@ static bool _attrParseEllipseNode(void* data, const char* key, const char* value
     }
 
     if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else if (!strcmp(key, "style")) {
         return simpleXmlParseW3CAttribute(value, _parseStyleAttr, loader);
     } else if (!strcmp(key, "clip-path")) {
@@ -1195,47 +1204,23 @@ static bool _attrParseEllipseNode(void* data, const char* key, const char* value
 
 static SvgNode* _createEllipseNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Ellipse);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Ellipse);
 
     simpleXmlParseAttributes(buf, bufLength, _attrParseEllipseNode, loader);
     return loader->svgParse->node;
 }
 
 
-static bool _attrParsePolygonPoints(const char* str, float** points, int* ptCount)
+static bool _attrParsePolygonPoints(SvgArena* arena, const char* str, float** points, int* ptCount)
 {
-    float tmp[50];
-    int tmpCount = 0;
-    int count = 0;
+    SvgArray<float> pointArray = {nullptr, 0, 0};
     float num;
-    float *pointArray = nullptr, *tmpArray;
-
-    while (_parseNumber(&str, &num)) {
-        tmp[tmpCount++] = num;
-        if (tmpCount == 50) {
-            tmpArray = (float*)realloc(pointArray, (count + tmpCount) * sizeof(float));
-            if (!tmpArray) goto error_alloc;
-            pointArray = tmpArray;
-            memcpy(&pointArray[count], tmp, tmpCount * sizeof(float));
-            count += tmpCount;
-            tmpCount = 0;
-        }
-    }
 
-    if (tmpCount > 0) {
-        tmpArray = (float*)realloc(pointArray, (count + tmpCount) * sizeof(float));
-        if (!tmpArray) goto error_alloc;
-        pointArray = tmpArray;
-        memcpy(&pointArray[count], tmp, tmpCount * sizeof(float));
-        count += tmpCount;
-    }
-    *ptCount = count;
-    *points = pointArray;
-    return true;
+    while (_parseNumber(&str, &num)) pointArray.push(arena, num);
 
-error_alloc:
-    //LOG: allocation for point array failed. out of memory
-    return false;
+    *ptCount = pointArray.cnt;
+    *points = pointArray.list;
+    return true;
 }
 
 
@@ -1252,13 +1237,13 @@ static bool _attrParsePolygonNode(void* data, const char* key, const char* value
     else polygon = &(node->node.polyline);
 
     if (!strcmp(key, "points")) {
-        return _attrParsePolygonPoints(value, &polygon->points, &polygon->pointsCount);
+        return _attrParsePolygonPoints(&loader->arena, value, &polygon->points, &polygon->pointsCount);
     } else if (!strcmp(key, "style")) {
         return simpleXmlParseW3CAttribute(value, _parseStyleAttr, loader);
     } else if (!strcmp(key, "clip-path")) {
         _handleClipPathAttr(loader, node, value);
     } else if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else {
         return _parseStyleAttr(loader, key, value);
     }
@@ -1268,7 +1253,7 @@ static bool _attrParsePolygonNode(void* data, const char* key, const char* value
 
 static SvgNode* _createPolygonNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Polygon);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Polygon);
 
     simpleXmlParseAttributes(buf, bufLength, _attrParsePolygonNode, loader);
     return loader->svgParse->node;
@@ -1277,7 +1262,7 @@ static SvgNode* _createPolygonNode(SvgLoaderData* loader, SvgNode* parent, const
 
 static SvgNode* _createPolylineNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Polyline);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Polyline);
 
     simpleXmlParseAttributes(buf, bufLength, _attrParsePolygonNode, loader);
     return loader->svgParse->node;
@@ -1328,7 +1313,7 @@ static bool _attrParseRectNode(void* data, const char* key, const char* value)
     }
 
     if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else if (!strcmp(key, "style")) {
         ret = simpleXmlParseW3CAttribute(value, _parseStyleAttr, loader);
     } else if (!strcmp(key, "clip-path")) {
@@ -1343,7 +1328,7 @@ static bool _attrParseRectNode(void* data, const char* key, const char* value)
 
 static SvgNode* _createRectNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Rect);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Rect);
     if (loader->svgParse->node) {
         loader->svgParse->node->node.rect.hasRx = loader->svgParse->node->node.rect.hasRy = false;
     }
@@ -1388,7 +1373,7 @@ static bool _attrParseLineNode(void* data, const char* key, const char* value)
     }
 
     if (!strcmp(key, "id")) {
-        node->id = _copyId(value);
+        node->id = _copyId(loader, value);
     } else if (!strcmp(key, "style")) {
         return simpleXmlParseW3CAttribute(value, _parseStyleAttr, loader);
     } else if (!strcmp(key, "clip-path")) {
@@ -1402,106 +1387,73 @@ static bool _attrParseLineNode(void* data, const char* key, const char* value)
 
 static SvgNode* _createLineNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::Line);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::Line);
 
     simpleXmlParseAttributes(buf, bufLength, _attrParseLineNode, loader);
     return loader->svgParse->node;
 }
 
 
-static string* _idFromHref(const char* href)
+static char* _idFromHref(SvgArena* arena, const char* href)
 {
     href = _skipSpace(href, nullptr);
     if ((*href) == '#') href++;
-    return new string(href);
-}
-
-
-static SvgNode* _getDefsNode(SvgNode* node)
-{
-    if (!node) return nullptr;
-
-    while (node->parent != nullptr) {
-        node = node->parent;
-    }
-
-    if (node->type == SvgNodeType::Doc) return node->node.doc.defs;
-
-    return nullptr;
+    return arena->strdup(href);
 }
 
 
-static SvgNode* _findChildById(SvgNode* node, const char* id)
-{
-    if (!node) return nullptr;
-
-    auto child = node->child.list;
-    for (uint32_t i = 0; i < node->child.cnt; ++i, ++child) {
-        if (((*child)->id != nullptr) && !strcmp((*child)->id->c_str(), id)) return (*child);
-    }
-    return nullptr;
-}
-
-static SvgNode* _findNodeById(SvgNode *node, string* id)
+static bool _isAncestor(SvgNode* node, SvgNode* descendant)
 {
-    SvgNode* result = nullptr;
-    if (node->id && !node->id->compare(*id)) return node;
-
-    if (node->child.cnt > 0) {
-        auto child = node->child.list;
-        for (uint32_t i = 0; i < node->child.cnt; ++i, ++child) {
-            result = _findNodeById(*child, id);
-            if (result) break;
-        }
+    for (auto parent = descendant; parent; parent = parent->parent) {
+        if (parent == node) return true;
     }
-    return result;
+    return false;
 }
 
-static void _cloneGradStops(SvgVector<Fill::ColorStop*>* dst, SvgVector<Fill::ColorStop*>* src)
+static void _cloneGradStops(SvgArena* arena, SvgArray<Fill::ColorStop>* dst, SvgArray<Fill::ColorStop>* src)
 {
     for (uint32_t i = 0; i < src->cnt; ++i) {
-        auto stop = static_cast<Fill::ColorStop *>(malloc(sizeof(Fill::ColorStop)));
-        *stop = *src->list[i];
-        dst->push(stop);
+        dst->push(arena, src->list[i]);
     }
 }
 
 
-static SvgStyleGradient* _cloneGradient(SvgStyleGradient* from)
+static SvgStyleGradient* _cloneGradient(SvgArena* arena, SvgStyleGradient* from)
 {
     SvgStyleGradient* grad;
 
     if (!from) return nullptr;
 
-    grad = (SvgStyleGradient*)calloc(1, sizeof(SvgStyleGradient));
+    grad = arena->alloc<SvgStyleGradient>();
     grad->type = from->type;
-    grad->id = from->id ? _copyId(from->id->c_str()) : nullptr;
-    grad->ref = from->ref ? _copyId(from->ref->c_str()) : nullptr;
+    //Strings are immutable once parsed, they can be shared.
+    grad->id = from->id;
+    grad->ref = from->ref;
     grad->spread = from->spread;
     grad->usePercentage = from->usePercentage;
     grad->userSpace = from->userSpace;
     if (from->transform) {
-        grad->transform = (Matrix*)calloc(1, sizeof(Matrix));
+        grad->transform = arena->alloc<Matrix>();
         memcpy(grad->transform, from->transform, sizeof(Matrix));
     }
     if (grad->type == SvgGradientType::Linear) {
-        grad->linear = (SvgLinearGradient*)calloc(1, sizeof(SvgLinearGradient));
+        grad->linear = arena->alloc<SvgLinearGradient>();
         memcpy(grad->linear, from->linear, sizeof(SvgLinearGradient));
     } else if (grad->type == SvgGradientType::Radial) {
-        grad->radial = (SvgRadialGradient*)calloc(1, sizeof(SvgRadialGradient));
+        grad->radial = arena->alloc<SvgRadialGradient>();
         memcpy(grad->radial, from->radial, sizeof(SvgRadialGradient));
     }
 
-    _cloneGradStops(&grad->stops, &from->stops);
+    _cloneGradStops(arena, &grad->stops, &from->stops);
     return grad;
 }
 
 
-static void _copyAttr(SvgNode* to, SvgNode* from)
+static void _copyAttr(SvgArena* arena, SvgNode* to, SvgNode* from)
 {
     //Copy matrix attribute
     if (from->transform) {
-        to->transform = (Matrix*)calloc(1, sizeof(Matrix));
+        to->transform = arena->alloc<Matrix>();
         memcpy(to->transform, from->transform, sizeof(Matrix));
     }
     //Copy style attribute;
@@ -1541,19 +1493,17 @@ static void _copyAttr(SvgNode* to, SvgNode* from)
             break;
         }
         case SvgNodeType::Path: {
-            to->node.path.path = new string(from->node.path.path->c_str());
+            to->node.path.path = from->node.path.path;
             break;
         }
         case SvgNodeType::Polygon: {
             to->node.polygon.pointsCount = from->node.polygon.pointsCount;
-            to->node.polygon.points = (float*)malloc(to->node.polygon.pointsCount * sizeof(float));
-            memcpy(to->node.polygon.points, from->node.polygon.points, to->node.polygon.pointsCount * sizeof(float));
+            to->node.polygon.points = from->node.polygon.points;
             break;
         }
         case SvgNodeType::Polyline: {
             to->node.polyline.pointsCount = from->node.polyline.pointsCount;
-            to->node.polyline.points = (float*)malloc(to->node.polyline.pointsCount * sizeof(float));
-            memcpy(to->node.polyline.points, from->node.polyline.points, to->node.polyline.pointsCount * sizeof(float));
+            to->node.polyline.points = from->node.polyline.points;
             break;
         }
         default: {
@@ -1563,17 +1513,19 @@ static void _copyAttr(SvgNode* to, SvgNode* from)
 }
 
 
-static void _cloneNode(SvgNode* from, SvgNode* parent)
+static void _cloneNode(SvgLoaderData* loader, SvgNode* from, SvgNode* parent)
 {
     SvgNode* newNode;
     if (!from || !parent) return;
 
-    newNode = _createNode(parent, from->type);
-    _copyAttr(newNode, from);
+    //A node referring to its own ancestor would be cloned endlessly
+    if (_isAncestor(from, parent)) return;
 
-    auto child = from->child.list;
-    for (uint32_t i = 0; i < from->child.cnt; ++i, ++child) {
-        _cloneNode(*child, newNode);
+    newNode = _createNode(loader, parent, from->type);
+    _copyAttr(&loader->arena, newNode, from);
+
+    for (auto child = from->child; child; child = child->next) {
+        _cloneNode(loader, child, newNode);
     }
 }
 
@@ -1581,15 +1533,15 @@ static void _cloneNode(SvgNode* from, SvgNode* parent)
 static bool _attrParseUseNode(void* data, const char* key, const char* value)
 {
     SvgLoaderData* loader = (SvgLoaderData*)data;
-    SvgNode *defs, *nodeFrom, *node = loader->svgParse->node;
-    string* id;
+    SvgNode *nodeFrom, *node = loader->svgParse->node;
 
     if (!strcmp(key, "xlink:href")) {
-        id = _idFromHref(value);
-        defs = _getDefsNode(node);
-        nodeFrom = _findChildById(defs, id->c_str());
-        _cloneNode(nodeFrom, node);
-        delete id;
+        auto id = _skipSpace(value, nullptr);
+        if ((*id) == '#') id++;
+        nodeFrom = loader->nodeIds.find(id);
+        if (nodeFrom) _cloneNode(loader, nodeFrom, node);
+        //Forward reference, resolve it once the whole document is parsed.
+        else loader->pendingUses.push({node, loader->arena.strdup(id)});
     } else if (!strcmp(key, "clip-path")) {
         _handleClipPathAttr(loader, node, value);
     } else {
@@ -1601,7 +1553,7 @@ static bool _attrParseUseNode(void* data, const char* key, const char* value)
 
 static SvgNode* _createUseNode(SvgLoaderData* loader, SvgNode* parent, const char* buf, unsigned bufLength)
 {
-    loader->svgParse->node = _createNode(parent, SvgNodeType::G);
+    loader->svgParse->node = _createNode(loader, parent, SvgNodeType::G);
 
     simpleXmlParseAttributes(buf, bufLength, _attrParseUseNode, loader);
     return loader->svgParse->node;
@@ -1777,11 +1729,11 @@ static bool _attrParseRadialGradientNode(void* data, const char* key, const char
     }
 
     if (!strcmp(key, "id")) {
-        grad->id = _copyId(value);
+        grad->id = _copyId(loader, value);
     } else if (!strcmp(key, "spreadMethod")) {
         grad->spread = _parseSpreadValue(value);
     } else if (!strcmp(key, "xlink:href")) {
-        grad->ref = _idFromHref(value);
+        grad->ref = _idFromHref(&loader->arena, value);
     } else if (!strcmp(key, "gradientUnits") && !strcmp(value, "userSpaceOnUse")) {
         grad->userSpace = true;
     }
@@ -1793,12 +1745,12 @@ static bool _attrParseRadialGradientNode(void* data, const char* key, const char
 static SvgStyleGradient* _createRadialGradient(SvgLoaderData* loader, const char* buf, unsigned bufLength)
 {
     unsigned int i = 0;
-    SvgStyleGradient* grad = (SvgStyleGradient*)calloc(1, sizeof(SvgStyleGradient));
+    SvgStyleGradient* grad = loader->arena.alloc<SvgStyleGradient>();
     loader->svgParse->styleGrad = grad;
 
     grad->type = SvgGradientType::Radial;
     grad->userSpace = false;
-    grad->radial = (SvgRadialGradient*)calloc(1, sizeof(SvgRadialGradient));
+    grad->radial = loader->arena.alloc<SvgRadialGradient>();
     /**
     * Default values of gradient
     */
@@ -1826,14 +1778,14 @@ static SvgStyleGradient* _createRadialGradient(SvgLoaderData* loader, const char
 static bool _attrParseStops(void* data, const char* key, const char* value)
 {
     SvgLoaderData* loader = (SvgLoaderData*)data;
-    auto stop = loader->svgParse->gradStop;
+    auto stop = &loader->svgParse->gradStop;
 
     if (!strcmp(key, "offset")) {
         stop->offset = _toOffset(value);
     } else if (!strcmp(key, "stop-opacity")) {
         stop->a = _toOpacity(value);
     } else if (!strcmp(key, "stop-color")) {
-        _toColor(value, &stop->r, &stop->g, &stop->b, nullptr);
+        _toColor(&loader->arena, value, &stop->r, &stop->g, &stop->b, nullptr);
     } else if (!strcmp(key, "style")) {
         simpleXmlParseW3CAttribute(value,
             _attrParseStops, data);
@@ -1931,15 +1883,15 @@ static bool _attrParseLinearGradientNode(void* data, const char* key, const char
     }
 
     if (!strcmp(key, "id")) {
-        grad->id = _copyId(value);
+        grad->id = _copyId(loader, value);
     } else if (!strcmp(key, "spreadMethod")) {
         grad->spread = _parseSpreadValue(value);
     } else if (!strcmp(key, "xlink:href")) {
-        grad->ref = _idFromHref(value);
+        grad->ref = _idFromHref(&loader->arena, value);
     } else if (!strcmp(key, "gradientUnits") && !strcmp(value, "userSpaceOnUse")) {
         grad->userSpace = true;
     } else if (!strcmp(key, "gradientTransform")) {
-        grad->transform = _parseTransformationMatrix(value);
+        grad->transform = _parseTransformationMatrix(&loader->arena, value);
     }
 
     return true;
@@ -1948,13 +1900,13 @@ static bool _attrParseLinearGradientNode(void* data, const char* key, const char
 
 static SvgStyleGradient* _createLinearGradient(SvgLoaderData* loader, const char* buf, unsigned bufLength)
 {
-    SvgStyleGradient* grad = (SvgStyleGradient*)calloc(1, sizeof(SvgStyleGradient));
+    SvgStyleGradient* grad = loader->arena.alloc<SvgStyleGradient>();
     loader->svgParse->styleGrad = grad;
     unsigned int i;
 
     grad->type = SvgGradientType::Linear;
     grad->userSpace = false;
-    grad->linear = (SvgLinearGradient*)calloc(1, sizeof(SvgLinearGradient));
+    grad->linear = loader->arena.alloc<SvgLinearGradient>();
     /**
     * Default value of x2 is 100%
     */
@@ -2079,6 +2031,8 @@ static void _svgLoaderParserXmlOpen(SvgLoaderData* loader, const char* content,
             node = method(loader, parent, attrs, attrsLength);
         }
 
+        loader->nodeIds.insert(node->id, node);
+
         if (node->type == SvgNodeType::Defs) {
             loader->doc->node.doc.defs = node;
             loader->def = node;
@@ -2090,29 +2044,19 @@ static void _svgLoaderParserXmlOpen(SvgLoaderData* loader, const char* content,
         if (loader->stack.cnt > 0) parent = loader->stack.list[loader->stack.cnt - 1];
         else parent = loader->doc;
         node = method(loader, parent, attrs, attrsLength);
+        loader->nodeIds.insert(node->id, node);
     } else if ((gradientMethod = _findGradientFactory(tagName))) {
         SvgStyleGradient* gradient;
         gradient = gradientMethod(loader, attrs, attrsLength);
-        //FIXME: The current parsing structure does not distinguish end tags.
-        //       There is no way to know if the currently parsed gradient is in defs.
-        //       If a gradient is declared outside of defs after defs is set, it is included in the gradients of defs.
-        //       But finally, the loader has a gradient style list regardless of defs.
-        //       This is only to support this when multiple gradients are declared, even if no defs are declared.
-        //       refer to: https://developer.mozilla.org/en-US/docs/Web/SVG/Element/defs
-        if (loader->def && loader->doc->node.doc.defs) {
-            loader->def->node.defs.gradients.push(gradient);
-        } else {
-            loader->gradients.push(gradient);
-        }
+        //Gradients are looked up by their ids wherever they are declared, in defs or not.
+        if (gradient) loader->gradientIds.insert(gradient->id, gradient);
         loader->latestGradient = gradient;
     } else if (!strcmp(tagName, "stop")) {
-        auto stop = static_cast<Fill::ColorStop*>(calloc(1, sizeof(Fill::ColorStop)));
-        loader->svgParse->gradStop = stop;
-        /* default value for opacity */
-        stop->a = 255;
+        auto stop = &loader->svgParse->gradStop;
+        *stop = {0.0f, 0, 0, 0, 255};   /* default value for opacity */
         simpleXmlParseAttributes(attrs, attrsLength, _attrParseStops, loader);
         if (loader->latestGradient) {
-            loader->latestGradient->stops.push(stop);
+            loader->latestGradient->stops.push(&loader->arena, *stop);
         }
     }
 }
@@ -2165,7 +2109,7 @@ static void _styleInherit(SvgStyleProperty* child, SvgStyleProperty* parent)
         child->fill.paint.b = parent->fill.paint.b;
         child->fill.paint.none = parent->fill.paint.none;
         child->fill.paint.curColor = parent->fill.paint.curColor;
-        if (parent->fill.paint.url) child->fill.paint.url = _copyId(parent->fill.paint.url->c_str());
+        if (parent->fill.paint.url) child->fill.paint.url = parent->fill.paint.url;
     }
     if (!((int)child->fill.flags & (int)SvgFillFlags::Opacity)) {
         child->fill.opacity = parent->fill.opacity;
@@ -2180,7 +2124,7 @@ static void _styleInherit(SvgStyleProperty* child, SvgStyleProperty* parent)
         child->stroke.paint.b = parent->stroke.paint.b;
         child->stroke.paint.none = parent->stroke.paint.none;
         child->stroke.paint.curColor = parent->stroke.paint.curColor;
-        child->stroke.paint.url = parent->stroke.paint.url ? _copyId(parent->stroke.paint.url->c_str()) : nullptr;
+        child->stroke.paint.url = parent->stroke.paint.url;
     }
     if (!((int)child->stroke.flags & (int)SvgStrokeFlags::Opacity)) {
         child->stroke.opacity = parent->stroke.opacity;
@@ -2189,12 +2133,11 @@ static void _styleInherit(SvgStyleProperty* child, SvgStyleProperty* parent)
         child->stroke.width = parent->stroke.width;
     }
     if (!((int)child->stroke.flags & (int)SvgStrokeFlags::Dash)) {
-        if (parent->stroke.dash.array.cnt > 0) {
-            child->stroke.dash.array.clear();
-            for (uint32_t i = 0; i < parent->stroke.dash.array.cnt; ++i) {
-                child->stroke.dash.array.push(parent->stroke.dash.array.list[i]);
-            }
-        }
+        //Dash arrays are immutable once parsed, they can be shared.
+        if (parent->stroke.dash.array.cnt > 0) child->stroke.dash.array = parent->stroke.dash.array;
+    }
+    if (!((int)child->stroke.flags & (int)SvgStrokeFlags::DashOffset)) {
+        child->stroke.dash.offset = parent->stroke.dash.offset;
     }
     if (!((int)child->stroke.flags & (int)SvgStrokeFlags::Cap)) {
         child->stroke.cap = parent->stroke.cap;
@@ -2209,152 +2152,64 @@ static void _updateStyle(SvgNode* node, SvgStyleProperty* parentStyle)
 {
     _styleInherit(node->style, parentStyle);
 
-    auto child = node->child.list;
-    for (uint32_t i = 0; i < node->child.cnt; ++i, ++child) {
-        _updateStyle(*child, node->style);
+    for (auto child = node->child; child; child = child->next) {
+        _updateStyle(child, node->style);
     }
 }
 
 
-static SvgStyleGradient* _gradientDup(SvgVector<SvgStyleGradient*>* gradients, string* id)
+static SvgStyleGradient* _gradientDup(SvgLoaderData* loader, const char* id)
 {
-    SvgStyleGradient* result = nullptr;
-
-    auto gradList = gradients->list;
-
-    for (uint32_t i = 0; i < gradients->cnt; ++i) {
-        if (!((*gradList)->id->compare(*id))) {
-            result = _cloneGradient(*gradList);
-            break;
-        }
-        ++gradList;
-    }
+    auto result = _cloneGradient(&loader->arena, loader->gradientIds.find(id));
 
     if (result && result->ref) {
-        gradList = gradients->list;
-        for (uint32_t i = 0; i < gradients->cnt; ++i) {
-            if (!((*gradList)->id->compare(*result->ref))) {
-                if (result->stops.cnt > 0) {
-                    _cloneGradStops(&result->stops, &(*gradList)->stops);
-                }
-                //TODO: Properly inherit other property
-                break;
-            }
-            ++gradList;
+        auto ref = loader->gradientIds.find(result->ref);
+        if (ref && result->stops.cnt > 0) {
+            _cloneGradStops(&loader->arena, &result->stops, &ref->stops);
         }
+        //TODO: Properly inherit other property
     }
 
     return result;
 }
 
 
-static void _updateGradient(SvgNode* node, SvgVector<SvgStyleGradient*>* gradidents)
+static void _updateGradient(SvgLoaderData* loader, SvgNode* node)
 {
-    if (node->child.cnt > 0) {
-        auto child = node->child.list;
-        for (uint32_t i = 0; i < node->child.cnt; ++i, ++child) {
-            _updateGradient(*child, gradidents);
+    if (node->child) {
+        for (auto child = node->child; child; child = child->next) {
+            _updateGradient(loader, child);
         }
     } else {
         if (node->style->fill.paint.url) {
-            node->style->fill.paint.gradient = _gradientDup(gradidents, node->style->fill.paint.url);
+            node->style->fill.paint.gradient = _gradientDup(loader, node->style->fill.paint.url);
         } else if (node->style->stroke.paint.url) {
-            //node->style->stroke.paint.gradient = _gradientDup(gradList, node->style->stroke.paint.url);
+            //node->style->stroke.paint.gradient = _gradientDup(loader, node->style->stroke.paint.url);
         }
     }
 }
 
-static void _updateComposite(SvgNode* node, SvgNode* root)
+
+static void _updateComposite(SvgLoaderData* loader, SvgNode* node)
 {
     if (node->style->comp.url && !node->style->comp.node) {
-        SvgNode *findResult = _findNodeById(root, node->style->comp.url);
-        if (findResult) node->style->comp.node = findResult;
-    }
-    if (node->child.cnt > 0) {
-        auto child = node->child.list;
-        for (uint32_t i = 0; i < node->child.cnt; ++i, ++child) {
-            _updateComposite(*child, root);
-        }
+        node->style->comp.node = loader->nodeIds.find(node->style->comp.url);
     }
-}
-
-static void _freeGradientStyle(SvgStyleGradient* grad)
-{
-    if (!grad) return;
-
-    delete grad->id;
-    delete grad->ref;
-    free(grad->radial);
-    free(grad->linear);
-    if (grad->transform) free(grad->transform);
-
-    for (uint32_t i = 0; i < grad->stops.cnt; ++i) {
-        auto colorStop = grad->stops.list[i];
-        free(colorStop);
+    for (auto child = node->child; child; child = child->next) {
+        _updateComposite(loader, child);
     }
-    grad->stops.clear();
-    free(grad);
 }
 
-static void _freeNodeStyle(SvgStyleProperty* style)
-{
-    if (!style) return;
-
-    _freeGradientStyle(style->fill.paint.gradient);
-    delete style->fill.paint.url;
-    _freeGradientStyle(style->stroke.paint.gradient);
-    if (style->stroke.dash.array.cnt > 0) style->stroke.dash.array.clear();
-    delete style->stroke.paint.url;
-    free(style);
-}
 
-static void _freeNode(SvgNode* node)
+static void _updateUses(SvgLoaderData* loader)
 {
-    if (!node) return;
-
-    auto child = node->child.list;
-    for (uint32_t i = 0; i < node->child.cnt; ++i, ++child) {
-        _freeNode(*child);
-    }
-    node->child.clear();
-
-    delete node->id;
-    free(node->transform);
-    _freeNodeStyle(node->style);
-    switch (node->type) {
-         case SvgNodeType::Path: {
-             delete node->node.path.path;
-             break;
-         }
-         case SvgNodeType::Polygon: {
-             free(node->node.polygon.points);
-             break;
-         }
-         case SvgNodeType::Polyline: {
-             free(node->node.polyline.points);
-             break;
-         }
-         case SvgNodeType::Doc: {
-             _freeNode(node->node.doc.defs);
-             break;
-         }
-         case SvgNodeType::Defs: {
-             auto gradients = node->node.defs.gradients.list;
-             for (size_t i = 0; i < node->node.defs.gradients.cnt; ++i) {
-                 _freeGradientStyle(*gradients);
-                 ++gradients;
-             }
-             node->node.defs.gradients.clear();
-             break;
-         }
-         default: {
-             break;
-         }
+    for (uint32_t i = 0; i < loader->pendingUses.cnt; ++i) {
+        auto use = &loader->pendingUses.list[i];
+        _cloneNode(loader, loader->nodeIds.find(use->id), use->node);
     }
-    free(node);
+    loader->pendingUses.clear();
 }
 
-
 static bool _svgLoaderParserForValidCheckXmlOpen(SvgLoaderData* loader, const char* content, unsigned int length)
 {
     const char* attrs = nullptr;
@@ -2436,14 +2291,10 @@ void SvgLoader::run(unsigned tid)
     if (!simpleXmlParse(content, size, true, _svgLoaderParser, &(loaderData))) return;
 
     if (loaderData.doc) {
+        _updateUses(&loaderData);
         _updateStyle(loaderData.doc, nullptr);
-        auto defs = loaderData.doc->node.doc.defs;
-        if (defs) _updateGradient(loaderData.doc, &defs->node.defs.gradients);
-
-        if (loaderData.gradients.cnt > 0) _updateGradient(loaderData.doc, &loaderData.gradients);
-
-        _updateComposite(loaderData.doc, loaderData.doc);
-        if (defs) _updateComposite(loaderData.doc, defs);
+        _updateGradient(&loaderData, loaderData.doc);
+        _updateComposite(&loaderData, loaderData.doc);
     }
     root = builder.build(loaderData.doc);
 };
@@ -2524,16 +2375,16 @@ bool SvgLoader::close()
         free(loaderData.svgParse);
         loaderData.svgParse = nullptr;
     }
-    auto gradients = loaderData.gradients.list;
-    for (size_t i = 0; i < loaderData.gradients.cnt; ++i) {
-        _freeGradientStyle(*gradients);
-        ++gradients;
-    }
-    loaderData.gradients.clear();
 
-    _freeNode(loaderData.doc);
+    //Every node, style, gradient and string lives in the arena.
+    loaderData.arena.clear();
+    loaderData.latestGradient = nullptr;
+    loaderData.def = nullptr;
     loaderData.doc = nullptr;
     loaderData.stack.clear();
+    loaderData.nodeIds.clear();
+    loaderData.gradientIds.clear();
+    loaderData.pendingUses.clear();
 
     return true;
 }
@@ -22,6 +22,7 @@
 #ifndef _TVG_SVG_LOADER_COMMON_H_
 #define _TVG_SVG_LOADER_COMMON_H_
 
+#include <cstring>
 #include "tvgCommon.h"
 
 enum class SvgNodeType
@@ -85,6 +86,7 @@ enum class SvgStrokeFlags
     Cap = 0x20,
     Join = 0x40,
     Dash = 0x80,
+    DashOffset = 0x100,
 };
 
 enum class SvgGradientType
@@ -154,6 +156,183 @@ struct SvgVector
     }
 };
 
+/* Bump allocator owning every piece of a parsed document (nodes, styles, gradients,
+ * stops and strings). Nothing is released individually; clear() drops it all at once. */
+struct SvgArena
+{
+    static constexpr size_t BLOCK_SIZE = 16384;
+    static constexpr size_t ALIGN = 8;
+
+    struct Block
+    {
+        Block* next;
+        size_t size;
+        size_t used;
+    };
+
+    Block* head = nullptr;
+
+    //Returns zero-filled memory, just like calloc()
+    void* alloc(size_t size)
+    {
+        size = (size + ALIGN - 1) & ~(ALIGN - 1);
+
+        if (!head || head->used + size > head->size) {
+            auto blockSize = (size > BLOCK_SIZE / 4) ? size : BLOCK_SIZE;
+            auto block = static_cast<Block*>(calloc(1, sizeof(Block) + blockSize));
+            if (!block) return nullptr;
+            block->size = blockSize;
+            //Keep bumping from the current block if the large one was a one-off
+            if (head && blockSize == size) {
+                block->next = head->next;
+                head->next = block;
+                block->used = size;
+                return reinterpret_cast<char*>(block + 1);
+            }
+            block->next = head;
+            head = block;
+        }
+        auto ptr = reinterpret_cast<char*>(head + 1) + head->used;
+        head->used += size;
+        return ptr;
+    }
+
+    template<class T>
+    T* alloc()
+    {
+        return static_cast<T*>(alloc(sizeof(T)));
+    }
+
+    char* strdup(const char* str, size_t len)
+    {
+        auto ret = static_cast<char*>(alloc(len + 1));
+        if (!ret) return nullptr;
+        memcpy(ret, str, len);
+        ret[len] = '\0';
+        return ret;
+    }
+
+    char* strdup(const char* str)
+    {
+        if (!str) return nullptr;
+        return strdup(str, strlen(str));
+    }
+
+    void clear()
+    {
+        while (head) {
+            auto next = head->next;
+            free(head);
+            head = next;
+        }
+    }
+};
+
+//Growable array whose storage comes from the SvgArena, it's never freed on its own.
+template<class T>
+struct SvgArray
+{
+    T* list;
+    uint32_t cnt;
+    uint32_t reserved;
+
+    //The list is kept as it is when it can't grow.
+    bool push(SvgArena* arena, T element)
+    {
+        if (cnt + 1 > reserved) {
+            auto size = (cnt + 1) * 2;
+            auto tmp = static_cast<T*>(arena->alloc(sizeof(T) * size));
+            if (!tmp) return false;
+            if (list) memcpy(tmp, list, sizeof(T) * cnt);
+            list = tmp;
+            reserved = size;
+        }
+        list[cnt++] = element;
+        return true;
+    }
+};
+
+//Open addressing hash table from id strings to T*. Keys are borrowed (arena strings).
+template<class T>
+struct SvgIdMap
+{
+    struct Entry
+    {
+        const char* key;
+        uint32_t hash;
+        T* value;
+    };
+
+    Entry* entries = nullptr;
+    uint32_t cnt = 0;
+    uint32_t reserved = 0;      //power of 2
+
+    static uint32_t hash(const char* str)
+    {
+        //FNV-1a
+        uint32_t h = 2166136261u;
+        while (*str) {
+            h ^= static_cast<uint8_t>(*str++);
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    Entry* slot(const char* key, uint32_t h)
+    {
+        auto mask = reserved - 1;
+        auto idx = h & mask;
+        while (entries[idx].key) {
+            if (entries[idx].hash == h && !strcmp(entries[idx].key, key)) break;
+            idx = (idx + 1) & mask;
+        }
+        return &entries[idx];
+    }
+
+    //The old table is kept when a larger one can't be made.
+    bool grow()
+    {
+        auto size = reserved ? reserved * 2 : 64;
+        auto tmp = static_cast<Entry*>(calloc(size, sizeof(Entry)));
+        if (!tmp) return false;
+
+        auto old = entries;
+        auto oldReserved = reserved;
+        entries = tmp;
+        reserved = size;
+        for (uint32_t i = 0; i < oldReserved; ++i) {
+            if (old[i].key) *slot(old[i].key, old[i].hash) = old[i];
+        }
+        free(old);
+        return true;
+    }
+
+    //The first definition wins, like getElementById()
+    void insert(const char* key, T* value)
+    {
+        if (!key || !value) return;
+        if ((cnt + 1) * 4 > reserved * 3 && !grow()) return;
+        auto h = hash(key);
+        auto entry = slot(key, h);
+        if (entry->key) return;
+        *entry = {key, h, value};
+        ++cnt;
+    }
+
+    T* find(const char* key)
+    {
+        if (!key || cnt == 0) return nullptr;
+        return slot(key, hash(key))->value;
+    }
+
+    void clear()
+    {
+        free(entries);
+        entries = nullptr;
+        cnt = reserved = 0;
+    }
+};
+
 struct SvgDocNode
 {
     float w;
@@ -172,7 +351,6 @@ struct SvgGNode
 
 struct SvgDefsNode
 {
-    SvgVector<SvgStyleGradient*> gradients;
 };
 
 struct SvgArcNode
@@ -216,7 +394,7 @@ struct SvgLineNode
 
 struct SvgPathNode
 {
-    string* path;
+    char* path;
 };
 
 struct SvgPolygonNode
@@ -254,14 +432,14 @@ struct SvgGradientStop
 struct SvgComposite
 {
     SvgCompositeFlags flags;
-    string *url;
+    char* url;
     SvgNode* node;
 };
 
 struct SvgPaint
 {
     SvgStyleGradient* gradient;
-    string *url;
+    char* url;
     uint8_t r;
     uint8_t g;
     uint8_t b;
@@ -271,19 +449,20 @@ struct SvgPaint
 
 struct SvgDash
 {
-    SvgVector<float> array;
+    SvgArray<float> array;
+    float offset;
 };
 
 struct SvgStyleGradient
 {
     SvgGradientType type;
-    string *id;
-    string *ref;
+    char* id;
+    char* ref;
     FillSpread spread;
     SvgRadialGradient* radial;
     SvgLinearGradient* linear;
     Matrix* transform;
-    SvgVector<Fill::ColorStop *> stops;
+    SvgArray<Fill::ColorStop> stops;
     bool userSpace;
     bool usePercentage;
 };
@@ -325,8 +504,10 @@ struct SvgNode
 {
     SvgNodeType type;
     SvgNode* parent;
-    SvgVector<SvgNode*> child;
-    string *id;
+    SvgNode* child;         //first child, siblings are chained by next
+    SvgNode* lastChild;
+    SvgNode* next;
+    char* id;
     SvgStyleProperty *style;
     Matrix* transform;
     union {
@@ -349,7 +530,7 @@ struct SvgParser
 {
     SvgNode* node;
     SvgStyleGradient* styleGrad;
-    Fill::ColorStop* gradStop;
+    Fill::ColorStop gradStop;
     struct
     {
         int x, y;
@@ -362,14 +543,23 @@ struct SvgParser
     } gradient;
 };
 
+struct SvgUseRef
+{
+    SvgNode* node;
+    const char* id;
+};
+
 struct SvgLoaderData
 {
     SvgVector<SvgNode *> stack = {nullptr, 0, 0};
     SvgNode* doc = nullptr;
     SvgNode* def = nullptr;
-    SvgVector<SvgStyleGradient*> gradients;
     SvgStyleGradient* latestGradient = nullptr; //For stops
+    SvgIdMap<SvgNode> nodeIds;
+    SvgIdMap<SvgStyleGradient> gradientIds;
+    SvgVector<SvgUseRef> pendingUses;           //<use> referring to not yet parsed nodes
     SvgParser* svgParse = nullptr;
+    SvgArena arena;
     int level = 0;
     bool result = false;
 };
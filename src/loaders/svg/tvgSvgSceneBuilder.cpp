@@ -98,7 +98,7 @@ unique_ptr<LinearGradient> _applyLinearGradientProperty(SvgStyleGradient* g, Sha
     if (stopCount > 0) {
         stops = (Fill::ColorStop*)calloc(stopCount, sizeof(Fill::ColorStop));
         for (uint32_t i = 0; i < g->stops.cnt; ++i) {
-            auto colorStop = g->stops.list[i];
+            auto colorStop = &g->stops.list[i];
             //Use premultiplied color
             stops[i].r = colorStop->r;
             stops[i].g = colorStop->g;
@@ -163,16 +163,15 @@ unique_ptr<RadialGradient> _applyRadialGradientProperty(SvgStyleGradient* g, Sha
          //= T(gx, gy) x S(scaleX, scaleY) x T(cx_scaled - cx, cy_scaled - cy) x (radial->x, radial->y)
         g->radial->cx = g->radial->cx * scaleX + scaleX * (cx_scaled - cx) + gx;
         g->radial->cy = g->radial->cy * scaleY + scaleY * (cy_scaled - cy) + gy;
+        g->radial->fx = g->radial->fx * scaleX + scaleX * (cx_scaled - cx) + gx;
+        g->radial->fy = g->radial->fy * scaleY + scaleY * (cy_scaled - cy) + gy;
     }
 
     //TODO: Radial gradient transformation is not yet supported.
     //if (g->transform) {}
 
-    //TODO: Tvg is not support to focal
-    //if (g->radial->fx != 0 && g->radial->fy != 0) {
-    //    fillGrad->radial(g->radial->fx, g->radial->fy, g->radial->r);
-    //}
     fillGrad->radial(g->radial->cx, g->radial->cy, g->radial->r);
+    fillGrad->focal(g->radial->fx, g->radial->fy);
     fillGrad->spread(g->spread);
 
     //Update the stops
@@ -180,7 +179,7 @@ unique_ptr<RadialGradient> _applyRadialGradientProperty(SvgStyleGradient* g, Sha
     if (stopCount > 0) {
         stops = (Fill::ColorStop*)calloc(stopCount, sizeof(Fill::ColorStop));
         for (uint32_t i = 0; i < g->stops.cnt; ++i) {
-            auto colorStop = g->stops.list[i];
+            auto colorStop = &g->stops.list[i];
             //Use premultiplied color
             stops[i].r = colorStop->r;
             stops[i].g = colorStop->g;
@@ -197,10 +196,7 @@ unique_ptr<RadialGradient> _applyRadialGradientProperty(SvgStyleGradient* g, Sha
 void _appendChildShape(SvgNode* node, Shape* shape, float vx, float vy, float vw, float vh)
 {
     _appendShape(node, shape, vx, vy, vw, vh);
-    if (node->child.cnt > 0) {
-        auto child = node->child.list;
-        for (uint32_t i = 0; i < node->child.cnt; ++i, ++child) _appendChildShape(*child, shape, vx, vy, vw, vh);
-    }
+    for (auto child = node->child; child; child = child->next) _appendChildShape(child, shape, vx, vy, vw, vh);
 }
 
 void _applyProperty(SvgNode* node, Shape* vg, float vx, float vy, float vw, float vh)
@@ -245,7 +241,7 @@ void _applyProperty(SvgNode* node, Shape* vg, float vx, float vy, float vw, floa
     vg->stroke(style->stroke.cap);
     vg->stroke(style->stroke.join);
     if (style->stroke.dash.array.cnt > 0)
-        vg->stroke(style->stroke.dash.array.list, style->stroke.dash.array.cnt);
+        vg->stroke(style->stroke.dash.array.list, style->stroke.dash.array.cnt, style->stroke.dash.offset);
 
     //If stroke property is nullptr then do nothing
     if (style->stroke.paint.none) {
@@ -275,10 +271,9 @@ void _applyProperty(SvgNode* node, Shape* vg, float vx, float vy, float vw, floa
         //Composite ClipPath
         if (((int)style->comp.flags & (int)SvgCompositeFlags::ClipPath)) {
             auto compNode = style->comp.node;
-            if (compNode->child.cnt > 0) {
+            if (compNode->child) {
                 auto comp = Shape::gen();
-                auto child = compNode->child.list;
-                for (uint32_t i = 0; i < compNode->child.cnt; ++i, ++child) _appendChildShape(*child, comp.get(), vx, vy, vw, vh);
+                for (auto child = compNode->child; child; child = child->next) _appendChildShape(child, comp.get(), vx, vy, vw, vh);
                 vg->composite(move(comp), CompositeMethod::ClipPath);
             }
         }
@@ -297,7 +292,7 @@ void _appendShape(SvgNode* node, Shape* shape, float vx, float vy, float vw, flo
     switch (node->type) {
         case SvgNodeType::Path: {
             if (node->node.path.path) {
-                auto pathResult = svgPathToTvgPath(node->node.path.path->c_str());
+                auto pathResult = svgPathToTvgPath(node->node.path.path);
                 shape->appendPath(get<0>(pathResult).data(), get<0>(pathResult).size(), get<1>(pathResult).data(), get<1>(pathResult).size());
             }
             break;
@@ -352,13 +347,12 @@ unique_ptr<Scene> _sceneBuildHelper(SvgNode* node, float vx, float vy, float vw,
         node->style->opacity = (node->style->opacity * parentOpacity) / 255.0f;
 
         if (node->display) {
-            auto child = node->child.list;
-            for (uint32_t i = 0; i < node->child.cnt; ++i, ++child) {
-                if (_isGroupType((*child)->type)) {
-                    scene->push(_sceneBuildHelper(*child, vx, vy, vw, vh, node->style->opacity));
+            for (auto child = node->child; child; child = child->next) {
+                if (_isGroupType(child->type)) {
+                    scene->push(_sceneBuildHelper(child, vx, vy, vw, vh, node->style->opacity));
                 } else {
-                    (*child)->style->opacity = ((*child)->style->opacity * node->style->opacity) / 255.0f;
-                    scene->push(_shapeBuildHelper(*child, vx, vy, vw, vh));
+                    child->style->opacity = (child->style->opacity * node->style->opacity) / 255.0f;
+                    scene->push(_shapeBuildHelper(child, vx, vy, vw, vh));
                 }
             }
             //Apply composite node
@@ -366,10 +360,9 @@ unique_ptr<Scene> _sceneBuildHelper(SvgNode* node, float vx, float vy, float vw,
                 //Composite ClipPath
                 if (((int)node->style->comp.flags & (int)SvgCompositeFlags::ClipPath)) {
                     auto compNode = node->style->comp.node;
-                    if (compNode->child.cnt > 0) {
+                    if (compNode->child) {
                         auto comp = Shape::gen();
-                        auto child = compNode->child.list;
-                        for (uint32_t i = 0; i < compNode->child.cnt; ++i, ++child) _appendChildShape(*child, comp.get(), vx, vy, vw, vh);
+                        for (auto child = compNode->child; child; child = child->next) _appendChildShape(child, comp.get(), vx, vy, vw, vh);
                         scene->composite(move(comp), CompositeMethod::ClipPath);
                     }
                 }
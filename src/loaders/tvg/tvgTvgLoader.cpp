@@ -0,0 +1,439 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+#include "tvgLoaderMgr.h"
+#include "tvgTvgLoader.h"
+
+/************************************************************************/
+/* Internal Class Implementation                                        */
+/************************************************************************/
+
+struct TvgBlock
+{
+    TvgBinTag tag;
+    const char* data;
+    uint32_t size;
+};
+
+
+static bool _readBlock(const char** ptr, const char* end, TvgBlock* block)
+{
+    if (end - *ptr < static_cast<long>(TVG_BIN_BLOCK_HEADER_SIZE)) return false;
+
+    uint32_t size;
+    block->tag = static_cast<TvgBinTag>(**ptr);
+    tvgBinCopy(&size, *ptr + sizeof(uint8_t), sizeof(size), sizeof(size));
+    block->data = *ptr + TVG_BIN_BLOCK_HEADER_SIZE;
+    if (static_cast<long>(size) > end - block->data) return false;
+    block->size = size;
+
+    *ptr = block->data + size;
+    return true;
+}
+
+
+//The unit defaults to the element size of a value or an array of values.
+template<typename T>
+static bool _read(const TvgBlock& block, T* value, uint32_t unit = sizeof(typename remove_all_extents<T>::type))
+{
+    if (block.size < sizeof(T)) return false;
+    tvgBinCopy(value, block.data, sizeof(T), unit);
+    return true;
+}
+
+
+static unique_ptr<Paint> _parsePaint(const TvgBlock& block);
+
+
+static bool _parsePaintProperty(Paint* paint, const TvgBlock& block)
+{
+    switch (block.tag) {
+        case TvgBinTag::Opacity: {
+            uint8_t opacity;
+            if (_read(block, &opacity)) paint->opacity(opacity);
+            return true;
+        }
+        case TvgBinTag::Transform: {
+            Matrix m;
+            if (_read(block, &m, sizeof(float))) paint->transform(m);
+            return true;
+        }
+        case TvgBinTag::ClipPath:
+        case TvgBinTag::AlphaMask:
+        case TvgBinTag::InvAlphaMask: {
+            auto method = CompositeMethod::ClipPath;
+            if (block.tag == TvgBinTag::AlphaMask) method = CompositeMethod::AlphaMask;
+            else if (block.tag == TvgBinTag::InvAlphaMask) method = CompositeMethod::InvAlphaMask;
+            auto ptr = block.data;
+            TvgBlock child;
+            if (_readBlock(&ptr, block.data + block.size, &child)) {
+                auto target = _parsePaint(child);
+                if (target) paint->composite(move(target), method);
+            }
+            return true;
+        }
+        default: {
+            return false;
+        }
+    }
+}
+
+
+static void _parsePath(Shape* shape, const TvgBlock& block)
+{
+    uint32_t cnt[2];    //cmdCnt, ptsCnt
+
+    if (!_read(block, &cnt)) return;
+
+    auto cmdsData = block.data + sizeof(cnt);
+    auto ptsData = cmdsData + cnt[0];
+    if (sizeof(cnt) + static_cast<uint64_t>(cnt[0]) + static_cast<uint64_t>(cnt[1]) * sizeof(Point) > block.size) return;
+
+    //Commands are packed in 8 bits, points are copied out as the stream may not be aligned.
+    auto cmds = static_cast<PathCommand*>(malloc(sizeof(PathCommand) * cnt[0]));
+    auto pts = static_cast<Point*>(malloc(sizeof(Point) * cnt[1]));
+    if (cmds && pts) {
+        for (uint32_t i = 0; i < cnt[0]; ++i) {
+            cmds[i] = static_cast<PathCommand>(cmdsData[i]);
+        }
+        tvgBinCopy(pts, ptsData, sizeof(Point) * cnt[1], sizeof(float));
+        shape->appendPath(cmds, cnt[0], pts, cnt[1]);
+    }
+    free(cmds);
+    free(pts);
+}
+
+
+static unique_ptr<Fill> _parseFill(const TvgBlock& block)
+{
+    unique_ptr<Fill> fill = nullptr;
+    auto ptr = block.data;
+    auto end = block.data + block.size;
+    TvgBlock child;
+
+    while (_readBlock(&ptr, end, &child)) {
+        switch (child.tag) {
+            case TvgBinTag::LinearGradient: {
+                float args[4];
+                if (!_read(child, &args)) break;
+                auto linear = LinearGradient::gen();
+                linear->linear(args[0], args[1], args[2], args[3]);
+                fill = move(linear);
+                break;
+            }
+            case TvgBinTag::RadialGradient: {
+                float args[3];
+                if (!_read(child, &args)) break;
+                auto radial = RadialGradient::gen();
+                radial->radial(args[0], args[1], args[2]);
+                fill = move(radial);
+                break;
+            }
+            case TvgBinTag::RadialFocal: {
+                float focal[2];
+                if (!fill || fill->id() != FILL_ID_RADIAL || !_read(child, &focal)) break;
+                static_cast<RadialGradient*>(fill.get())->focal(focal[0], focal[1]);
+                break;
+            }
+            case TvgBinTag::Spread: {
+                uint8_t spread;
+                if (fill && _read(child, &spread)) fill->spread(static_cast<FillSpread>(spread));
+                break;
+            }
+            case TvgBinTag::ColorStops: {
+                uint32_t cnt;
+                if (!fill || !_read(child, &cnt)) break;
+                constexpr auto STOP_SIZE = sizeof(float) + 4 * sizeof(uint8_t);
+                if (sizeof(cnt) + static_cast<uint64_t>(cnt) * STOP_SIZE > child.size) break;
+                auto stops = static_cast<Fill::ColorStop*>(malloc(sizeof(Fill::ColorStop) * cnt));
+                if (!stops) break;
+                auto data = child.data + sizeof(cnt);
+                for (uint32_t i = 0; i < cnt; ++i, data += STOP_SIZE) {
+                    tvgBinCopy(&stops[i].offset, data, sizeof(float), sizeof(float));
+                    memcpy(&stops[i].r, data + sizeof(float), 4 * sizeof(uint8_t));
+                }
+                fill->colorStops(stops, cnt);
+                free(stops);
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+    return fill;
+}
+
+
+static void _parseStroke(Shape* shape, const TvgBlock& block)
+{
+    auto ptr = block.data;
+    auto end = block.data + block.size;
+    TvgBlock child;
+
+    while (_readBlock(&ptr, end, &child)) {
+        switch (child.tag) {
+            case TvgBinTag::StrokeWidth: {
+                float width;
+                if (_read(child, &width)) shape->stroke(width);
+                break;
+            }
+            case TvgBinTag::StrokeColor: {
+                uint8_t color[4];
+                if (_read(child, &color)) shape->stroke(color[0], color[1], color[2], color[3]);
+                break;
+            }
+            case TvgBinTag::StrokeCap: {
+                uint8_t cap;
+                if (_read(child, &cap)) shape->stroke(static_cast<StrokeCap>(cap));
+                break;
+            }
+            case TvgBinTag::StrokeJoin: {
+                uint8_t join;
+                if (_read(child, &join)) shape->stroke(static_cast<StrokeJoin>(join));
+                break;
+            }
+            case TvgBinTag::StrokeDash: {
+                uint32_t cnt;
+                if (!_read(child, &cnt)) break;
+                if (sizeof(cnt) + static_cast<uint64_t>(cnt) * sizeof(float) > child.size) break;
+                auto pattern = static_cast<float*>(malloc(sizeof(float) * cnt));
+                if (!pattern) break;
+                tvgBinCopy(pattern, child.data + sizeof(cnt), sizeof(float) * cnt, sizeof(float));
+                //the offset is left out when it's zero
+                auto offset = 0.0f;
+                auto size = sizeof(cnt) + sizeof(float) * cnt;
+                if (size + sizeof(offset) <= child.size) tvgBinCopy(&offset, child.data + size, sizeof(offset), sizeof(offset));
+                shape->stroke(pattern, cnt, offset);
+                free(pattern);
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+}
+
+
+static unique_ptr<Paint> _parseShape(const TvgBlock& block)
+{
+    auto shape = Shape::gen();
+    auto ptr = block.data;
+    auto end = block.data + block.size;
+    TvgBlock child;
+
+    while (_readBlock(&ptr, end, &child)) {
+        if (_parsePaintProperty(shape.get(), child)) continue;
+
+        switch (child.tag) {
+            case TvgBinTag::Path: {
+                _parsePath(shape.get(), child);
+                break;
+            }
+            case TvgBinTag::FillRule: {
+                uint8_t rule;
+                if (_read(child, &rule)) shape->fill(static_cast<FillRule>(rule));
+                break;
+            }
+            case TvgBinTag::Color: {
+                uint8_t color[4];
+                if (_read(child, &color)) shape->fill(color[0], color[1], color[2], color[3]);
+                break;
+            }
+            case TvgBinTag::Fill: {
+                auto fill = _parseFill(child);
+                if (fill) shape->fill(move(fill));
+                break;
+            }
+            case TvgBinTag::Stroke: {
+                _parseStroke(shape.get(), child);
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+    return shape;
+}
+
+
+//Scene and Picture: a Picture comes back as a Scene wrapping its resource.
+static unique_ptr<Paint> _parseScene(const TvgBlock& block)
+{
+    auto scene = Scene::gen();
+    auto ptr = block.data;
+    auto end = block.data + block.size;
+    TvgBlock child;
+
+    while (_readBlock(&ptr, end, &child)) {
+        if (_parsePaintProperty(scene.get(), child)) continue;
+
+        if (child.tag == TvgBinTag::RawImage) {
+            uint32_t size[2];   //w, h
+            if (!_read(child, &size)) continue;
+            if (sizeof(size) + static_cast<uint64_t>(size[0]) * size[1] * sizeof(uint32_t) > child.size) continue;
+            auto len = size[0] * size[1] * sizeof(uint32_t);
+            auto pixels = static_cast<uint32_t*>(malloc(len));
+            if (!pixels) continue;
+            tvgBinCopy(pixels, child.data + sizeof(size), len, sizeof(uint32_t));
+            auto picture = Picture::gen();
+            if (picture->load(pixels, size[0], size[1], true) == Result::Success) scene->push(move(picture));
+            free(pixels);
+            continue;
+        }
+
+        auto paint = _parsePaint(child);
+        if (paint) scene->push(move(paint));
+    }
+    return scene;
+}
+
+
+static unique_ptr<Paint> _parsePaint(const TvgBlock& block)
+{
+    switch (block.tag) {
+        case TvgBinTag::Shape: return _parseShape(block);
+        case TvgBinTag::Scene:
+        case TvgBinTag::Picture: return _parseScene(block);
+        default: return nullptr;
+    }
+}
+
+
+/************************************************************************/
+/* External Class Implementation                                        */
+/************************************************************************/
+
+TvgLoader::TvgLoader()
+{
+}
+
+
+TvgLoader::~TvgLoader()
+{
+    close();
+}
+
+
+bool TvgLoader::header()
+{
+    if (!content || size < TVG_BIN_HEADER_SIZE) return false;
+    if (memcmp(content, TVG_BIN_MAGIC, TVG_BIN_MAGIC_LEN)) return false;
+
+    uint16_t version;
+    tvgBinCopy(&version, content + TVG_BIN_MAGIC_LEN, sizeof(version), sizeof(version));
+    if (version > TVG_BIN_VERSION) {
+        //LOG: Unsupported format version
+        return false;
+    }
+
+    float viewbox[4];
+    tvgBinCopy(viewbox, content + TVG_BIN_MAGIC_LEN + sizeof(version), sizeof(viewbox), sizeof(float));
+    vx = viewbox[0];
+    vy = viewbox[1];
+    vw = viewbox[2];
+    vh = viewbox[3];
+
+    return true;
+}
+
+
+bool TvgLoader::open(const string& path)
+{
+    auto f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    fseek(f, 0, SEEK_END);
+    auto len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    if (len <= 0) {
+        fclose(f);
+        return false;
+    }
+
+    auto data = static_cast<char*>(malloc(len));
+    if (!data || fread(data, 1, len, f) != static_cast<size_t>(len)) {
+        free(data);
+        fclose(f);
+        return false;
+    }
+    fclose(f);
+
+    content = data;
+    size = len;
+    copy = true;
+
+    return header();
+}
+
+
+bool TvgLoader::open(const char* data, uint32_t size)
+{
+    this->content = data;
+    this->size = size;
+    this->copy = false;
+
+    return header();
+}
+
+
+bool TvgLoader::read()
+{
+    if (!content || size < TVG_BIN_HEADER_SIZE) return false;
+
+    //The binary is already resolved, building the scene is cheap enough to do it right away.
+    root = Scene::gen();
+
+    auto ptr = content + TVG_BIN_HEADER_SIZE;
+    auto end = content + size;
+    TvgBlock block;
+
+    while (_readBlock(&ptr, end, &block)) {
+        auto paint = _parsePaint(block);
+        if (paint) root->push(move(paint));
+    }
+
+    return true;
+}
+
+
+bool TvgLoader::close()
+{
+    if (copy && content) free(const_cast<char*>(content));
+    content = nullptr;
+    size = 0;
+    copy = false;
+
+    return true;
+}
+
+
+unique_ptr<Scene> TvgLoader::scene()
+{
+    if (root) return move(root);
+    return nullptr;
+}
@@ -26,3 +26,374 @@ TEST_F(CanvasTest, GenerateCanvas) {
     ASSERT_TRUE(swCanvas != nullptr);
 }
 
+
+TEST_F(CanvasTest, Viewport) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 64;
+    constexpr uint32_t TILE = 32;
+    uint32_t buffer[SIZE * SIZE];
+    uint32_t tiles[SIZE * SIZE];
+
+    auto scene = tvg::Scene::gen();
+
+    auto circle = tvg::Shape::gen();
+    circle->appendCircle(30, 34, 20, 24);
+    circle->fill(255, 0, 0, 255);
+    circle->stroke(4);
+    circle->stroke(0, 0, 255, 255);
+    scene->push(move(circle));
+
+    auto rect = tvg::Shape::gen();
+    rect->appendRect(20, 10, 30, 30, 5, 5);
+    rect->fill(0, 255, 0, 128);
+    auto clip = tvg::Shape::gen();
+    clip->appendCircle(40, 30, 15, 15);
+    rect->composite(move(clip), tvg::CompositeMethod::ClipPath);
+    scene->push(move(rect));
+
+    //Same scene drawn per tile
+    auto tile = tvg::SwCanvas::gen();
+    ASSERT_EQ(tile->target(tiles, SIZE, TILE, TILE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+    ASSERT_EQ(tile->push(std::unique_ptr<tvg::Paint>(scene->duplicate())), tvg::Result::Success);
+
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->viewport(0, 0, SIZE, SIZE), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->push(move(scene)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    for (uint32_t y = 0; y < SIZE; y += TILE) {
+        for (uint32_t x = 0; x < SIZE; x += TILE) {
+            ASSERT_EQ(tile->target(tiles + y * SIZE + x, SIZE, TILE, TILE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+            ASSERT_EQ(tile->viewport(x, y, TILE, TILE), tvg::Result::Success);
+            ASSERT_EQ(tile->draw(), tvg::Result::Success);
+            ASSERT_EQ(tile->sync(), tvg::Result::Success);
+        }
+    }
+
+    for (uint32_t i = 0; i < SIZE * SIZE; ++i) ASSERT_EQ(buffer[i], tiles[i]);
+
+    //Nothing out of the viewport is drawn
+    for (uint32_t i = 0; i < SIZE * SIZE; ++i) tiles[i] = 0x12345678;
+    ASSERT_EQ(tile->target(tiles, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+    ASSERT_EQ(tile->viewport(0, 0, TILE, TILE), tvg::Result::Success);
+    ASSERT_EQ(tile->draw(), tvg::Result::Success);
+    ASSERT_EQ(tile->sync(), tvg::Result::Success);
+    ASSERT_EQ(tiles[SIZE * SIZE - 1], 0x12345678u);
+    ASSERT_EQ(tiles[TILE * SIZE + TILE], 0x12345678u);
+    ASSERT_EQ(tiles[20 * SIZE + 20], buffer[20 * SIZE + 20]);
+}
+
+TEST_F(CanvasTest, AsyncDraw) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 32;
+    uint32_t buffer[2][SIZE * SIZE];
+
+    auto canvas = tvg::SwCanvas::gen();
+    tvg::SwCanvas* canvases[2] = {swCanvas.get(), canvas.get()};
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        ASSERT_EQ(canvases[i]->target(buffer[i], SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+        auto shape = tvg::Shape::gen();
+        shape->appendRect(0, 0, SIZE, SIZE, 0, 0);
+        shape->fill(0, 0, 255 * i, 255);
+        ASSERT_EQ(canvases[i]->push(move(shape)), tvg::Result::Success);
+    }
+
+    //Both are drawn before joining
+    for (auto canvas : canvases) ASSERT_EQ(canvas->draw(), tvg::Result::Success);
+    for (auto canvas : canvases) ASSERT_EQ(canvas->sync(), tvg::Result::Success);
+
+    ASSERT_EQ(buffer[0][SIZE * SIZE / 2], 0xff000000u);
+    ASSERT_EQ(buffer[1][SIZE * SIZE / 2], 0xff0000feu);
+
+    //Changes join the drawing in progress
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->clear(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+}
+
+TEST_F(CanvasTest, PushDuringDraw) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 64;
+    uint32_t buffer[SIZE * SIZE];
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    //Paints pushed while the previous drawing is in progress grow the list it walks through.
+    for (uint32_t i = 0; i < SIZE; ++i) {
+        ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+        auto shape = tvg::Shape::gen();
+        shape->appendRect(i, 0, 1, SIZE, 0, 0);
+        shape->fill(0, 0, 255, 255);
+        ASSERT_EQ(swCanvas->push(move(shape)), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->reserve(i + 2), tvg::Result::Success);
+    }
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    for (uint32_t i = 0; i < SIZE; ++i) ASSERT_EQ(buffer[SIZE * SIZE / 2 + i], 0xff0000feu);
+}
+
+TEST_F(CanvasTest, MultiBuffer) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 32;
+    uint32_t buffer[3][SIZE * SIZE];
+    uint32_t* buffers[3] = {buffer[0], buffer[1], buffer[2]};
+
+    ASSERT_EQ(swCanvas->target(buffers, 0, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::InvalidArguments);
+    ASSERT_EQ(swCanvas->target(buffers, 3, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    auto shape = tvg::Shape::gen();
+    auto pShape = shape.get();
+    ASSERT_EQ(swCanvas->push(move(shape)), tvg::Result::Success);
+
+    //Each frame keeps its own shape while the next one is updated
+    for (uint32_t i = 0; i < 3; ++i) {
+        ASSERT_EQ(pShape->reset(), tvg::Result::Success);
+        ASSERT_EQ(pShape->appendRect(i * 8, 0, 8, SIZE, 0, 0), tvg::Result::Success);
+        ASSERT_EQ(pShape->fill(255, 0, 0, 255), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->update(pShape), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    }
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    for (uint32_t i = 0; i < 3; ++i) {
+        for (uint32_t x = 0; x < SIZE; x += 4) {
+            auto inside = (x >= i * 8 && x < i * 8 + 8);
+            ASSERT_EQ(buffer[i][SIZE * 16 + x], inside ? 0xfffe0000u : 0x00000000u);
+        }
+    }
+}
+
+TEST_F(CanvasTest, MultiBufferAborted) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 32;
+    uint32_t buffer[2][SIZE * SIZE];
+    uint32_t* buffers[2] = {buffer[0], buffer[1]};
+
+    ASSERT_EQ(swCanvas->target(buffers, 2, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    auto shape = tvg::Shape::gen();
+    auto pShape = shape.get();
+    ASSERT_EQ(swCanvas->push(move(shape)), tvg::Result::Success);
+
+    auto scene = tvg::Scene::gen();
+    auto pScene = scene.get();
+    auto inner = tvg::Shape::gen();
+    ASSERT_EQ(inner->appendRect(0, 24, SIZE, 8, 0, 0), tvg::Result::Success);
+    ASSERT_EQ(inner->fill(0, 0, 255, 255), tvg::Result::Success);
+    ASSERT_EQ(scene->push(move(inner)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->push(move(scene)), tvg::Result::Success);
+
+    //Every other frame needs a layer for the translucent scene, its recording is dropped
+    for (uint32_t i = 0; i < 8; ++i) {
+        ASSERT_EQ(pShape->reset(), tvg::Result::Success);
+        ASSERT_EQ(pShape->appendRect(i * 4, 0, 4, 16, 0, 0), tvg::Result::Success);
+        ASSERT_EQ(pShape->fill(255, 0, 0, 255), tvg::Result::Success);
+        ASSERT_EQ(pScene->opacity(i % 2 ? 255 : 128), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->update(nullptr), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    }
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    //Frames are drawn to the buffers in turn, recorded or not
+    for (uint32_t i = 6; i < 8; ++i) {
+        for (uint32_t x = 0; x < SIZE; x += 2) {
+            auto inside = (x >= i * 4 && x < i * 4 + 4);
+            ASSERT_EQ(buffer[i % 2][SIZE * 8 + x], inside ? 0xfffe0000u : 0x00000000u);
+        }
+        ASSERT_EQ(buffer[i % 2][SIZE * 28] >> 24, i % 2 ? 0xffu : 0x80u);
+    }
+
+    ASSERT_EQ(swCanvas->clear(), tvg::Result::Success);
+}
+
+TEST_F(CanvasTest, Colorspaces) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 32;
+    uint32_t ref[SIZE * SIZE];
+    uint32_t buffer[SIZE * SIZE];
+
+    ASSERT_EQ(swCanvas->target(ref, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    auto rect = tvg::Shape::gen();
+    rect->appendRect(2, 2, 20, 20, 0, 0);
+    rect->fill(255, 0, 0, 255);
+    ASSERT_EQ(swCanvas->push(move(rect)), tvg::Result::Success);
+
+    //The translucent scene is blended to the target as a layer
+    auto scene = tvg::Scene::gen();
+    auto circle = tvg::Shape::gen();
+    circle->appendCircle(20, 20, 10, 10);
+    circle->fill(0, 0, 255, 255);
+    scene->push(move(circle));
+    scene->opacity(128);
+    ASSERT_EQ(swCanvas->push(move(scene)), tvg::Result::Success);
+
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    auto channel = [](uint32_t c, uint32_t shift) -> int32_t { return (c >> shift) & 0xff; };
+
+    //The same pixels in the other layouts
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::BGRA8888), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    for (uint32_t i = 0; i < SIZE * SIZE; ++i) ASSERT_EQ(buffer[i], (ref[i] << 8) | (ref[i] >> 24));
+
+    auto a8 = reinterpret_cast<uint8_t*>(buffer);
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::A8), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    for (uint32_t i = 0; i < SIZE * SIZE; ++i) ASSERT_EQ(a8[i], ref[i] >> 24);
+
+    //The straight colors are off by the rounding of the premultiplication at most
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::ABGR8888S), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    for (uint32_t i = 0; i < SIZE * SIZE; ++i) {
+        auto a = channel(ref[i], 24);
+        ASSERT_EQ(channel(buffer[i], 24), a);
+        if (a == 0) continue;
+        ASSERT_LE(abs(channel(buffer[i], 0) - channel(ref[i], 16) * 255 / a), 2);
+        ASSERT_LE(abs(channel(buffer[i], 8) - channel(ref[i], 8) * 255 / a), 2);
+        ASSERT_LE(abs(channel(buffer[i], 16) - channel(ref[i], 0) * 255 / a), 2);
+    }
+
+    auto rgb565 = reinterpret_cast<uint16_t*>(buffer);
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::RGB565), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    for (uint32_t i = 0; i < SIZE * SIZE; ++i) {
+        ASSERT_LE(abs(((rgb565[i] >> 11) << 3) - channel(ref[i], 16)), 8);
+        ASSERT_LE(abs((((rgb565[i] >> 5) & 0x3f) << 2) - channel(ref[i], 8)), 4);
+        ASSERT_LE(abs(((rgb565[i] & 0x1f) << 3) - channel(ref[i], 0)), 8);
+    }
+    ASSERT_EQ(rgb565[SIZE * 4 + 4], 0xf800);
+}
+
+TEST_F(CanvasTest, Coverage) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 32;
+    uint8_t buffer[SIZE * SIZE];
+
+    ASSERT_EQ(swCanvas->target(reinterpret_cast<uint32_t*>(buffer), SIZE, SIZE, SIZE, tvg::SwCanvas::A8), tvg::Result::Success);
+
+    //Rects and spans overlapping each other
+    auto rect = tvg::Shape::gen();
+    rect->appendRect(0, 0, 16, 32, 0, 0);
+    rect->fill(255, 0, 0, 100);
+    ASSERT_EQ(swCanvas->push(move(rect)), tvg::Result::Success);
+
+    auto rect2 = tvg::Shape::gen();
+    rect2->appendRect(8, 0, 16, 32, 0, 0);
+    rect2->fill(0, 255, 0, 60);
+    ASSERT_EQ(swCanvas->push(move(rect2)), tvg::Result::Success);
+
+    auto circle = tvg::Shape::gen();
+    circle->appendCircle(16, 16, 8, 8);
+    circle->fill(0, 0, 255, 200);
+    ASSERT_EQ(swCanvas->push(move(circle)), tvg::Result::Success);
+
+    ASSERT_EQ(swCanvas->coverage(tvg::SwCanvas::Max), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(buffer[2 * SIZE + 4], 100);
+    ASSERT_EQ(buffer[2 * SIZE + 12], 100);
+    ASSERT_EQ(buffer[2 * SIZE + 20], 60);
+    ASSERT_EQ(buffer[16 * SIZE + 16], 200);
+    ASSERT_EQ(buffer[2 * SIZE + 28], 0);
+
+    ASSERT_EQ(swCanvas->coverage(tvg::SwCanvas::Add), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(buffer[2 * SIZE + 4], 100);
+    ASSERT_EQ(buffer[2 * SIZE + 12], 160);
+    ASSERT_EQ(buffer[2 * SIZE + 20], 60);
+    ASSERT_EQ(buffer[16 * SIZE + 12], 255);
+    ASSERT_EQ(buffer[16 * SIZE + 20], 255);
+
+    //Blended over as the other colorspaces do
+    ASSERT_EQ(swCanvas->coverage(tvg::SwCanvas::Over), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(buffer[2 * SIZE + 12], 60 + ((100 * (255 - 60)) >> 8));
+
+    ASSERT_EQ(swCanvas->coverage(static_cast<tvg::SwCanvas::Coverage>(3)), tvg::Result::InvalidArguments);
+}
+
+TEST_F(CanvasTest, CoverageGradient) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 32;
+    uint8_t buffer[SIZE * SIZE];
+
+    ASSERT_EQ(swCanvas->target(reinterpret_cast<uint32_t*>(buffer), SIZE, SIZE, SIZE, tvg::SwCanvas::A8), tvg::Result::Success);
+
+    //The alpha goes up from the left to the right
+    tvg::Fill::ColorStop stops[2] = {{0, 255, 255, 255, 0}, {1, 255, 255, 255, 255}};
+    auto fill = tvg::LinearGradient::gen();
+    fill->linear(0, 0, SIZE, 0);
+    fill->colorStops(stops, 2);
+
+    auto rect = tvg::Shape::gen();
+    rect->appendRect(0, 0, SIZE, SIZE / 2, 0, 0);
+    rect->fill(move(fill));
+    ASSERT_EQ(swCanvas->push(move(rect)), tvg::Result::Success);
+
+    auto rect2 = tvg::Shape::gen();
+    rect2->appendRect(0, 0, SIZE, SIZE, 0, 0);
+    rect2->fill(0, 0, 0, 50);
+    ASSERT_EQ(swCanvas->push(move(rect2)), tvg::Result::Success);
+
+    uint8_t grad[SIZE];
+    ASSERT_EQ(swCanvas->coverage(tvg::SwCanvas::Max), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    for (uint32_t x = 0; x < SIZE; ++x) {
+        grad[x] = buffer[2 * SIZE + x];
+        if (x > 0) {
+            ASSERT_GE(grad[x], grad[x - 1]);
+        }
+        ASSERT_EQ(buffer[24 * SIZE + x], 50);
+    }
+    ASSERT_EQ(grad[0], 50);
+    ASSERT_NEAR(grad[SIZE / 2], 128, 8);
+    ASSERT_GT(grad[SIZE - 1], 240);
+
+    ASSERT_EQ(swCanvas->coverage(tvg::SwCanvas::Add), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_NEAR(buffer[2 * SIZE + SIZE / 4], 64 + 50, 8);
+    ASSERT_EQ(buffer[2 * SIZE + SIZE - 1], 255);
+
+    //A radial gradient without the radius draws nothing as it does over the others.
+    ASSERT_EQ(swCanvas->clear(), tvg::Result::Success);
+    for (auto method : {tvg::SwCanvas::Over, tvg::SwCanvas::Max, tvg::SwCanvas::Add}) {
+        for (auto opaque : {true, false}) {
+            tvg::Fill::ColorStop stops2[2] = {{0, 255, 255, 255, 255}, {1, 255, 255, 255, static_cast<uint8_t>(opaque ? 255 : 100)}};
+            auto radial = tvg::RadialGradient::gen();
+            radial->radial(SIZE / 2, SIZE / 2, 0);
+            radial->colorStops(stops2, 2);
+
+            auto circle = tvg::Shape::gen();
+            circle->appendCircle(SIZE / 2, SIZE / 2, 8, 8);
+            circle->fill(move(radial));
+            ASSERT_EQ(swCanvas->push(move(circle)), tvg::Result::Success);
+
+            ASSERT_EQ(swCanvas->coverage(method), tvg::Result::Success);
+            ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+            ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+            ASSERT_EQ(swCanvas->clear(), tvg::Result::Success);
+            for (uint32_t i = 0; i < SIZE * SIZE; ++i) ASSERT_EQ(buffer[i], 0) << method << ", " << i;
+        }
+    }
+}
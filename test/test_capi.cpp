@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <thorvg_capi.h>
+
+class CapiTest : public ::testing::Test {
+public:
+    void SetUp() {
+        //Initialize ThorVG Engine
+        ASSERT_EQ(tvg_engine_init(TVG_ENGINE_SW, 0), TVG_RESULT_SUCCESS);
+
+        shape = tvg_shape_new();
+        scene = tvg_scene_new();
+        picture = tvg_picture_new();
+    }
+    void TearDown() {
+        tvg_paint_del(shape);
+        tvg_paint_del(scene);
+        tvg_paint_del(picture);
+
+        //Terminate ThorVG Engine
+        tvg_engine_term(TVG_ENGINE_SW);
+    }
+public:
+    Tvg_Paint* shape = nullptr;
+    Tvg_Paint* scene = nullptr;
+    Tvg_Paint* picture = nullptr;
+};
+
+TEST_F(CapiTest, ApplyMixedPaints) {
+    Tvg_Paint* paints[3] = {shape, scene, picture};
+
+    Tvg_Command cmds[5] = {
+        {TVG_COMMAND_SHAPE_APPEND_RECT, 0},
+        {TVG_COMMAND_SHAPE_SET_FILL_COLOR, 0},
+        {TVG_COMMAND_PAINT_SET_OPACITY, 1},
+        {TVG_COMMAND_PAINT_TRANSLATE, 2},
+        {TVG_COMMAND_PAINT_SET_OPACITY, 2}
+    };
+    float args[14] = {0, 0, 10, 20, 0, 0, 255, 128, 0, 255, 100, 5, 5, 50};
+
+    //Short of the arguments
+    ASSERT_EQ(tvg_paint_apply(paints, 3, cmds, 5, args, 13), TVG_RESULT_INVALID_ARGUMENT);
+    ASSERT_EQ(tvg_paint_apply(paints, 3, cmds, 5, args, 14), TVG_RESULT_SUCCESS);
+
+    const Tvg_Point* pts = nullptr;
+    uint32_t cnt = 0;
+    ASSERT_EQ(tvg_shape_get_path_coords(shape, &pts, &cnt), TVG_RESULT_SUCCESS);
+    ASSERT_EQ(cnt, 4u);
+    ASSERT_EQ(pts[2].x, 10.0f);
+    ASSERT_EQ(pts[2].y, 20.0f);
+
+    uint8_t r, g, b, a;
+    ASSERT_EQ(tvg_shape_get_fill_color(shape, &r, &g, &b, &a), TVG_RESULT_SUCCESS);
+    ASSERT_EQ(r, 255);
+    ASSERT_EQ(g, 128);
+    ASSERT_EQ(b, 0);
+    ASSERT_EQ(a, 255);
+
+    uint8_t opacity;
+    ASSERT_EQ(tvg_paint_get_opacity(scene, &opacity), TVG_RESULT_SUCCESS);
+    ASSERT_EQ(opacity, 100);
+    ASSERT_EQ(tvg_paint_get_opacity(picture, &opacity), TVG_RESULT_SUCCESS);
+    ASSERT_EQ(opacity, 50);
+}
+
+TEST_F(CapiTest, ApplyWrongTarget) {
+    Tvg_Paint* paints[3] = {shape, scene, picture};
+    float args[5] = {10, 0, 0, 0, 255};
+
+    //The shape commands need a shape, nothing is applied then
+    for (uint32_t target = 1; target < 3; ++target) {
+        Tvg_Command cmds[2] = {{TVG_COMMAND_PAINT_SET_OPACITY, 0}, {TVG_COMMAND_SHAPE_SET_FILL_COLOR, target}};
+        ASSERT_EQ(tvg_paint_apply(paints, 3, cmds, 2, args, 5), TVG_RESULT_INVALID_ARGUMENT);
+
+        uint8_t opacity;
+        ASSERT_EQ(tvg_paint_get_opacity(shape, &opacity), TVG_RESULT_SUCCESS);
+        ASSERT_EQ(opacity, 255);
+    }
+
+    //Out of the paints
+    Tvg_Command cmd = {TVG_COMMAND_PAINT_SET_OPACITY, 3};
+    ASSERT_EQ(tvg_paint_apply(paints, 3, &cmd, 1, args, 1), TVG_RESULT_INVALID_ARGUMENT);
+
+    //The paint commands take any of them
+    for (uint32_t target = 0; target < 3; ++target) {
+        cmd.paint = target;
+        ASSERT_EQ(tvg_paint_apply(paints, 3, &cmd, 1, args, 1), TVG_RESULT_SUCCESS);
+    }
+}
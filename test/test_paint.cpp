@@ -54,3 +54,627 @@ TEST_F(PaintTest, SceneBounds) {
     ASSERT_EQ(h, 200.0);
 }
 
+
+TEST_F(PaintTest, SceneOpacity) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 64;
+    uint32_t buffer[SIZE * SIZE];
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    //Two overlapping rects faded together
+    auto rect1 = tvg::Shape::gen();
+    rect1->appendRect(0, 0, 40, 40, 0, 0);
+    rect1->fill(255, 0, 0, 255);
+    auto rect2 = tvg::Shape::gen();
+    rect2->appendRect(20, 20, 40, 40, 0, 0);
+    rect2->fill(0, 0, 255, 255);
+    auto r2 = rect2.get();
+
+    scene->push(move(rect1));
+    scene->push(move(rect2));
+    scene->opacity(128);
+    auto s = scene.get();
+    ASSERT_EQ(swCanvas->push(move(scene)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    //The overlap shows the top one only.
+    ASSERT_EQ(buffer[30 * SIZE + 30], buffer[50 * SIZE + 50]);
+    ASSERT_EQ(buffer[30 * SIZE + 30] >> 24, 0x7fu);
+    ASSERT_EQ(buffer[30 * SIZE + 30] & 0x00ff0000, 0u);
+    ASSERT_EQ(buffer[10 * SIZE + 10] >> 24, 0x7fu);
+    ASSERT_EQ(buffer[10 * SIZE + 50], 0u);
+
+    //The cached layer is drawn again, then a change of a child invalidates it.
+    ASSERT_EQ(swCanvas->update(s), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(buffer[50 * SIZE + 50] & 0x000000ff, 0x7fu);
+
+    ASSERT_EQ(r2->fill(0, 255, 0, 255), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->update(s), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(buffer[50 * SIZE + 50] & 0x000000ff, 0u);
+    ASSERT_EQ(buffer[50 * SIZE + 50] & 0x0000ff00, 0x7f00u);
+
+    //Opaque again, no layer
+    ASSERT_EQ(s->opacity(255), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->update(s), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(buffer[30 * SIZE + 30], 0xff00fe00);
+    ASSERT_EQ(buffer[10 * SIZE + 10], 0xfffe0000);
+}
+
+TEST_F(PaintTest, AlphaMask) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 64;
+    uint32_t buffer[SIZE * SIZE];
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    auto draw = [&](tvg::CompositeMethod method) {
+        auto rect = tvg::Shape::gen();
+        rect->appendRect(0, 0, 64, 64, 0, 0);
+        rect->fill(0, 0, 255, 255);
+
+        //Opaque left, translucent right
+        auto mask = tvg::Shape::gen();
+        mask->appendRect(8, 8, 24, 48, 0, 0);
+        mask->fill(255, 255, 255, 255);
+        auto half = tvg::Shape::gen();
+        half->appendRect(32, 8, 24, 48, 0, 0);
+        half->fill(255, 255, 255, 128);
+        auto masks = tvg::Scene::gen();
+        masks->push(move(mask));
+        masks->push(move(half));
+
+        rect->composite(move(masks), method);
+        swCanvas->push(move(rect));
+        swCanvas->draw();
+        swCanvas->sync();
+        swCanvas->clear();
+    };
+
+    draw(tvg::CompositeMethod::AlphaMask);
+    ASSERT_EQ(buffer[0], 0u);
+    ASSERT_EQ(buffer[20 * SIZE + 20], 0xff0000feu);
+    ASSERT_EQ(buffer[20 * SIZE + 40] >> 24, 0x7fu);
+
+    draw(tvg::CompositeMethod::InvAlphaMask);
+    ASSERT_EQ(buffer[0], 0xff0000feu);
+    ASSERT_EQ(buffer[20 * SIZE + 20], 0u);
+    ASSERT_EQ(buffer[20 * SIZE + 40] >> 24, 0x7eu);
+}
+
+TEST_F(PaintTest, CacheHint) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 64;
+    uint32_t buffer[SIZE * SIZE];
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    auto rect = tvg::Shape::gen();
+    rect->appendRect(8, 8, 16, 16, 0, 0);
+    rect->fill(255, 0, 0, 255);
+    auto r = rect.get();
+    scene->push(move(rect));
+
+    ASSERT_FALSE(scene->cache());
+    ASSERT_EQ(scene->cache(true), tvg::Result::Success);
+    ASSERT_TRUE(scene->cache());
+
+    auto s = scene.get();
+    ASSERT_EQ(swCanvas->push(move(scene)), tvg::Result::Success);
+
+    auto draw = [&]() {
+        ASSERT_EQ(swCanvas->update(s), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    };
+
+    draw();
+    ASSERT_EQ(buffer[10 * SIZE + 10], 0xfffe0000);
+    ASSERT_EQ(buffer[30 * SIZE + 30], 0u);
+
+    //Moved drawing
+    ASSERT_EQ(s->translate(20, 20), tvg::Result::Success);
+    draw();
+    ASSERT_EQ(buffer[10 * SIZE + 10], 0u);
+    ASSERT_EQ(buffer[30 * SIZE + 30], 0xfffe0000);
+
+    //Faded drawing
+    ASSERT_EQ(s->opacity(128), tvg::Result::Success);
+    draw();
+    ASSERT_EQ(buffer[30 * SIZE + 30] >> 24, 0x7fu);
+
+    //A change of a child draws it again.
+    ASSERT_EQ(r->fill(0, 0, 255, 255), tvg::Result::Success);
+    ASSERT_EQ(s->opacity(255), tvg::Result::Success);
+    draw();
+    ASSERT_EQ(buffer[30 * SIZE + 30], 0xff0000feu);
+
+    //Without the budget, the paint is drawn every time.
+    ASSERT_EQ(tvg::SwCanvas::cacheBudget(0), tvg::Result::Success);
+    ASSERT_EQ(s->translate(0, 0), tvg::Result::Success);
+    draw();
+    draw();
+    ASSERT_EQ(buffer[10 * SIZE + 10], 0xff0000feu);
+    ASSERT_EQ(buffer[30 * SIZE + 30], 0u);
+    ASSERT_EQ(tvg::SwCanvas::cacheBudget(32 * 1024 * 1024), tvg::Result::Success);
+
+    ASSERT_EQ(s->cache(false), tvg::Result::Success);
+    draw();
+    ASSERT_EQ(buffer[10 * SIZE + 10], 0xff0000feu);
+}
+
+TEST_F(PaintTest, CacheShared) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 32;
+    uint32_t buffers[2][SIZE * SIZE];
+    uint32_t expected[SIZE * SIZE];
+    std::unique_ptr<tvg::SwCanvas> canvases[2] = {tvg::SwCanvas::gen(), tvg::SwCanvas::gen()};
+    tvg::Scene* scenes[2];
+
+    auto circle = []() {
+        auto shape = tvg::Shape::gen();
+        shape->appendCircle(16, 16, 8, 8);
+        shape->fill(255, 0, 0, 255);
+        return shape;
+    };
+
+    for (int i = 0; i < 2; ++i) {
+        ASSERT_EQ(canvases[i]->target(buffers[i], SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+        auto scene = tvg::Scene::gen();
+        scene->push(circle());
+        scene->cache(true);
+        scenes[i] = scene.get();
+        ASSERT_EQ(canvases[i]->push(move(scene)), tvg::Result::Success);
+    }
+
+    auto draw = [&](int i) {
+        ASSERT_EQ(canvases[i]->update(scenes[i]), tvg::Result::Success);
+        ASSERT_EQ(canvases[i]->draw(), tvg::Result::Success);
+        ASSERT_EQ(canvases[i]->sync(), tvg::Result::Success);
+    };
+
+    //The circle drawn directly at the given offset.
+    auto reference = [&](float x) {
+        ASSERT_EQ(swCanvas->target(expected, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+        auto shape = circle();
+        shape->translate(x, 0);
+        ASSERT_EQ(swCanvas->push(move(shape)), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->clear(), tvg::Result::Success);
+    };
+
+    //Whether the buffer is the expected one moved by a pixel to the right.
+    auto moved = [&](const uint32_t* buffer) {
+        for (uint32_t y = 0; y < SIZE; ++y) {
+            if (buffer[y * SIZE] != 0) return false;
+            for (uint32_t x = 1; x < SIZE; ++x) {
+                if (buffer[y * SIZE + x] != expected[y * SIZE + x - 1]) return false;
+            }
+        }
+        return true;
+    };
+
+    //A 16x16 drawing fits in the budget, two of them don't.
+    ASSERT_EQ(tvg::SwCanvas::cacheBudget(1500), tvg::Result::Success);
+    reference(0);
+
+    //A kept drawing moves by the whole pixels.
+    draw(0);
+    ASSERT_EQ(memcmp(buffers[0], expected, sizeof(expected)), 0);
+    ASSERT_EQ(scenes[0]->translate(0.5f, 0), tvg::Result::Success);
+    draw(0);
+    ASSERT_TRUE(moved(buffers[0]));
+
+    //The second canvas drops the drawing of the first one, the least recently used.
+    draw(1);
+    ASSERT_EQ(scenes[0]->translate(1.5f, 0), tvg::Result::Success);
+    draw(0);
+    uint32_t redrawn[SIZE * SIZE];
+    memcpy(redrawn, buffers[0], sizeof(redrawn));
+    reference(1.5f);
+    ASSERT_EQ(memcmp(redrawn, expected, sizeof(expected)), 0);
+
+    //The new drawing of the first one is too large to be kept, it doesn't drop the second one.
+    reference(0);
+    ASSERT_EQ(scenes[1]->translate(0.5f, 0), tvg::Result::Success);
+    draw(1);
+    ASSERT_TRUE(moved(buffers[1]));
+
+    ASSERT_EQ(tvg::SwCanvas::cacheBudget(32 * 1024 * 1024), tvg::Result::Success);
+}
+
+TEST_F(PaintTest, ClipPath) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 64;
+    uint32_t buffer[SIZE * SIZE];
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    //Rect clipped by a rect, then by a circle
+    auto rect = tvg::Shape::gen();
+    rect->appendRect(0, 0, 64, 64, 0, 0);
+    rect->fill(0, 0, 255, 255);
+
+    auto clip = tvg::Shape::gen();
+    clip->appendRect(16, 16, 32, 32, 0, 0);
+    clip->fill(255, 255, 255, 255);
+    rect->composite(move(clip), tvg::CompositeMethod::ClipPath);
+
+    scene->push(move(rect));
+
+    auto circle = tvg::Shape::gen();
+    circle->appendCircle(32, 32, 12, 12);
+    circle->fill(255, 255, 255, 255);
+    scene->composite(move(circle), tvg::CompositeMethod::ClipPath);
+
+    ASSERT_EQ(swCanvas->push(move(scene)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    ASSERT_EQ(buffer[32 * SIZE + 32], 0xff0000feu);
+    ASSERT_EQ(buffer[17 * SIZE + 17], 0u);
+    ASSERT_EQ(buffer[8 * SIZE + 8], 0u);
+    ASSERT_EQ(buffer[32 * SIZE + 50], 0u);
+
+    //Drawn again with the same spans
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(buffer[32 * SIZE + 32], 0xff0000feu);
+    ASSERT_EQ(buffer[17 * SIZE + 17], 0u);
+}
+
+TEST_F(PaintTest, SharedGradient) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 64;
+    uint32_t buffer[SIZE * SIZE];
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    tvg::Fill::ColorStop stops[2] = {{0, 255, 0, 0, 255}, {1, 255, 0, 0, 255}};
+
+    //Fills of the same stops take one color table
+    tvg::Shape* shapes[2];
+    for (uint32_t i = 0; i < 2; ++i) {
+        auto shape = tvg::Shape::gen();
+        shape->appendRect(i * 32, 0, 32, 32, 0, 0);
+        auto fill = tvg::LinearGradient::gen();
+        fill->linear(i * 32, 0, i * 32 + 32, 0);
+        fill->colorStops(stops, 2);
+        shape->fill(move(fill));
+        shapes[i] = shape.get();
+        ASSERT_EQ(swCanvas->push(move(shape)), tvg::Result::Success);
+    }
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(buffer[16 * SIZE + 16], 0xfffe0000u);
+    ASSERT_EQ(buffer[16 * SIZE + 48], 0xfffe0000u);
+
+    //A change of one leaves the other
+    stops[0] = {0, 0, 0, 255, 255};
+    stops[1] = {1, 0, 0, 255, 255};
+    auto fill = tvg::LinearGradient::gen();
+    fill->linear(0, 0, 32, 0);
+    fill->colorStops(stops, 2);
+    ASSERT_EQ(shapes[0]->fill(move(fill)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->update(shapes[0]), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(buffer[16 * SIZE + 16], 0xff0000feu);
+    ASSERT_EQ(buffer[16 * SIZE + 48], 0xfffe0000u);
+}
+
+TEST_F(PaintTest, FocalGradient) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 64;
+    uint32_t buffer[SIZE * SIZE];
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    auto fill = tvg::RadialGradient::gen();
+    ASSERT_EQ(fill->radial(32, 32, 30), tvg::Result::Success);
+
+    //The center by default
+    float fx, fy;
+    ASSERT_EQ(fill->focal(&fx, &fy), tvg::Result::Success);
+    ASSERT_EQ(fx, 32.0f);
+    ASSERT_EQ(fy, 32.0f);
+
+    ASSERT_EQ(fill->focal(16.5f, 32.5f), tvg::Result::Success);
+    tvg::Fill::ColorStop stops[2] = {{0, 0, 0, 0, 255}, {1, 255, 255, 255, 255}};
+    ASSERT_EQ(fill->colorStops(stops, 2), tvg::Result::Success);
+
+    shape->appendRect(0, 0, SIZE, SIZE, 0, 0);
+    ASSERT_EQ(shape->fill(move(fill)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->push(move(shape)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    //Dark at the focal point, the gradient is squeezed toward the near side of the circle.
+    ASSERT_LT(buffer[32 * SIZE + 16] & 0xff, 8u);
+    auto near = buffer[32 * SIZE + 8] & 0xff;
+    auto far = buffer[32 * SIZE + 40] & 0xff;
+    ASSERT_GT(near, far);
+}
+
+TEST_F(PaintTest, MovedStroke) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 64;
+    uint32_t buffer[SIZE * SIZE];
+    uint32_t expected[SIZE * SIZE];
+
+    auto stroked = [](tvg::Shape* shape, float x, float y) {
+        shape->appendCircle(0, 0, 16, 12);
+        shape->stroke(5);
+        shape->stroke(255, 0, 0, 255);
+        shape->stroke(tvg::StrokeJoin::Round);
+        shape->translate(x, y);
+    };
+
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+    auto shape = tvg::Shape::gen();
+    auto pShape = shape.get();
+    stroked(pShape, 20, 20);
+    ASSERT_EQ(swCanvas->push(move(shape)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    //The moved stroke matches the one stroked there
+    ASSERT_EQ(pShape->translate(37.25f, 41.5f), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->update(pShape), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    auto canvas = tvg::SwCanvas::gen();
+    ASSERT_EQ(canvas->target(expected, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+    auto shape2 = tvg::Shape::gen();
+    stroked(shape2.get(), 37.25f, 41.5f);
+    ASSERT_EQ(canvas->push(move(shape2)), tvg::Result::Success);
+    ASSERT_EQ(canvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(canvas->sync(), tvg::Result::Success);
+
+    ASSERT_EQ(memcmp(buffer, expected, sizeof(buffer)), 0);
+    ASSERT_NE(buffer[41 * SIZE + 37 + 16], 0u);
+}
+
+
+TEST_F(PaintTest, StrokeFillRule) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 64;
+    uint32_t buffer[SIZE * SIZE];
+    uint32_t expected[SIZE * SIZE];
+
+    //A self-intersecting pentagram, only stroked.
+    auto pentagram = [](tvg::Shape* shape, tvg::FillRule rule, float x) {
+        shape->moveTo(24, 2);
+        shape->lineTo(37, 42);
+        shape->lineTo(3, 17);
+        shape->lineTo(45, 17);
+        shape->lineTo(11, 42);
+        shape->close();
+        shape->fill(rule);
+        shape->stroke(10);
+        shape->stroke(255, 0, 0, 255);
+        shape->translate(x, 8);
+    };
+
+    auto draw = [&](uint32_t* target, tvg::FillRule rule) {
+        ASSERT_EQ(swCanvas->target(target, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+        auto shape = tvg::Shape::gen();
+        auto pShape = shape.get();
+        pentagram(pShape, rule, 6);
+        ASSERT_EQ(swCanvas->push(move(shape)), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+        //The moved stroke too
+        ASSERT_EQ(pShape->translate(8, 8), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->update(pShape), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->clear(), tvg::Result::Success);
+    };
+
+    //The stroke covers its crossings whatever the fill rule of the shape is.
+    draw(expected, tvg::FillRule::Winding);
+    draw(buffer, tvg::FillRule::EvenOdd);
+    ASSERT_EQ(memcmp(buffer, expected, sizeof(buffer)), 0);
+    ASSERT_EQ(buffer[(8 + 17) * SIZE + 8 + 19] >> 24, 0xffu);
+}
+
+
+TEST_F(PaintTest, Hairline) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 64;
+    uint32_t buffer[SIZE * SIZE];
+    memset(buffer, 0, sizeof(buffer));
+
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    //One pixel wide, fills the row
+    auto shape = tvg::Shape::gen();
+    ASSERT_EQ(shape->moveTo(8, 10.5f), tvg::Result::Success);
+    ASSERT_EQ(shape->lineTo(56, 10.5f), tvg::Result::Success);
+    ASSERT_EQ(shape->stroke(1), tvg::Result::Success);
+    ASSERT_EQ(shape->stroke(255, 255, 255, 255), tvg::Result::Success);
+    ASSERT_EQ(shape->stroke(tvg::StrokeCap::Butt), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->push(move(shape)), tvg::Result::Success);
+
+    //Half pixel wide, covers the column half
+    shape = tvg::Shape::gen();
+    ASSERT_EQ(shape->moveTo(20.5f, 20), tvg::Result::Success);
+    ASSERT_EQ(shape->lineTo(20.5f, 50), tvg::Result::Success);
+    ASSERT_EQ(shape->stroke(0.5f), tvg::Result::Success);
+    ASSERT_EQ(shape->stroke(255, 255, 255, 255), tvg::Result::Success);
+    ASSERT_EQ(shape->stroke(tvg::StrokeCap::Round), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->push(move(shape)), tvg::Result::Success);
+
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    for (uint32_t x = 8; x < 56; ++x) {
+        ASSERT_GE(buffer[10 * SIZE + x] >> 24, 0xfeu);
+        ASSERT_EQ(buffer[9 * SIZE + x], 0u);
+        ASSERT_EQ(buffer[11 * SIZE + x], 0u);
+    }
+    ASSERT_EQ(buffer[10 * SIZE + 7], 0u);
+    ASSERT_EQ(buffer[10 * SIZE + 56], 0u);
+
+    //round caps reach a fifth of a pixel on the ends
+    for (uint32_t y = 20; y < 50; ++y) {
+        auto alpha = buffer[y * SIZE + 20] >> 24;
+        ASSERT_GT(alpha, 0x70u);
+        ASSERT_LT(alpha, 0x90u);
+    }
+    ASSERT_NE(buffer[19 * SIZE + 20], 0u);
+    ASSERT_NE(buffer[50 * SIZE + 20], 0u);
+    ASSERT_EQ(buffer[18 * SIZE + 20], 0u);
+    ASSERT_EQ(buffer[51 * SIZE + 20], 0u);
+}
+
+
+TEST_F(PaintTest, HairlineStroker) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 128;
+    uint32_t buffer[2][SIZE * SIZE];
+    memset(buffer, 0, sizeof(buffer));
+
+    //The long dash takes the regular stroker
+    float pattern[] = {10000, 1};
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        ASSERT_EQ(swCanvas->target(buffer[i], SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+        for (auto width : {1.0f, 0.6f}) {
+            auto y = (width == 1.0f) ? 0.0f : 64.0f;
+
+            //zigzag, curve and circle
+            auto shape = tvg::Shape::gen();
+            ASSERT_EQ(shape->moveTo(4, 4 + y), tvg::Result::Success);
+            for (uint32_t k = 1; k < 8; ++k) {
+                ASSERT_EQ(shape->lineTo(4 + k * 8, (k % 2 ? 28 : 4) + y), tvg::Result::Success);
+            }
+            ASSERT_EQ(shape->moveTo(4, 58 + y), tvg::Result::Success);
+            ASSERT_EQ(shape->cubicTo(40, 30 + y, 80, 70 + y, 124, 42 + y), tvg::Result::Success);
+            ASSERT_EQ(shape->appendCircle(100, 16 + y, 12, 12), tvg::Result::Success);
+            ASSERT_EQ(shape->stroke(width), tvg::Result::Success);
+            ASSERT_EQ(shape->stroke(255, 255, 255, 255), tvg::Result::Success);
+            ASSERT_EQ(shape->stroke(tvg::StrokeCap::Butt), tvg::Result::Success);
+            if (i == 1) {
+                ASSERT_EQ(shape->stroke(pattern, 2), tvg::Result::Success);
+            }
+            ASSERT_EQ(swCanvas->push(move(shape)), tvg::Result::Success);
+        }
+        ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->clear(), tvg::Result::Success);
+    }
+
+    //The joints and the caps differ a bit, no pixel is far off
+    uint32_t painted = 0, total = 0;
+    for (uint32_t p = 0; p < SIZE * SIZE; ++p) {
+        auto a = buffer[0][p] >> 24;
+        auto b = buffer[1][p] >> 24;
+        auto diff = a > b ? a - b : b - a;
+        ASSERT_LE(diff, 32u);
+        if (b) ++painted;
+        total += diff;
+    }
+    ASSERT_GT(painted, 1000u);
+    ASSERT_LE(total, painted * 8);
+}
+
+
+TEST_F(PaintTest, DashOffset) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t SIZE = 64;
+    uint32_t buffer[SIZE * SIZE];
+    memset(buffer, 0, sizeof(buffer));
+
+    ASSERT_EQ(swCanvas->target(buffer, SIZE, SIZE, SIZE, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    float pattern[] = {8, 8};
+    auto shape = tvg::Shape::gen();
+    auto pShape = shape.get();
+    ASSERT_EQ(shape->moveTo(0, 10), tvg::Result::Success);
+    ASSERT_EQ(shape->lineTo(64, 10), tvg::Result::Success);
+    ASSERT_EQ(shape->stroke(4), tvg::Result::Success);
+    ASSERT_EQ(shape->stroke(255, 255, 255, 255), tvg::Result::Success);
+    ASSERT_EQ(shape->stroke(tvg::StrokeCap::Butt), tvg::Result::Success);
+    ASSERT_EQ(shape->stroke(pattern, 2), tvg::Result::Success);
+    ASSERT_EQ(shape->strokeDashOffset(), 0.0f);
+    ASSERT_EQ(swCanvas->push(move(shape)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    ASSERT_NE(buffer[10 * SIZE + 2], 0u);
+    ASSERT_EQ(buffer[10 * SIZE + 10], 0u);
+    ASSERT_NE(buffer[10 * SIZE + 18], 0u);
+
+    //The pattern is moved along the path
+    ASSERT_EQ(pShape->stroke(pattern, 2, 4), tvg::Result::Success);
+    ASSERT_EQ(pShape->strokeDashOffset(), 4.0f);
+    ASSERT_EQ(swCanvas->update(pShape), tvg::Result::Success);
+    memset(buffer, 0, sizeof(buffer));
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    ASSERT_NE(buffer[10 * SIZE + 2], 0u);
+    ASSERT_EQ(buffer[10 * SIZE + 6], 0u);
+    ASSERT_NE(buffer[10 * SIZE + 14], 0u);
+    ASSERT_EQ(buffer[10 * SIZE + 22], 0u);
+}
+
+TEST_F(PaintTest, WideTarget) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    //Wider than the 16 bits coordinates
+    constexpr uint32_t W = 80000;
+    constexpr uint32_t H = 4;
+    std::vector<uint32_t> buffer(W * H, 0);
+
+    ASSERT_EQ(swCanvas->target(buffer.data(), W, W, H, tvg::SwCanvas::ARGB8888), tvg::Result::Success);
+
+    for (auto clipped : {false, true}) {
+        auto shape = tvg::Shape::gen();
+        ASSERT_EQ(shape->moveTo(1000, 0), tvg::Result::Success);
+        ASSERT_EQ(shape->lineTo(79000, 0), tvg::Result::Success);
+        ASSERT_EQ(shape->lineTo(79400, 4), tvg::Result::Success);
+        ASSERT_EQ(shape->lineTo(1000, 4), tvg::Result::Success);
+        ASSERT_EQ(shape->close(), tvg::Result::Success);
+        ASSERT_EQ(shape->fill(255, 255, 255, 255), tvg::Result::Success);
+
+        //Clipped far from the origin
+        if (clipped) {
+            auto clip = tvg::Shape::gen();
+            ASSERT_EQ(clip->appendRect(40000, 1, 40000, 2, 0, 0), tvg::Result::Success);
+            ASSERT_EQ(clip->fill(255, 255, 255, 255), tvg::Result::Success);
+            ASSERT_EQ(shape->composite(move(clip), tvg::CompositeMethod::ClipPath), tvg::Result::Success);
+        }
+
+        std::fill(buffer.begin(), buffer.end(), 0);
+        ASSERT_EQ(swCanvas->clear(), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->push(move(shape)), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+        ASSERT_EQ(buffer[2 * W + 500], 0u);
+        ASSERT_EQ(buffer[2 * W + 1500] != 0, !clipped);
+        ASSERT_NE(buffer[2 * W + 70000], 0u);
+        ASSERT_EQ(buffer[2 * W + 79300], 0u);
+        ASSERT_EQ(buffer[0 * W + 70000] != 0, !clipped);
+    }
+}
@@ -0,0 +1,493 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <thorvg.h>
+
+class PictureTest : public ::testing::Test {
+public:
+    void SetUp() {
+        auto threads = std::thread::hardware_concurrency();
+        //Initialize ThorVG Engine
+        if (tvg::Initializer::init(tvgEngine, threads) == tvg::Result::Success) {
+            swCanvas = tvg::SwCanvas::gen();
+            swCanvas->target(buffer, WIDTH, WIDTH, HEIGHT, tvg::SwCanvas::ARGB8888);
+        }
+    }
+    void TearDown() {
+        swCanvas = nullptr;
+
+        //Terminate ThorVG Engine
+        tvg::Initializer::term(tvgEngine);
+    }
+
+    //Loads, builds and rasterizes the given svg.
+    bool render(const std::string& svg) {
+        auto picture = tvg::Picture::gen();
+        if (picture->load(svg.data(), svg.size()) != tvg::Result::Success) return false;
+        if (swCanvas->push(std::move(picture)) != tvg::Result::Success) return false;
+        if (swCanvas->draw() != tvg::Result::Success) return false;
+        if (swCanvas->sync() != tvg::Result::Success) return false;
+        swCanvas->clear();
+        return true;
+    }
+
+    //Color of the gradient referred by the i-th <rect>.
+    static uint32_t useColor(int i) {
+        return 0xff000000 | ((i & 0xff) << 16) | ((i >> 8) << 8) | 0x80;
+    }
+
+    //Every <use> refers to its own one pixel <rect> & gradient, half of them before the definitions.
+    static std::string manyUses(int count) {
+        std::string svg = "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" viewBox=\"0 0 100 100\">";
+        for (int i = 0; i < count / 2; ++i) {
+            svg += "<use xlink:href=\"#r" + std::to_string(i) + "\"/>";
+        }
+        svg += "<defs>";
+        for (int i = 0; i < count; ++i) {
+            auto id = std::to_string(i);
+            char color[8];
+            snprintf(color, sizeof(color), "#%06x", useColor(i) & 0xffffff);
+            svg += "<linearGradient id=\"g" + id + "\"><stop offset=\"0\" stop-color=\"" + color + "\"/><stop offset=\"1\" stop-color=\"" + color + "\"/></linearGradient>";
+            svg += "<rect id=\"r" + id + "\" x=\"" + std::to_string(i % WIDTH) + "\" y=\"" + std::to_string(i / WIDTH) + "\" width=\"1\" height=\"1\" fill=\"url(#g" + id + ")\"/>";
+        }
+        svg += "</defs>";
+        for (int i = count / 2; i < count; ++i) {
+            svg += "<use xlink:href=\"#r" + std::to_string(i) + "\"/>";
+        }
+        svg += "</svg>";
+        return svg;
+    }
+
+public:
+    static constexpr uint32_t WIDTH = 100;
+    static constexpr uint32_t HEIGHT = 100;
+    uint32_t buffer[WIDTH * HEIGHT];
+    std::unique_ptr<tvg::SwCanvas> swCanvas;
+    tvg::CanvasEngine tvgEngine = tvg::CanvasEngine::Sw;
+};
+
+TEST_F(PictureTest, UseForwardReference) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    std::string svg = "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" viewBox=\"0 0 100 100\">"
+                      "<use xlink:href=\"#later\"/>"
+                      "<defs><rect id=\"later\" x=\"10\" y=\"10\" width=\"20\" height=\"20\" fill=\"#ffffff\"/></defs>"
+                      "</svg>";
+
+    memset(buffer, 0, sizeof(buffer));
+    ASSERT_TRUE(render(svg));
+    ASSERT_NE(buffer[20 * WIDTH + 20], 0u);
+    ASSERT_EQ(buffer[50 * WIDTH + 50], 0u);
+}
+
+TEST_F(PictureTest, UseManyReferences) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    //Every <use> and gradient reference must resolve to its own definition.
+    const int count = 4000;
+    memset(buffer, 0, sizeof(buffer));
+    ASSERT_TRUE(render(manyUses(count)));
+
+    auto near = [](uint32_t a, uint32_t b) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            if (abs(int((a >> shift) & 0xff) - int((b >> shift) & 0xff)) > 1) return false;
+        }
+        return true;
+    };
+
+    for (int i = 0; i < count; ++i) {
+        ASSERT_TRUE(near(buffer[i], useColor(i))) << "reference " << i;
+    }
+    ASSERT_EQ(buffer[count], 0u);
+}
+
+TEST_F(PictureTest, SaveAndLoadBinary) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    auto build = []() {
+        auto scene = tvg::Scene::gen();
+
+        auto shape = tvg::Shape::gen();
+        shape->appendRect(10, 10, 60, 40, 5, 5);
+        shape->stroke(4);
+        shape->stroke(0, 0, 255, 255);
+        tvg::Fill::ColorStop stops[2] = {{0, 255, 0, 0, 255}, {1, 0, 255, 0, 128}};
+        auto fill = tvg::LinearGradient::gen();
+        fill->linear(10, 10, 70, 50);
+        fill->colorStops(stops, 2);
+        shape->fill(move(fill));
+        scene->push(move(shape));
+
+        auto circle = tvg::Shape::gen();
+        circle->appendCircle(60, 60, 25, 25);
+        circle->fill(255, 255, 0, 255);
+        circle->opacity(200);
+        scene->push(move(circle));
+
+        auto masked = tvg::Shape::gen();
+        masked->appendRect(0, 60, 100, 40, 0, 0);
+        masked->fill(0, 128, 255, 255);
+        auto mask = tvg::Shape::gen();
+        mask->appendCircle(30, 80, 15, 15);
+        mask->fill(0, 0, 0, 255);
+        masked->composite(move(mask), tvg::CompositeMethod::InvAlphaMask);
+        scene->push(move(masked));
+
+        auto focused = tvg::Shape::gen();
+        focused->appendRect(70, 0, 30, 60, 0, 0);
+        auto radial = tvg::RadialGradient::gen();
+        radial->radial(85, 30, 15);
+        radial->focal(78, 22);
+        radial->colorStops(stops, 2);
+        focused->fill(move(radial));
+        scene->push(move(focused));
+
+        float pattern[] = {6, 6};
+        auto dashed = tvg::Shape::gen();
+        dashed->moveTo(0, 4);
+        dashed->lineTo(100, 4);
+        dashed->stroke(3);
+        dashed->stroke(255, 0, 255, 255);
+        dashed->stroke(pattern, 2, 3);
+        scene->push(move(dashed));
+
+        return scene;
+    };
+
+    uint32_t expected[WIDTH * HEIGHT];
+    memset(buffer, 0, sizeof(buffer));
+    ASSERT_EQ(swCanvas->push(build()), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    swCanvas->clear();
+    memcpy(expected, buffer, sizeof(buffer));
+
+    auto path = "test_picture.tvg";
+    auto saver = tvg::Saver::gen();
+    ASSERT_EQ(saver->save(build(), path), tvg::Result::Success);
+
+    auto picture = tvg::Picture::gen();
+    ASSERT_EQ(picture->load(path), tvg::Result::Success);
+    std::remove(path);
+
+    memset(buffer, 0, sizeof(buffer));
+    ASSERT_EQ(swCanvas->push(move(picture)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    swCanvas->clear();
+
+    ASSERT_EQ(memcmp(expected, buffer, sizeof(buffer)), 0);
+}
+
+TEST_F(PictureTest, SharedCache) {
+    ASSERT_TRUE(swCanvas != nullptr);
+    ASSERT_EQ(tvg::Initializer::cacheSize(64 * 1024 * 1024), tvg::Result::Success);
+
+    uint32_t hits, misses, cnt;
+    uint32_t expected[WIDTH * HEIGHT];
+
+    for (int i = 0; i < 3; ++i) {
+        auto picture = tvg::Picture::gen();
+        ASSERT_EQ(picture->load(EXAMPLE_DIR"/tiger.svg"), tvg::Result::Success);
+
+        float w, h;
+        ASSERT_EQ(picture->viewbox(nullptr, nullptr, &w, &h), tvg::Result::Success);
+        tvg::Matrix m = {WIDTH / w, 0, 0, 0, HEIGHT / h, 0, 0, 0, 1};
+        picture->transform(m);
+
+        memset(buffer, 0, sizeof(buffer));
+        ASSERT_EQ(swCanvas->push(move(picture)), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+        swCanvas->clear();
+
+        //Every copy must look the same as the parsed one.
+        if (i == 0) memcpy(expected, buffer, sizeof(buffer));
+        else ASSERT_EQ(memcmp(expected, buffer, sizeof(buffer)), 0);
+    }
+
+    ASSERT_EQ(tvg::Initializer::cacheStats(&hits, &misses, &cnt), tvg::Result::Success);
+    ASSERT_EQ(hits, 2u);
+    ASSERT_EQ(misses, 1u);
+    ASSERT_EQ(cnt, 1u);
+
+    //Files never drawn are accounted by their file size.
+    auto picture = tvg::Picture::gen();
+    ASSERT_EQ(picture->load(EXAMPLE_DIR"/logo.svg"), tvg::Result::Success);
+    picture = tvg::Picture::gen();
+    ASSERT_EQ(picture->load(EXAMPLE_DIR"/duke.svg"), tvg::Result::Success);
+    picture = nullptr;
+    ASSERT_EQ(tvg::Initializer::cacheStats(nullptr, &misses, &cnt), tvg::Result::Success);
+    ASSERT_EQ(misses, 3u);
+    ASSERT_EQ(cnt, 3u);
+
+    //Least recently used one goes away once the budget is exceeded
+    struct stat logo, duke;
+    ASSERT_EQ(stat(EXAMPLE_DIR"/logo.svg", &logo), 0);
+    ASSERT_EQ(stat(EXAMPLE_DIR"/duke.svg", &duke), 0);
+    ASSERT_EQ(tvg::Initializer::cacheSize(logo.st_size + duke.st_size), tvg::Result::Success);
+    ASSERT_EQ(tvg::Initializer::cacheStats(nullptr, nullptr, &cnt), tvg::Result::Success);
+    ASSERT_EQ(cnt, 2u);
+
+    ASSERT_EQ(tvg::Initializer::cacheSize(0), tvg::Result::Success);
+    ASSERT_EQ(tvg::Initializer::cacheStats(nullptr, nullptr, &cnt), tvg::Result::Success);
+    ASSERT_EQ(cnt, 0u);
+}
+
+TEST_F(PictureTest, SharedCacheModified) {
+    ASSERT_TRUE(swCanvas != nullptr);
+    ASSERT_EQ(tvg::Initializer::cacheSize(1024 * 1024), tvg::Result::Success);
+
+    const char* path = "test_picture_cache.svg";
+    const char* svgs[] = {
+        "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"0 0 100 100\"><rect width=\"10\" height=\"10\" fill=\"#ff0000\"/></svg>",
+        "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"0 0 100 100\"><rect width=\"10\" height=\"10\" fill=\"#0000ff\"/></svg>"
+    };
+    uint32_t misses;
+
+    //Rewritten with the same size in the same second
+    for (int i = 0; i < 2; ++i) {
+        auto f = fopen(path, "wb");
+        ASSERT_TRUE(f != nullptr);
+        fputs(svgs[i], f);
+        fclose(f);
+        struct timespec times[2] = {{1000000000, 0}, {1000000000, i * 500000000L}};
+        ASSERT_EQ(utimensat(AT_FDCWD, path, times, 0), 0);
+
+        auto picture = tvg::Picture::gen();
+        ASSERT_EQ(picture->load(path), tvg::Result::Success);
+        memset(buffer, 0, sizeof(buffer));
+        ASSERT_EQ(swCanvas->push(move(picture)), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+        ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+        swCanvas->clear();
+        ASSERT_EQ(buffer[5 * WIDTH + 5] & 0x00ffffff, i == 0 ? 0x00fe0000u : 0x000000feu);
+    }
+    remove(path);
+
+    ASSERT_EQ(tvg::Initializer::cacheStats(nullptr, &misses, nullptr), tvg::Result::Success);
+    ASSERT_EQ(misses, 2u);
+    ASSERT_EQ(tvg::Initializer::cacheSize(0), tvg::Result::Success);
+}
+
+TEST_F(PictureTest, ImageFilter) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    //1px checkerboard of opaque black & white
+    constexpr uint32_t SIZE = 400;
+    static uint32_t image[SIZE * SIZE];
+    for (uint32_t y = 0; y < SIZE; ++y) {
+        for (uint32_t x = 0; x < SIZE; ++x) {
+            image[y * SIZE + x] = ((x + y) % 2) ? 0xffffffff : 0xff000000;
+        }
+    }
+
+    //Returns the largest deviation from the mid gray in the downscaled image.
+    auto deviation = [&](tvg::FilterMethod method) {
+        auto picture = tvg::Picture::gen();
+        if (picture->load(image, SIZE, SIZE, false) != tvg::Result::Success) return -1;
+        if (picture->filter(method) != tvg::Result::Success) return -1;
+        if (picture->filter() != method) return -1;
+        picture->scale(0.23f);
+
+        memset(buffer, 0, sizeof(buffer));
+        swCanvas->push(move(picture));
+        swCanvas->draw();
+        swCanvas->sync();
+        swCanvas->clear();
+
+        int maxDiff = 0;
+        for (uint32_t y = 10; y < 80; ++y) {
+            for (uint32_t x = 10; x < 80; ++x) {
+                auto diff = abs(static_cast<int>(buffer[y * WIDTH + x] & 0xff) - 127);
+                if (diff > maxDiff) maxDiff = diff;
+            }
+        }
+        return maxDiff;
+    };
+
+    //Nearest picks either black or white
+    ASSERT_GT(deviation(tvg::FilterMethod::Nearest), 100);
+    //The box filtered level averages them out
+    auto mipmap = deviation(tvg::FilterMethod::Mipmap);
+    ASSERT_GE(mipmap, 0);
+    ASSERT_LT(mipmap, 8);
+
+    //Black & white columns magnified 8 times, bilinear ramps up between the pixel centers.
+    static uint32_t columns[4] = {0xff000000, 0xffffffff, 0xff000000, 0xffffffff};
+    auto picture = tvg::Picture::gen();
+    ASSERT_EQ(picture->load(columns, 2, 2, false), tvg::Result::Success);
+    ASSERT_EQ(picture->filter(tvg::FilterMethod::Bilinear), tvg::Result::Success);
+    picture->scale(8);
+
+    memset(buffer, 0, sizeof(buffer));
+    ASSERT_EQ(swCanvas->push(move(picture)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    swCanvas->clear();
+
+    //Pixels are sampled where the nearest filter hits the image, columns 12~15 round outside of it.
+    uint32_t expected[12] = {0xff000000, 0xff1f1f1f, 0xff3f3f3f, 0xff5f5f5f, 0xff7f7f7f, 0xff9f9f9f, 0xffbfbfbf, 0xffdfdfdf,
+                             0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff};
+    for (int y = 0; y < 12; ++y) {
+        for (int x = 0; x < 12; ++x) {
+            ASSERT_EQ(buffer[y * WIDTH + x], expected[x]) << x << ", " << y;
+        }
+    }
+}
+
+TEST_F(PictureTest, ImageNearest) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    //3x2 texels magnified 4 times & turned by 90 degrees, it covers (14, 9) ~ (22, 21).
+    static uint32_t texels[6] = {0xffff0000, 0xff00ff00, 0xff0000ff, 0xffffff00, 0xff00ffff, 0xffff00ff};
+    auto picture = tvg::Picture::gen();
+    ASSERT_EQ(picture->load(texels, 3, 2, false), tvg::Result::Success);
+    ASSERT_EQ(picture->filter(), tvg::FilterMethod::Nearest);
+    picture->scale(4);
+    picture->rotate(90);
+    picture->translate(20, 10);
+
+    memset(buffer, 0, sizeof(buffer));
+    ASSERT_EQ(swCanvas->push(move(picture)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    swCanvas->clear();
+
+    //Every texel fills its own 4x4 block, the image rows run from the right to the left.
+    for (int u = 0; u < 3; ++u) {
+        for (int v = 0; v < 2; ++v) {
+            auto texel = texels[v * 3 + u];
+            auto bx = 18 - v * 4;
+            auto by = 9 + u * 4;
+            for (int y = by + 1; y < by + 3; ++y) {
+                for (int x = bx + 1; x < bx + 3; ++x) {
+                    ASSERT_EQ(buffer[y * WIDTH + x], texel) << x << ", " << y;
+                }
+            }
+        }
+    }
+
+    //Nothing is blended, nothing is drawn outside of it.
+    for (uint32_t y = 0; y < HEIGHT; ++y) {
+        for (uint32_t x = 0; x < WIDTH; ++x) {
+            auto pixel = buffer[y * WIDTH + x];
+            if (x < 14 || x >= 22 || y < 9 || y >= 21) {
+                ASSERT_EQ(pixel, 0u) << x << ", " << y;
+            } else if (pixel != 0) {
+                ASSERT_NE(std::find(texels, texels + 6, pixel), texels + 6) << x << ", " << y;
+            }
+        }
+    }
+}
+
+TEST_F(PictureTest, ImageStride) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    //A 40x30 window at (7, 5) of a larger buffer
+    constexpr uint32_t STRIDE = 64;
+    constexpr uint32_t W = 40, H = 30;
+    static uint32_t large[STRIDE * 48];
+    static uint32_t packed[W * H];
+    for (uint32_t y = 0; y < 48; ++y) {
+        for (uint32_t x = 0; x < STRIDE; ++x) {
+            large[y * STRIDE + x] = 0xff000000 | (x * 4 << 16) | (y * 5 << 8) | ((x + y) & 0xff);
+        }
+    }
+    auto window = large + 5 * STRIDE + 7;
+    for (uint32_t y = 0; y < H; ++y) {
+        memcpy(packed + y * W, window + y * STRIDE, W * sizeof(uint32_t));
+    }
+
+    auto draw = [&](uint32_t* data, uint32_t stride) {
+        auto picture = tvg::Picture::gen();
+        if (picture->load(data, W, H, stride, false) != tvg::Result::Success) return false;
+        picture->translate(3, 2);
+        picture->rotate(10);
+        memset(buffer, 0, sizeof(buffer));
+        swCanvas->push(move(picture));
+        swCanvas->draw();
+        swCanvas->sync();
+        swCanvas->clear();
+        return true;
+    };
+
+    uint32_t expected[WIDTH * HEIGHT];
+    ASSERT_TRUE(draw(packed, W));
+    memcpy(expected, buffer, sizeof(buffer));
+    ASSERT_TRUE(draw(window, STRIDE));
+    ASSERT_EQ(memcmp(expected, buffer, sizeof(buffer)), 0);
+
+    auto picture = tvg::Picture::gen();
+    ASSERT_EQ(picture->load(window, W, H, W - 1, false), tvg::Result::InvalidArguments);
+    ASSERT_EQ(picture->invalidate(), tvg::Result::InsufficientCondition);
+
+    //Modify the pixels in place
+    ASSERT_EQ(picture->load(window, W, H, STRIDE, false), tvg::Result::Success);
+    auto p = picture.get();
+    ASSERT_EQ(swCanvas->push(move(picture)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(buffer[10 * WIDTH + 10], window[10 * STRIDE + 10]);
+
+    window[10 * STRIDE + 10] = 0xff123456;
+    ASSERT_EQ(p->invalidate(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->update(p), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(buffer[10 * WIDTH + 10], 0xff123456);
+    swCanvas->clear();
+}
+
+TEST_F(PictureTest, OpaqueImage) {
+    ASSERT_TRUE(swCanvas != nullptr);
+
+    constexpr uint32_t W = 50, H = 40;
+    static uint32_t image[W * H];
+    for (uint32_t i = 0; i < W * H; ++i) image[i] = 0xff000000 | (i * 2654435761u >> 8);
+
+    //Under a half pixel off, the nearest samples are the same pixels.
+    auto draw = [&](float x, float y) {
+        auto picture = tvg::Picture::gen();
+        if (picture->load(image, W, H, false) != tvg::Result::Success) return false;
+        picture->translate(x, y);
+        memset(buffer, 0, sizeof(buffer));
+        swCanvas->push(move(picture));
+        swCanvas->draw();
+        swCanvas->sync();
+        swCanvas->clear();
+        return true;
+    };
+
+    uint32_t expected[WIDTH * HEIGHT];
+    ASSERT_TRUE(draw(13.25f, 7.25f));
+    memcpy(expected, buffer, sizeof(buffer));
+    ASSERT_TRUE(draw(13, 7));
+    ASSERT_EQ(memcmp(expected, buffer, sizeof(buffer)), 0);
+    ASSERT_EQ(buffer[7 * WIDTH + 13], image[0]);
+
+    //A translucent pixel turns the copy into the blending again.
+    auto picture = tvg::Picture::gen();
+    ASSERT_EQ(picture->load(image, W, H, false), tvg::Result::Success);
+    ASSERT_EQ(picture->translate(13, 7), tvg::Result::Success);
+    ASSERT_EQ(picture->opacity(255), tvg::Result::Success);
+
+    auto p = picture.get();
+    ASSERT_EQ(swCanvas->push(move(picture)), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+
+    image[0] = 0;
+    ASSERT_EQ(p->invalidate(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->update(p), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->draw(), tvg::Result::Success);
+    ASSERT_EQ(swCanvas->sync(), tvg::Result::Success);
+    ASSERT_EQ(buffer[7 * WIDTH + 13], 0u);
+    ASSERT_EQ(buffer[7 * WIDTH + 14], image[1]);
+    swCanvas->clear();
+}